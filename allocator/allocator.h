@@ -2,66 +2,148 @@
 #define B4E8B570_191E_40E7_BFB3_10EB1EAE4545
 
 #include <stdlib.h>
+#include <stdbool.h>
 #include "mem_alloc.h"
+#include "../header/strix_allocator.h"
 
-typedef void *(*allocator_t)(size_t size);
-typedef void (*deallocator_t)(void *ptr);
+/*
+ * Everything strix allocates goes through allocate/deallocate/reallocate below. They pick, in
+ * order: the innermost scope of the thread, the allocator the thread installed with
+ * strix_allocator_set, and the build default (heap_alloc with CUSTOM_ALLOCATOR, malloc otherwise),
+ * which is called directly. All the state is thread-local and defined in source/strix_allocator.c.
+ */
 
-void change_allocator_to_default();
-void change_allocator_to_custom();
+/*
+ * A scope temporarily takes over allocate/deallocate/reallocate for the calling thread only, e.g.
+ * a strix_arena_t for the duration of a request. New memory comes from the innermost scope. Memory
+ * a scope owns is never freed one block at a time, and it is resized by the scope that owns it.
+ * Everything else still goes to the allocator of the thread.
+ */
+typedef struct allocator_scope
+{
+    void *(*allocate)(struct allocator_scope *scope, size_t size);
+    void *(*reallocate)(struct allocator_scope *scope, void *ptr, size_t size); // ptr is owned by this scope
+    bool (*owns)(const struct allocator_scope *scope, const void *ptr);
+    struct allocator_scope *outer;
+} allocator_scope_t;
+
+extern _Thread_local allocator_scope_t *allocator_scope;          // innermost scope of this thread, NULL outside of any
+extern _Thread_local const strix_allocator_t *allocator_installed; // set by strix_allocator_set, NULL for the build default
 
-void *default_allocator(size_t size);
-void default_deallocator(void *ptr);
-void *custom_allocator(size_t size);
-void custom_deallocator(void *ptr);
+void allocator_scope_push(allocator_scope_t *scope);
+void allocator_scope_pop(allocator_scope_t *scope);
 
-extern allocator_t allocate;
-extern deallocator_t deallocate;
+static inline allocator_scope_t *allocator_scope_owner(const void *ptr)
+{
+    for (allocator_scope_t *scope = allocator_scope; scope; scope = scope->outer)
+    {
+        if (scope->owns(scope, ptr))
+        {
+            return scope;
+        }
+    }
+    return NULL;
+}
 
-allocator_t allocate =
-#ifndef CUSTOM_ALLOCATOR
-    default_allocator;
+// allocator is one strix_allocator_get could have returned, NULL for the build default; structures that
+// outlive a call and may be grown or freed on other threads record the one of their creator
+static inline void *allocate_with(const strix_allocator_t *allocator, size_t size)
+{
+    if (allocator)
+    {
+        return allocator->alloc(allocator->user_data, size);
+    }
+#ifdef CUSTOM_ALLOCATOR
+    return heap_alloc(size, ALIGN_DEFAULT);
 #else
-    custom_allocator;
+    return malloc(size);
 #endif
+}
 
-deallocator_t deallocate =
-#ifndef CUSTOM_ALLOCATOR
-    default_deallocator;
+static inline void deallocate_with(const strix_allocator_t *allocator, void *ptr)
+{
+    if (allocator)
+    {
+        if (ptr)
+        {
+            allocator->free(allocator->user_data, ptr);
+        }
+        return;
+    }
+#ifdef CUSTOM_ALLOCATOR
+    heap_free(ptr);
 #else
-    custom_deallocator;
+    free(ptr);
 #endif
+}
 
-void *default_allocator(size_t size)
+static inline void *unscoped_allocate(size_t size)
 {
-    return malloc(size);
+    return allocate_with(allocator_installed, size);
 }
 
-void default_deallocator(void *ptr)
+static inline void unscoped_deallocate(void *ptr)
 {
-    free(ptr);
+    deallocate_with(allocator_installed, ptr);
 }
 
-void *custom_allocator(size_t size)
+static inline void *unscoped_reallocate(void *ptr, size_t size)
 {
-    return heap_alloc(size, ALIGN_DEFAULT);
+    const strix_allocator_t *allocator = allocator_installed;
+    if (allocator)
+    {
+        return allocator->realloc(allocator->user_data, ptr, size);
+    }
+#ifdef CUSTOM_ALLOCATOR
+    return heap_realloc(ptr, size, ALIGN_DEFAULT);
+#else
+    return realloc(ptr, size);
+#endif
 }
 
-void custom_deallocator(void *ptr)
+static inline void *allocate(size_t size)
 {
-    heap_free(ptr);
+    if (allocator_scope)
+    {
+        return allocator_scope->allocate(allocator_scope, size);
+    }
+    return unscoped_allocate(size);
 }
 
-void change_allocator_to_default()
+static inline void deallocate(void *ptr)
 {
-    allocate = default_allocator;
-    deallocate = default_deallocator;
+    // scoped memory is only released with its scope
+    if (allocator_scope && ptr && allocator_scope_owner(ptr))
+    {
+        return;
+    }
+    unscoped_deallocate(ptr);
 }
 
-void change_allocator_to_custom()
+// memory that belongs with owner: from the scope that owns owner, or from the allocator of the thread
+static inline void *allocate_beside(const void *owner, size_t size)
 {
-    allocate = custom_allocator;
-    deallocate = custom_deallocator;
+    allocator_scope_t *scope = allocator_scope ? allocator_scope_owner(owner) : NULL;
+    return scope ? scope->allocate(scope, size) : unscoped_allocate(size);
+}
+
+static inline void *reallocate(void *ptr, size_t size)
+{
+    if (allocator_scope)
+    {
+        if (!ptr)
+        {
+            return allocator_scope->allocate(allocator_scope, size);
+        }
+
+        // memory from before the scope keeps living with the allocator of the thread
+        allocator_scope_t *owner = allocator_scope_owner(ptr);
+        if (owner)
+        {
+            return owner->reallocate(owner, ptr, size);
+        }
+    }
+    return unscoped_reallocate(ptr, size);
 }
 
 #endif /* B4E8B570_191E_40E7_BFB3_10EB1EAE4545 */
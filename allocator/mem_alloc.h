@@ -1,13 +1,19 @@
 #ifndef MEM_ALLOC_H
 #define MEM_ALLOC_H
 
+/*
+ * Only declarations unless MEM_IMPLEMENTATION is defined before the include, which exactly one
+ * translation unit of the program does (source/strix_allocator.c for strix). The conservative
+ * collector of the segmented allocator is built in unless NO_GC_COLLECT is defined.
+ */
+
 #ifdef INLINE_ALLOCATOR
-#define MEM_IMPLEMENTATION
 #include "src/allocator_implementations/inline_allocator.h"
 
 #else
-#define MEM_IMPLEMENTATION
+#ifndef NO_GC_COLLECT
 #define GC_COLLECT
+#endif
 #include "src/allocator_implementations/segmented_allocator.h"
 #endif
 
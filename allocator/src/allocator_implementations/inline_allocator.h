@@ -11,13 +11,22 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
-#include "../checksum_implementations/xxh32.h"
-#include "../checksum_implementations/crc32.h"
+#include "../heap_stats.h"
 
 /* Configuration */
 #define XXH32_SEED 0xFF32
 #define HEAP_CAPACITY (65536) // 64KB heap size
 #define SPLIT_THRESHOLD (16)
+#define CHUNK_SIZE_ALIGNMENT (8) // keeps every header 8 byte aligned
+#define FREE_LIST_COUNT (16)     // one list per power of two of the chunk size
+
+/*
+ * Header checksum: CRC32C by default (SSE4.2 / ARMv8 crc instructions when the
+ * CPU has them, a table otherwise), -DCRC32 for the table-driven IEEE CRC32,
+ * -DXXH32 for xxh32. -DVALIDATE_ON_FREE_ONLY keeps the checksums up to date but
+ * only checks them on pointers handed to heap_free/heap_realloc, headers met
+ * while searching and coalescing are trusted.
+ */
 
 /* Alignment options */
 typedef enum
@@ -26,12 +35,15 @@ typedef enum
     ALIGN_8 = 8,
     ALIGN_16 = 16,
     ALIGN_32 = 32,
+    ALIGN_DEFAULT = ALIGN_8,
     NO_ALIGNMENT = 0,
 } alignment_t;
 
 #define DEFAULT_ALIGNMENT (ALIGN_8)
 #define MAX_ALIGNMENT (ALIGN_32)
+#ifndef DEBUG_LOGGING
 #define DEBUG_LOGGING (1)
+#endif
 
 /* Public API declarations */
 bool heap_init(void);
@@ -43,6 +55,9 @@ void heap_get_stats(size_t *total_size, size_t *used_size,
 
 #ifdef MEM_IMPLEMENTATION
 
+#include "../checksum_implementations/xxh32.h"
+#include "../checksum_implementations/crc32.h"
+
 /* Internal structures */
 typedef struct __attribute__((packed))
 {
@@ -58,17 +73,39 @@ typedef struct __attribute__((packed))
 /* Static assertions */
 _Static_assert(sizeof(metadata_t) == MAX_ALIGNMENT,
                "Metadata size must match MAX_ALIGNMENT");
+_Static_assert(offsetof(metadata_t, checksum) + sizeof(uint32_t) < sizeof(metadata_t),
+               "The last metadata byte must stay outside the checksum, it doubles as the offset byte of unpadded data");
+_Static_assert(offsetof(metadata_t, checksum) == 2 * sizeof(uint64_t) + sizeof(uint16_t),
+               "The CRC32C header hash covers exactly two words and the two flag bytes");
+
+/* Free chunks are threaded into their size class list through their own payload */
+typedef struct
+{
+    metadata_t *next;
+    metadata_t *prev;
+} free_links_t;
+
+_Static_assert(sizeof(free_links_t) <= SPLIT_THRESHOLD,
+               "A split off chunk must be able to hold the free list links");
 
 /* Internal state */
 static uint8_t heap[HEAP_CAPACITY] __attribute__((aligned(MAX_ALIGNMENT))) = {0};
 static bool is_initialized = false;
 
+static metadata_t *free_lists[FREE_LIST_COUNT] = {0};
+static uint32_t free_list_bitmap = 0; // bit i is set while free_lists[i] is not empty
+static size_t free_bytes = 0;
+static size_t chunk_count = 0;
+static heap_stats_t heap_stats = {0}; // the counters that are not derived from the fields above
+
 /* Heap navigation macros */
 #define HEAP_START ((uint8_t *)heap)
 #define HEAP_END (HEAP_START + HEAP_CAPACITY)
 #define NEXT_CHUNK(ptr) ((uint8_t *)(ptr) + sizeof(metadata_t) + \
                          ((metadata_t *)(ptr))->chunk_size)
 #define CHUNK_DATA(ptr) ((uint8_t *)(ptr) + sizeof(metadata_t))
+#define BACK_OFFSET(data) (((uint8_t *)(data))[-1]) // alignment padding between CHUNK_DATA and the user pointer
+#define FREE_LINKS(ptr) ((free_links_t *)CHUNK_DATA(ptr))
 
 /* Alignment helper functions */
 static inline size_t align_up(size_t n, size_t align)
@@ -102,11 +139,16 @@ static inline bool is_within_heap(const void *ptr)
 
 static inline uint32_t calculate_chunk_checksum(const metadata_t *chunk)
 {
-    const size_t checksum_size = offsetof(metadata_t, checksum);
-#ifdef CRC32
-    return crc32((const uint8_t *)chunk, checksum_size);
+#if defined(CRC32)
+    return crc32((const uint8_t *)chunk, offsetof(metadata_t, checksum));
+#elif defined(XXH32)
+    return xxh32((const uint8_t *)chunk, offsetof(metadata_t, checksum), XXH32_SEED);
 #else
-    return xxh32((const uint8_t *)chunk, checksum_size, XXH32_SEED);
+    uint64_t words[2];
+    uint16_t flags;
+    memcpy(words, chunk, sizeof(words));
+    memcpy(&flags, (const uint8_t *)chunk + sizeof(words), sizeof(flags));
+    return crc32c_header(words[0], words[1], flags);
 #endif
 }
 
@@ -119,6 +161,65 @@ static bool validate_chunk(const metadata_t *chunk)
     return calculate_chunk_checksum(chunk) == chunk->checksum;
 }
 
+/* Validation of headers reached by walking the heap rather than handed in by the caller */
+static inline bool validate_internal_chunk(const metadata_t *chunk)
+{
+#ifdef VALIDATE_ON_FREE_ONLY
+    return chunk != NULL;
+#else
+    return validate_chunk(chunk);
+#endif
+}
+
+/* Free list management functions */
+static inline size_t free_list_index(size_t size)
+{
+    size_t index = (sizeof(unsigned long long) * 8 - 1) - __builtin_clzll(size | 1);
+    return index < FREE_LIST_COUNT ? index : FREE_LIST_COUNT - 1;
+}
+
+static void free_list_insert(metadata_t *chunk)
+{
+    size_t index = free_list_index(chunk->chunk_size);
+    free_links_t *links = FREE_LINKS(chunk);
+
+    links->prev = NULL;
+    links->next = free_lists[index];
+    if (free_lists[index])
+    {
+        FREE_LINKS(free_lists[index])->prev = chunk;
+    }
+    free_lists[index] = chunk;
+
+    free_list_bitmap |= (uint32_t)1 << index;
+    free_bytes += chunk->chunk_size;
+}
+
+static void free_list_remove(metadata_t *chunk)
+{
+    size_t index = free_list_index(chunk->chunk_size);
+    free_links_t *links = FREE_LINKS(chunk);
+
+    if (links->prev)
+    {
+        FREE_LINKS(links->prev)->next = links->next;
+    }
+    else
+    {
+        free_lists[index] = links->next;
+    }
+    if (links->next)
+    {
+        FREE_LINKS(links->next)->prev = links->prev;
+    }
+
+    if (!free_lists[index])
+    {
+        free_list_bitmap &= ~((uint32_t)1 << index);
+    }
+    free_bytes -= chunk->chunk_size;
+}
+
 /* Chunk management functions */
 static void create_free_chunk(metadata_t *chunk, size_t size, void *previous_chunk)
 {
@@ -129,40 +230,89 @@ static void create_free_chunk(metadata_t *chunk, size_t size, void *previous_chu
     chunk->checksum = calculate_chunk_checksum(chunk);
 }
 
+/* Points the chunk after this one back at it, so coalescing can walk in both directions */
+static void link_next_chunk(metadata_t *chunk)
+{
+    metadata_t *next = (metadata_t *)NEXT_CHUNK(chunk);
+    if (is_within_heap(next))
+    {
+        next->prev_chunk = chunk;
+        next->checksum = calculate_chunk_checksum(next);
+    }
+}
+
+/* Places the user pointer padding bytes into the chunk data and records the padding right before it */
+static void *place_chunk_data(metadata_t *chunk, size_t padding)
+{
+    uint8_t *data = CHUNK_DATA(chunk) + padding;
+    BACK_OFFSET(data) = (uint8_t)padding;
+    return data;
+}
+
 static metadata_t *find_chunk_for_pointer(void *ptr)
 {
-    if (!ptr || !is_within_heap(ptr))
+    if (!ptr || !is_within_heap(ptr) || (uint8_t *)ptr < HEAP_START + sizeof(metadata_t))
     {
         return NULL;
     }
 
-    metadata_t *metadata = (metadata_t *)((uint8_t *)ptr - sizeof(metadata_t));
-    while ((uint8_t *)metadata >= HEAP_START)
+    uint8_t padding = BACK_OFFSET(ptr);
+    if (padding >= MAX_ALIGNMENT)
     {
-        if (validate_chunk(metadata) && metadata->is_allocated &&
-            CHUNK_DATA(metadata) == ptr)
-        {
-            return metadata;
-        }
-        metadata = (metadata_t *)((uint8_t *)metadata - 1);
+        return NULL;
     }
-    return NULL;
+
+    metadata_t *metadata = (metadata_t *)((uint8_t *)ptr - padding - sizeof(metadata_t));
+    if ((uint8_t *)metadata < HEAP_START || !validate_chunk(metadata) || !metadata->is_allocated)
+    {
+        return NULL;
+    }
+    return metadata;
 }
 
+/* Absorbs the next chunk if it is free, the caller owns chunk and keeps it off the free lists */
 static bool try_coalesce_with_next(metadata_t *chunk)
 {
     metadata_t *next = (metadata_t *)NEXT_CHUNK(chunk);
-    if (is_within_heap(next) && validate_chunk(next) && !next->is_allocated)
+    if (is_within_heap(next) && validate_internal_chunk(next) && !next->is_allocated)
     {
+        free_list_remove(next);
         chunk->chunk_size += sizeof(metadata_t) + next->chunk_size;
         chunk->checksum = calculate_chunk_checksum(chunk);
+        link_next_chunk(chunk);
+        chunk_count--;
+        heap_stats.coalesces++;
         return true;
     }
     return false;
 }
 
+/* Lets a free previous chunk absorb this one, returns the chunk that now covers it */
+static metadata_t *try_coalesce_with_prev(metadata_t *chunk)
+{
+    metadata_t *prev = (metadata_t *)chunk->prev_chunk;
+    if (prev && validate_internal_chunk(prev) && !prev->is_allocated)
+    {
+        free_list_remove(prev);
+        prev->chunk_size += sizeof(metadata_t) + chunk->chunk_size;
+        prev->checksum = calculate_chunk_checksum(prev);
+        link_next_chunk(prev);
+        chunk_count--;
+        heap_stats.coalesces++;
+        return prev;
+    }
+    return chunk;
+}
+
 static void *split_chunk_if_possible(metadata_t *chunk, size_t required_size)
 {
+    required_size = align_up(required_size < sizeof(free_links_t) ? sizeof(free_links_t) : required_size,
+                             CHUNK_SIZE_ALIGNMENT);
+    if (chunk->chunk_size < required_size)
+    {
+        return CHUNK_DATA(chunk);
+    }
+
     size_t remaining = chunk->chunk_size - required_size;
     if (remaining >= sizeof(metadata_t) + SPLIT_THRESHOLD)
     {
@@ -171,10 +321,101 @@ static void *split_chunk_if_possible(metadata_t *chunk, size_t required_size)
         create_free_chunk(split_chunk, remaining - sizeof(metadata_t), chunk);
         chunk->chunk_size = required_size;
         chunk->checksum = calculate_chunk_checksum(chunk);
+        chunk_count++;
+
+        link_next_chunk(split_chunk);
+        try_coalesce_with_next(split_chunk);
+        free_list_insert(split_chunk);
     }
     return CHUNK_DATA(chunk);
 }
 
+/* Padding needed in front of the chunk data to satisfy the alignment */
+static inline size_t chunk_padding(const metadata_t *chunk, alignment_t alignment)
+{
+    if (chunk->current_alignment >= alignment)
+    {
+        return 0;
+    }
+    return (uint8_t *)align_ptr(CHUNK_DATA(chunk), alignment) - CHUNK_DATA(chunk);
+}
+
+/* First fit within the size class of the request, then the first fit of every larger class */
+static metadata_t *find_free_chunk(size_t size, alignment_t alignment, size_t *padding)
+{
+    uint32_t candidates = free_list_bitmap & (~(uint32_t)0 << free_list_index(size));
+    while (candidates)
+    {
+        size_t index = (size_t)__builtin_ctz(candidates);
+        candidates &= candidates - 1;
+
+        for (metadata_t *chunk = free_lists[index]; chunk; chunk = FREE_LINKS(chunk)->next)
+        {
+            if (!validate_internal_chunk(chunk))
+            {
+                if (DEBUG_LOGGING)
+                {
+                    printf("Warning: Corrupted chunk detected at %p\n", (void *)chunk);
+                }
+                return NULL;
+            }
+
+            *padding = chunk_padding(chunk, alignment);
+            if (chunk->chunk_size >= size + *padding)
+            {
+                return chunk;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Statistics, allocated chunks are counted with their whole chunk size */
+static void stats_track_alloc(const metadata_t *chunk)
+{
+    heap_stats.allocs++;
+    heap_stats.live_by_class[heap_stats_class(chunk->chunk_size)]++;
+    heap_stats.bytes_in_use += chunk->chunk_size;
+    if (heap_stats.bytes_in_use > heap_stats.peak_bytes_in_use)
+    {
+        heap_stats.peak_bytes_in_use = heap_stats.bytes_in_use;
+    }
+}
+
+static void stats_track_free(const metadata_t *chunk)
+{
+    heap_stats.frees++;
+    heap_stats.live_by_class[heap_stats_class(chunk->chunk_size)]--;
+    heap_stats.bytes_in_use -= chunk->chunk_size;
+}
+
+/* An allocated chunk that grew or shrank in place */
+static void stats_track_resize(size_t old_size, const metadata_t *chunk)
+{
+    heap_stats.live_by_class[heap_stats_class(old_size)]--;
+    heap_stats.live_by_class[heap_stats_class(chunk->chunk_size)]++;
+    heap_stats.bytes_in_use += chunk->chunk_size - old_size;
+    if (heap_stats.bytes_in_use > heap_stats.peak_bytes_in_use)
+    {
+        heap_stats.peak_bytes_in_use = heap_stats.bytes_in_use;
+    }
+}
+
+/* The largest free chunk is in the highest non-empty class */
+static size_t largest_free_chunk(void)
+{
+    size_t largest = 0;
+    if (free_list_bitmap)
+    {
+        size_t index = (sizeof(unsigned int) * 8 - 1) - __builtin_clz(free_list_bitmap);
+        for (metadata_t *chunk = free_lists[index]; chunk; chunk = FREE_LINKS(chunk)->next)
+        {
+            largest = chunk->chunk_size > largest ? chunk->chunk_size : largest;
+        }
+    }
+    return largest;
+}
+
 /* Public function implementations */
 bool heap_init(void)
 {
@@ -189,6 +430,8 @@ bool heap_init(void)
     initial_metadata->is_allocated = false;
     initial_metadata->current_alignment = MAX_ALIGNMENT;
     initial_metadata->checksum = calculate_chunk_checksum(initial_metadata);
+    free_list_insert(initial_metadata);
+    chunk_count = 1;
 
     if (DEBUG_LOGGING)
     {
@@ -207,8 +450,13 @@ bool heap_init(void)
 
 void *heap_alloc(size_t size, alignment_t alignment)
 {
-    if (size == 0 || size > HEAP_CAPACITY || !is_initialized)
+    if (size == 0)
+    {
+        return NULL;
+    }
+    if (size > HEAP_CAPACITY || !is_initialized)
     {
+        heap_stats.failed_allocs++;
         return NULL;
     }
 
@@ -217,61 +465,33 @@ void *heap_alloc(size_t size, alignment_t alignment)
         alignment = DEFAULT_ALIGNMENT;
     }
 
-    metadata_t *current = (metadata_t *)HEAP_START;
-    while (is_within_heap(current))
+    size_t padding;
+    metadata_t *current = find_free_chunk(size, alignment, &padding);
+    if (!current)
     {
-        if (!validate_chunk(current))
-        {
-            if (DEBUG_LOGGING)
-            {
-                printf("Warning: Corrupted chunk detected at %p\n", (void *)current);
-            }
-            return NULL;
-        }
-
-        if (!current->is_allocated)
+        if (DEBUG_LOGGING)
         {
-            void *data_start = CHUNK_DATA(current);
-            void *aligned_data;
-            size_t padding, total_size;
-
-            if (current->current_alignment >= alignment)
-            {
-                padding = 0;
-                aligned_data = data_start;
-            }
-            else
-            {
-                aligned_data = align_ptr(data_start, alignment);
-                padding = (uint8_t *)aligned_data - (uint8_t *)data_start;
-            }
-
-            total_size = size + padding;
-            if (current->chunk_size >= total_size)
-            {
-                current->is_allocated = true;
-                current->current_alignment = alignment;
-                void *result = split_chunk_if_possible(current, total_size);
-                current->checksum = calculate_chunk_checksum(current);
-
-                if (DEBUG_LOGGING)
-                {
-                    printf("Allocated %zu bytes at %p (aligned to %d)\n",
-                           size, result, alignment);
-                }
-                return result;
-            }
+            printf("Allocation failed: No suitable chunk found for %zu bytes\n", size);
         }
-        current = (metadata_t *)NEXT_CHUNK(current);
+        heap_stats.failed_allocs++;
+        return NULL;
     }
 
+    free_list_remove(current);
+    current->is_allocated = true;
+    current->current_alignment = alignment;
+    split_chunk_if_possible(current, size + padding);
+    current->checksum = calculate_chunk_checksum(current);
+    void *result = place_chunk_data(current, padding);
+    stats_track_alloc(current);
+
     if (DEBUG_LOGGING)
     {
-        printf("Allocation failed: No suitable chunk found for %zu bytes\n", size);
+        printf("Allocated %zu bytes at %p (aligned to %d)\n",
+               size, result, alignment);
     }
-    return NULL;
+    return result;
 }
-
 void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
 {
     if (!ptr)
@@ -296,17 +516,29 @@ void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
         new_alignment = DEFAULT_ALIGNMENT;
     }
 
-    // Try to shrink or expand in place
-    if (new_size <= chunk->chunk_size && new_alignment <= chunk->current_alignment)
+    heap_stats.reallocs++;
+    size_t old_size = chunk->chunk_size;
+    size_t padding = (uint8_t *)ptr - CHUNK_DATA(chunk);
+    size_t usable_size = chunk->chunk_size - padding;
+    bool is_aligned = !new_alignment || !((uintptr_t)ptr & (new_alignment - 1));
+
+    // Try to shrink or expand in place, the padding in front of ptr is kept
+    if (new_size <= usable_size && is_aligned)
     {
-        return split_chunk_if_possible(chunk, new_size);
+        split_chunk_if_possible(chunk, new_size + padding);
+        stats_track_resize(old_size, chunk);
+        return ptr;
     }
 
     // Try to expand using next chunk
-    if (try_coalesce_with_next(chunk) && chunk->chunk_size >= new_size)
+    if (is_aligned && try_coalesce_with_next(chunk) && chunk->chunk_size - padding >= new_size)
     {
-        return split_chunk_if_possible(chunk, new_size);
+        split_chunk_if_possible(chunk, new_size + padding);
+        stats_track_resize(old_size, chunk);
+        return ptr;
     }
+    stats_track_resize(old_size, chunk); // a merge that fell short still grew the chunk
+    usable_size = chunk->chunk_size - padding;
 
     // Allocate new chunk and copy data
     void *new_ptr = heap_alloc(new_size, new_alignment);
@@ -315,7 +547,7 @@ void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
         return NULL;
     }
 
-    memcpy(new_ptr, ptr, chunk->chunk_size < new_size ? chunk->chunk_size : new_size);
+    memcpy(new_ptr, ptr, usable_size < new_size ? usable_size : new_size);
     heap_free(ptr);
 
     if (DEBUG_LOGGING)
@@ -343,6 +575,7 @@ void heap_free(void *ptr)
         return;
     }
 
+    stats_track_free(chunk);
     chunk->is_allocated = false;
     chunk->current_alignment = calculate_alignment(chunk);
     chunk->checksum = calculate_chunk_checksum(chunk);
@@ -353,33 +586,26 @@ void heap_free(void *ptr)
     }
 
     try_coalesce_with_next(chunk);
+    chunk = try_coalesce_with_prev(chunk);
+    free_list_insert(chunk);
 }
 
 void heap_get_stats(size_t *total_size, size_t *used_size,
                     size_t *free_size, size_t *largest_free_block)
 {
     *total_size = HEAP_CAPACITY;
-    *used_size = *free_size = *largest_free_block = 0;
-
-    metadata_t *current = (metadata_t *)HEAP_START;
-    while (is_within_heap(current))
-    {
-        if (!validate_chunk(current))
-        {
-            break;
-        }
+    *free_size = free_bytes;
+    *used_size = HEAP_CAPACITY - free_bytes - chunk_count * sizeof(metadata_t);
+    *largest_free_block = largest_free_chunk();
+}
 
-        if (current->is_allocated)
-        {
-            *used_size += current->chunk_size;
-        }
-        else
-        {
-            *free_size += current->chunk_size;
-            *largest_free_block = current->chunk_size > *largest_free_block ? current->chunk_size : *largest_free_block;
-        }
-        current = (metadata_t *)NEXT_CHUNK(current);
-    }
+void heap_stats_snapshot(heap_stats_t *stats)
+{
+    *stats = heap_stats;
+    stats->bytes_mapped = HEAP_CAPACITY;
+    stats->bytes_free = free_bytes;
+    stats->largest_free_block = largest_free_chunk();
+    stats->fragmentation = heap_stats_fragmentation(stats->bytes_free, stats->largest_free_block);
 }
 
 #endif // MEM_IMPLEMENTATION
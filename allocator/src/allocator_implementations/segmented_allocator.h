@@ -7,33 +7,53 @@
 #include <string.h>
 #include <pthread.h>
 #include <stdio.h>
-
-#define HEAP_CAPACITY (65536)
-#define FREE_CAPACITY (1024)
-#define ALLOC_CAPACITY (1024)
+#include <setjmp.h>
+#include <signal.h>
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../heap_stats.h"
+
+#define ARENA_SHIFT (20)
+#define ARENA_SIZE ((size_t)1 << ARENA_SHIFT) // every arena is ARENA_SIZE bytes and aligned to ARENA_SIZE
+#define HUGE_THRESHOLD (ARENA_SIZE / 4)        // allocations at or above this get a mapping of their own
+#define DEFAULT_ARENA_RETENTION (4)            // fully free arenas kept mapped for reuse
+
+#define ARENA_MAP_BITS (48 - ARENA_SHIFT) // user space addresses are 48 bits wide
+#define ARENA_MAP_LEAF_BITS (14)
+#define ARENA_MAP_ROOT_BITS (ARENA_MAP_BITS - ARENA_MAP_LEAF_BITS)
 
 #define MAX_ALIGNMENT (ALIGN_64)
 #define MAX_ALIGNMENT_INT (64)
 #define DEFAULT_ALIGNMENT ((alignment_t)(sizeof(void *))) // by default align on pointer size, this is enough for most platforms and architectures
 
-#define SPLIT_CUTOFF (16)
+#define BIN_COUNT (9)
+#define BIN_MAX_SIZE (1024)
 
-#define FREE_DEFRAG_CUTOFF (32) // must be a power of 2
+#define MAGAZINE_CAPACITY (16) // per-thread cache of free slots for each bin
+#define MAGAZINE_BATCH (MAGAZINE_CAPACITY / 2)
 
-#define BIN_8_SIZE (8)
-#define BIN_16_SIZE (16)
-#define BIN_32_SIZE (32)
-#define BIN_8_CAPACITY (1024)
-#define BIN_16_CAPACITY (512)
-#define BIN_32_CAPACITY (256)
+#define STATS_FLUSH_BYTES ((int64_t)64 << 10) // a thread adds its change of bytes_in_use to the shared total past this
 
-typedef enum
-{
-    ALLOC_TYPE_HEAP,
-    ALLOC_TYPE_BIN_8,
-    ALLOC_TYPE_BIN_16,
-    ALLOC_TYPE_BIN_32
-} allocation_type_t;
+#define GC_DEFAULT_STEP_BUDGET (8192)  // words scanned per gc_step, sweeping an arena costs one unit per bitmap word
+#define GC_SWEEP_FREE_COST (8)         // budget charged for every object the sweep frees
+#define GC_UNMAP_COST_SHIFT (6)        // unmapping n bytes is charged n >> GC_UNMAP_COST_SHIFT
+#define GC_MARK_STACK_INITIAL (4096)
+#define GC_MAX_MARKERS (8)             // the collector plus helper threads for parallel marking
+#define GC_DEQUE_CAPACITY (1 << 16)    // grey ranges per marker, a power of two
+#define GC_MARK_SLICE (4096)           // words a parallel marker scans before sharing the rest of a range
+
+#ifndef GC_SUSPEND_SIGNAL
+#if defined(SIGPWR)
+#define GC_SUSPEND_SIGNAL SIGPWR
+#else
+#define GC_SUSPEND_SIGNAL SIGUSR1
+#endif
+#endif
+#ifndef GC_RESUME_SIGNAL
+#define GC_RESUME_SIGNAL SIGXCPU
+#endif
 
 typedef enum
 {
@@ -49,721 +69,2437 @@ typedef enum
     ALIGN_SAME = 0,
 } alignment_t;
 
-typedef struct
-{
-    void *chunk_ptr;
-    void *data_ptr;
-    void *prev_chunk_ptr;
-    size_t size;
-    size_t usable_size;
-    alignment_t current_alignment;
-    allocation_type_t alloc_type;
-    bool mark;
-} metadata_t;
+void *heap_alloc(size_t size, alignment_t alignment);
+void heap_free(void *ptr);
+void heap_init();
+void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment);
+void heap_set_arena_retention(size_t arena_count); // how many fully free arenas stay mapped, the rest go back to the OS
 
-static metadata_t free_array[FREE_CAPACITY] = {0};
-static metadata_t alloc_array[ALLOC_CAPACITY] = {0};
-static size_t free_array_size = 0;
-static size_t alloc_array_size = 0;
+#ifdef GC_COLLECT
+void gc_register_root(void *root);
+void gc_collect();                     // full collection, the calling thread waits for all of it
+bool gc_step();                        // one bounded step of an incremental collection, true when a collection completed
+void gc_set_step_budget(size_t work);  // roughly the words scanned per step
+void gc_write_barrier(void *value);    // call with every heap pointer stored into heap memory while collections run
+void gc_register_thread();             // every thread other than the collecting one whose stack holds heap pointers
+void gc_unregister_thread();
+void gc_set_marker_threads(size_t count); // threads marking in parallel during pauses, 0 for one per CPU
+#endif
 
-static uint8_t heap[HEAP_CAPACITY] __attribute__((aligned(MAX_ALIGNMENT_INT))) = {0};
+#ifdef MEM_IMPLEMENTATION
 
-static uint8_t bin_8[BIN_8_CAPACITY * BIN_8_SIZE] __attribute__((aligned(MAX_ALIGNMENT_INT))) = {0};
-static uint8_t bin_16[BIN_16_CAPACITY * BIN_16_SIZE] __attribute__((aligned(MAX_ALIGNMENT_INT))) = {0};
-static uint8_t bin_32[BIN_32_CAPACITY * BIN_32_SIZE] __attribute__((aligned(MAX_ALIGNMENT_INT))) = {0};
+typedef enum
+{
+    ALLOC_TYPE_NONE, // arena sitting in the retention cache
+    ALLOC_TYPE_HEAP,
+    ALLOC_TYPE_BIN,
+    ALLOC_TYPE_HUGE
+} allocation_type_t;
 
-static metadata_t free_bin_8[BIN_8_CAPACITY] = {0};
-static metadata_t alloc_bin_8[BIN_8_CAPACITY] = {0};
-static metadata_t free_bin_16[BIN_16_CAPACITY] = {0};
-static metadata_t alloc_bin_16[BIN_16_CAPACITY] = {0};
-static metadata_t free_bin_32[BIN_32_CAPACITY] = {0};
-static metadata_t alloc_bin_32[BIN_32_CAPACITY] = {0};
+/*
+ * Chunks of the general heap carry their own boundary tags. The size of a free chunk is repeated
+ * in the prev_size field of the chunk after it, so both neighbours are found in O(1) on free.
+ */
+typedef struct heap_chunk
+{
+    size_t prev_size; // size of the previous chunk, only valid while that chunk is free
+    size_t head;      // chunk size | CHUNK_* flags
+    struct heap_chunk *next_free; // free chunks only, these overlap the payload
+    struct heap_chunk *prev_free;
+} heap_chunk_t;
+
+#define CHUNK_USED ((size_t)1)
+#define CHUNK_PREV_USED ((size_t)2)
+#define CHUNK_FLAGS ((size_t)15)
+#define CHUNK_HEADER_SIZE (2 * sizeof(size_t))
+#define CHUNK_MIN_SIZE (sizeof(heap_chunk_t))
+#define CHUNK_GRANULE (16) // chunk sizes and data pointers are multiples of this
+#define CHUNK_GRANULE_SHIFT (4)
+
+// two-level segregated fit: first level by power of two, second level splits each range into TLSF_SL_COUNT lists
+#define TLSF_SL_BITS (4)
+#define TLSF_SL_COUNT (1 << TLSF_SL_BITS)
+#define TLSF_FL_SHIFT (TLSF_SL_BITS + CHUNK_GRANULE_SHIFT) // sizes below 1 << TLSF_FL_SHIFT all share the first list
+#define TLSF_FL_COUNT (ARENA_SHIFT - TLSF_FL_SHIFT + 1)
+
+// free slots are threaded into a singly-linked list through their own payload
+typedef struct bin_slot
+{
+    struct bin_slot *next;
+} bin_slot_t;
+
+/*
+ * Header at the start of every mapping. Slab arenas carve the rest into slots of one size class,
+ * heap arenas hand it to the general heap, huge arenas hold exactly one allocation.
+ */
+typedef struct arena
+{
+    allocation_type_t type;
+    size_t map_size;
+    struct arena *next; // bin, heap, huge or cache list
+    struct arena *prev;
+
+    // slab arenas
+    size_t bin_index;
+    struct arena *next_partial; // arenas of the bin that still have free slots
+    struct arena *prev_partial;
+    bool in_partial;
+    size_t untouched; // slots at or above this index have never been handed out
+    size_t live;      // slots held by callers or by thread magazines
+    bin_slot_t *free_list;
+    uint64_t *occupied; // one bit per slot, updated atomically; heap arenas mark chunk data starts per granule
+    uint64_t *marks;    // collector mark bits, laid out like occupied
+
+    // huge arenas
+    size_t usable_size;
+    bool mark;
 
-static size_t free_bin_8_size = 0;
-static size_t alloc_bin_8_size = 0;
-static size_t free_bin_16_size = 0;
-static size_t alloc_bin_16_size = 0;
-static size_t free_bin_32_size = 0;
-static size_t alloc_bin_32_size = 0;
+    bool swept; // cleared for every arena when a collection finishes marking, set again once it is swept
+} arena_t;
 
-static size_t num_of_free_called_on_heap = 0;
+#define ARENA_HEADER_SIZE ((sizeof(arena_t) + MAX_ALIGNMENT_INT - 1) & ~(size_t)(MAX_ALIGNMENT_INT - 1))
+#define HEAP_START_BITMAP_SIZE (ARENA_SIZE / CHUNK_GRANULE / 8)
+#define HEAP_CHUNKS_OFFSET (ARENA_HEADER_SIZE + 2 * HEAP_START_BITMAP_SIZE) // chunk starts, then mark bits
+#define HEAP_ARENA_PAYLOAD (ARENA_SIZE - HEAP_CHUNKS_OFFSET - CHUNK_HEADER_SIZE) // the last header is a fence
 
-void *heap_alloc(size_t size, alignment_t alignment);
-void heap_free(void *ptr);
-void heap_init();
-void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment);
+typedef struct
+{
+    size_t slot_size;
+    size_t slot_alignment;
+    uint64_t slot_reciprocal; // ceil(2^32 / slot_size), slot index = (offset * reciprocal) >> 32
+    size_t capacity;          // slots per arena
+    size_t slots_offset;      // offset of the first slot from the arena start
+    arena_t *arenas;
+    arena_t *partial;
+    pthread_mutex_t lock; // guards the arenas of the bin, i.e. its central pool
+} bin_t;
+
+static bin_t bins[BIN_COUNT] = {
+    {.slot_size = 8, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 16, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 32, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 48, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 64, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 128, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 256, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 512, .lock = PTHREAD_MUTEX_INITIALIZER},
+    {.slot_size = 1024, .lock = PTHREAD_MUTEX_INITIALIZER},
+};
+
+// smallest bin for each size in 8 byte steps, filled in by heap_init
+static uint8_t bin_lookup[BIN_MAX_SIZE / 8 + 1] = {0};
+
+// per-thread stacks of free slots sitting in front of the central pool of each bin
+typedef struct
+{
+    void *slots[MAGAZINE_CAPACITY];
+    size_t count;
+} magazine_t;
 
-#ifdef MEM_IMPLEMENTATION
+static _Thread_local magazine_t magazines[BIN_COUNT];
+static _Thread_local bool magazines_registered = false;
+static pthread_key_t magazine_key;
+static pthread_once_t magazine_key_once = PTHREAD_ONCE_INIT;
 
-static void init_bins();
-static int64_t search_by_ptr(void *ptr, metadata_t *array, size_t array_size);
-static int64_t search_by_ptr_in_free_array(void *ptr);
-static int64_t search_by_ptr_in_alloc_array(void *ptr);
-static int64_t search_by_size_in_free_array(size_t size, alignment_t alignment);
-static inline alignment_t calculate_alignment(const void *ptr);
-static bool remove_from_array(size_t index, metadata_t *array, size_t *array_size);
-static bool remove_from_free_array(size_t index);
-static bool remove_from_alloc_array(size_t index);
-static size_t find_insertion_position(void *data_ptr, metadata_t *array, size_t array_size);
-static bool add_into_array(metadata_t chunk, metadata_t *array, size_t *array_size, size_t capacity);
-static bool add_into_free_array(void *chunk_ptr, void *data_ptr, void *prev_chunk_ptr,
-                                size_t size, size_t usable_size, alignment_t alignment);
-static bool add_into_alloc_array(void *chunk_ptr, void *data_ptr, void *prev_chunk_ptr,
-                                 size_t size, size_t usable_size, alignment_t alignment);
-static void defragment_heap();
+// per-thread counters, written only by their own thread and summed up by heap_stats_snapshot
+typedef struct thread_stats
+{
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t reallocs;
+    uint64_t failed_allocs;
+    uint64_t coalesces;
+    uint64_t live_by_class[HEAP_STATS_CLASS_COUNT]; // wraps when the thread frees more than it allocated, the sum does not
+    int64_t pending_bytes;                          // change of bytes_in_use not yet added to stats_bytes_in_use
+    struct thread_stats *next;
+    struct thread_stats *prev;
+} thread_stats_t;
+
+static _Thread_local thread_stats_t thread_stats;
+static _Thread_local bool thread_stats_registered = false;
+static pthread_key_t thread_stats_key;
+static pthread_once_t thread_stats_key_once = PTHREAD_ONCE_INIT;
+
+// guards the list of thread counters and the totals of the threads that exited
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static thread_stats_t *stats_threads = NULL;
+static thread_stats_t retired_stats = {0};
+static size_t stats_bytes_in_use = 0; // updated atomically, behind by the pending bytes of every thread
+static size_t stats_peak_bytes = 0;
+static size_t stats_bytes_mapped = 0;
+
+// two-level radix map from address >> ARENA_SHIFT to "is one of our arenas", readable without locks
+static uint8_t *arena_map[(size_t)1 << ARENA_MAP_ROOT_BITS] = {0};
+
+// guards arena_map, the retention cache and the huge arena list
+static pthread_mutex_t arena_lock = PTHREAD_MUTEX_INITIALIZER;
+static arena_t *cached_arenas = NULL;
+static size_t cached_arena_count = 0;
+static size_t arena_retention = DEFAULT_ARENA_RETENTION;
+static arena_t *huge_arenas = NULL;
+
+// guards the heap arenas and their chunks
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t heap_init_once = PTHREAD_ONCE_INIT;
+static arena_t *heap_arenas = NULL;
+
+// free chunks by size class, a set bit means the list is not empty
+static heap_chunk_t *free_chunks[TLSF_FL_COUNT][TLSF_SL_COUNT] = {0};
+static uint32_t free_fl_bitmap = 0;
+static uint32_t free_sl_bitmap[TLSF_FL_COUNT] = {0};
+static size_t free_chunk_bytes = 0;
+
+static arena_t *map_arena(size_t size);
+static void release_arena(arena_t *arena);
+static arena_t *acquire_arena();
+static void register_arena(arena_t *arena, bool owned);
+static inline arena_t *arena_of(const void *ptr);
+static inline arena_t *find_arena(const void *ptr);
+static void init_slab_arena(arena_t *arena, size_t bin_index);
+static inline bin_t *find_bin_for_size(size_t size, alignment_t alignment);
+static inline bool bin_slot_index(const bin_t *bin, const arena_t *arena, const void *ptr, size_t *index);
+static void *bin_pop(bin_t *bin);
+static bool bin_push(bin_t *bin, arena_t *arena, void *ptr);
+static void release_slab_arena(bin_t *bin, arena_t *arena);
+static void *bin_alloc(bin_t *bin);
+static bool bin_free(arena_t *arena, void *ptr);
+static magazine_t *get_magazines();
+static void flush_magazines(void *arg);
+static void *huge_alloc(size_t size);
+static void huge_free(arena_t *arena);
+static inline size_t chunk_size(const heap_chunk_t *chunk);
+static inline heap_chunk_t *chunk_next(const heap_chunk_t *chunk);
+static inline size_t chunk_size_for(size_t size);
+static inline size_t chunk_padding(const heap_chunk_t *chunk, alignment_t alignment);
+static inline heap_chunk_t *find_heap_chunk(arena_t *arena, const void *ptr);
+static inline size_t chunk_granule(const arena_t *arena, const heap_chunk_t *chunk);
+static inline void set_chunk_start(heap_chunk_t *chunk, bool allocated);
+static inline void tlsf_mapping(size_t size, size_t *fl, size_t *sl);
+static void insert_free_chunk(heap_chunk_t *chunk);
+static void remove_free_chunk(heap_chunk_t *chunk);
+static heap_chunk_t *search_free_chunk(size_t size, alignment_t alignment);
+static heap_chunk_t *heap_chunk_free(heap_chunk_t *chunk);
+static void split_chunk(heap_chunk_t *chunk, size_t size);
+static bool try_extend_chunk(heap_chunk_t *chunk, size_t size);
+static void *heap_region_alloc(size_t size, alignment_t alignment);
+static void heap_region_free(arena_t *arena, void *ptr);
+static heap_chunk_t *add_heap_arena();
+static bool release_empty_heap_arena(arena_t *arena);
+static void heap_init_once_routine();
+static inline thread_stats_t *get_thread_stats();
+static inline void stats_add(uint64_t *counter, uint64_t count);
+static inline void stats_alloc(size_t size);
+static inline void stats_free(size_t size);
+static inline void stats_resize(size_t old_size, size_t new_size);
 
 #ifdef GC_COLLECT
 
 extern char __data_start, _edata; // data section boundaries
 extern char __bss_start, _end;    // bss section boundaries
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+extern int pthread_getattr_np(pthread_t thread, pthread_attr_t *attr);
+#endif
+
 #define MAX_GC_ROOTS 1024
 static void *gc_roots[MAX_GC_ROOTS];
 static size_t gc_roots_count = 0;
 
+/*
+ * Incremental tri-color collector. White objects have a clear mark bit, grey ones are marked and
+ * still have a range on the mark stack, black ones are marked and fully scanned. A cycle greys the
+ * roots, then every gc_step() scans at most gc_step_budget words. Once the mark stack runs dry the
+ * roots are scanned again in one go to catch what the mutator moved there, and the sweep then frees
+ * the white objects arena by arena, again within the budget of each step.
+ *
+ * The mutator does not stop between steps, so a heap pointer stored into heap memory while a cycle
+ * runs must be passed to gc_write_barrier(), initialising stores into fresh objects included. Objects
+ * allocated while marking, or in an arena the sweep has not reached yet, start out black, which keeps
+ * the final root scan down to the roots themselves. A moving heap_realloc greys its copy.
+ *
+ * The stacks of the collecting thread and of every registered thread are roots. Registered threads
+ * are stopped while their stacks are read, when a cycle starts and when marking finishes; gc_collect
+ * keeps them stopped for its whole mark phase, so it needs no barrier. Pauses are marked in parallel.
+ */
+typedef enum
+{
+    GC_PHASE_IDLE,
+    GC_PHASE_MARK,
+    GC_PHASE_SWEEP
+} gc_phase_t;
+
+typedef struct
+{
+    void **begin;
+    void **end;
+    arena_t *arena; // owner of the range, NULL for roots; checked before scanning as the mutator may have unmapped it
+} gc_range_t;
+
+static gc_phase_t gc_phase = GC_PHASE_IDLE;
+static size_t gc_step_budget = GC_DEFAULT_STEP_BUDGET;
+
+static gc_range_t *gc_mark_stack = NULL; // mapped directly so growing it never re-enters the allocator
+static size_t gc_mark_stack_size = 0;
+static size_t gc_mark_stack_capacity = 0;
+static bool gc_mark_overflow = false; // a grey object was dropped, the marked objects have to be rescanned, set atomically
+
+// the sweep walks the heap arenas, then every bin, then the huge arenas
+static size_t gc_sweep_list = 0;
+static arena_t *gc_sweep_cursor = NULL;
+
+static _Thread_local uintptr_t gc_stack_top = 0;
+
+/*
+ * Threads that hold heap pointers register with the collector. When the collector needs their
+ * roots it stops them with GC_SUSPEND_SIGNAL; the handler records where the stack of the thread
+ * currently ends and waits for GC_RESUME_SIGNAL. The kernel stores the interrupted registers in the
+ * signal frame, which lies between the handler and the interrupted code, so scanning from the
+ * handler up to the top of the stack covers both. The collector takes every allocator lock before it
+ * stops anyone, so no stopped thread holds one of them.
+ */
+typedef struct gc_thread
+{
+    pthread_t id;
+    uintptr_t stack_top;
+    uintptr_t stack_bottom; // written by the thread itself while it is stopped
+    void *occupying;        // slot gc_occupy_slot may be publishing without the bin lock
+    struct gc_thread *next;
+    struct gc_thread *prev;
+} gc_thread_t;
+
+static pthread_mutex_t gc_threads_lock = PTHREAD_MUTEX_INITIALIZER; // held for as long as the world is stopped
+static gc_thread_t *gc_threads = NULL;
+static pthread_once_t gc_threads_once = PTHREAD_ONCE_INIT;
+static pthread_key_t gc_thread_key;
+static _Thread_local gc_thread_t gc_self;
+static _Thread_local bool gc_self_registered = false;
+
+static bool gc_world_stopped = false;
+static size_t gc_handshakes = 0; // stop and resume acknowledgements
+static size_t gc_stopped_threads = 0;
+
+/*
+ * Parallel marking: the collector and up to GC_MAX_MARKERS - 1 helper threads each own a bounded
+ * Chase-Lev deque. A marker pushes and pops at the bottom of its own deque and steals from the top
+ * of the others once it runs dry. Ranges longer than GC_MARK_SLICE words are split so large objects
+ * are shared out as well.
+ */
+typedef struct
+{
+    gc_range_t *buffer;
+    long top;
+    long bottom;
+} gc_deque_t;
+
+static gc_deque_t gc_deques[GC_MAX_MARKERS];
+static _Thread_local gc_deque_t *gc_local_deque = NULL; // set while the thread marks in parallel
+
+static pthread_mutex_t gc_marker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gc_marker_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t gc_marker_done = PTHREAD_COND_INITIALIZER;
+static size_t gc_requested_markers = 0; // 0 picks one per online CPU
+static size_t gc_helpers_started = 0;
+static size_t gc_ready_markers = 1;  // markers with a deque, and a thread unless it is the collector
+static size_t gc_active_markers = 1; // markers taking part in the current drain
+static unsigned long gc_mark_round = 0;
+static size_t gc_helpers_finished = 0;
+static size_t gc_idle_markers = 0;
+
 void gc_register_root(void *root)
 {
+    pthread_mutex_lock(&heap_lock);
     if (gc_roots_count < MAX_GC_ROOTS)
     {
         gc_roots[gc_roots_count++] = root;
     }
+    pthread_mutex_unlock(&heap_lock);
 }
 
-static bool is_valid_heap_ptr(void *ptr)
+void gc_set_step_budget(size_t work)
 {
+    pthread_mutex_lock(&heap_lock);
+    gc_step_budget = work ? work : 1;
+    pthread_mutex_unlock(&heap_lock);
+}
+
+// the collector works on the heap, every bin and the mark state at once
+static void gc_lock_heap()
+{
+    pthread_mutex_lock(&heap_lock);
+    for (size_t b = 0; b < BIN_COUNT; b++)
+    {
+        pthread_mutex_lock(&bins[b].lock);
+    }
+}
 
-    return ((uintptr_t)ptr >= (uintptr_t)heap && (uintptr_t)ptr < (uintptr_t)heap + HEAP_CAPACITY) ||
-           ((uintptr_t)ptr >= (uintptr_t)bin_8 && (uintptr_t)ptr < (uintptr_t)bin_8 + BIN_8_CAPACITY * BIN_8_SIZE) ||
-           ((uintptr_t)ptr >= (uintptr_t)bin_16 && (uintptr_t)ptr < (uintptr_t)bin_16 + BIN_16_CAPACITY * BIN_16_SIZE) ||
-           ((uintptr_t)ptr >= (uintptr_t)bin_32 && (uintptr_t)ptr < (uintptr_t)bin_32 + BIN_32_CAPACITY * BIN_32_SIZE);
+static void gc_unlock_heap()
+{
+    for (size_t b = BIN_COUNT; b > 0; b--)
+    {
+        pthread_mutex_unlock(&bins[b - 1].lock);
+    }
+    pthread_mutex_unlock(&heap_lock);
 }
 
-static bool is_marked_allocation(void *ptr)
+// a bounded Chase-Lev deque, only the owner pushes and pops
+static bool gc_deque_push(gc_deque_t *deque, gc_range_t range)
 {
-    int64_t heap_index = search_by_ptr_in_alloc_array(ptr);
-    if (heap_index != -1)
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    if (bottom - top >= GC_DEQUE_CAPACITY)
     {
-        return alloc_array[heap_index].mark;
+        return false;
     }
 
-    if ((uintptr_t)ptr >= (uintptr_t)bin_8 && (uintptr_t)ptr < (uintptr_t)bin_8 + BIN_8_CAPACITY * BIN_8_SIZE)
+    gc_range_t *slot = &deque->buffer[bottom & (GC_DEQUE_CAPACITY - 1)];
+    __atomic_store_n(&slot->begin, range.begin, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->end, range.end, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->arena, range.arena, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool gc_deque_pop(gc_deque_t *deque, gc_range_t *range)
+{
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long top = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if (top > bottom)
     {
-        heap_index = search_by_ptr(ptr, alloc_bin_8, alloc_bin_8_size);
-        return (heap_index != -1) ? alloc_bin_8[heap_index].mark : false;
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return false;
     }
-    if ((uintptr_t)ptr >= (uintptr_t)bin_16 && (uintptr_t)ptr < (uintptr_t)bin_16 + BIN_16_CAPACITY * BIN_16_SIZE)
+
+    *range = deque->buffer[bottom & (GC_DEQUE_CAPACITY - 1)];
+    if (top == bottom)
     {
-        heap_index = search_by_ptr(ptr, alloc_bin_16, alloc_bin_16_size);
-        return (heap_index != -1) ? alloc_bin_16[heap_index].mark : false;
+        // the last entry, a thief may be after it as well
+        bool won = __atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+        __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return won;
     }
-    if ((uintptr_t)ptr >= (uintptr_t)bin_32 && (uintptr_t)ptr < (uintptr_t)bin_32 + BIN_32_CAPACITY * BIN_32_SIZE)
+    return true;
+}
+
+static bool gc_deque_steal(gc_deque_t *deque, gc_range_t *range)
+{
+    long top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom)
     {
-        heap_index = search_by_ptr(ptr, alloc_bin_32, alloc_bin_32_size);
-        return (heap_index != -1) ? alloc_bin_32[heap_index].mark : false;
+        return false;
     }
 
-    return false;
+    gc_range_t *slot = &deque->buffer[top & (GC_DEQUE_CAPACITY - 1)];
+    range->begin = __atomic_load_n(&slot->begin, __ATOMIC_RELAXED);
+    range->end = __atomic_load_n(&slot->end, __ATOMIC_RELAXED);
+    range->arena = __atomic_load_n(&slot->arena, __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+static bool gc_deque_empty(gc_deque_t *deque)
+{
+    return __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE) >= __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
 }
 
-static void mark_object(void *ptr)
+static void gc_push_range(arena_t *arena, void *begin, void *end)
 {
-    if (!ptr || !is_valid_heap_ptr(ptr) || is_marked_allocation(ptr))
+    if (gc_local_deque)
     {
+        if (!gc_deque_push(gc_local_deque, (gc_range_t){(void **)begin, (void **)end, arena}))
+        {
+            __atomic_store_n(&gc_mark_overflow, true, __ATOMIC_RELAXED);
+        }
         return;
     }
 
-    int64_t heap_index = search_by_ptr_in_alloc_array(ptr);
-    metadata_t *metadata = NULL;
+    if (gc_mark_stack_size == gc_mark_stack_capacity)
+    {
+        size_t capacity = gc_mark_stack_capacity ? 2 * gc_mark_stack_capacity : GC_MARK_STACK_INITIAL;
+        gc_range_t *stack = mmap(NULL, capacity * sizeof(gc_range_t), PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (stack == MAP_FAILED)
+        {
+            gc_mark_overflow = true;
+            return;
+        }
+
+        if (gc_mark_stack)
+        {
+            memcpy(stack, gc_mark_stack, gc_mark_stack_size * sizeof(gc_range_t));
+            munmap(gc_mark_stack, gc_mark_stack_capacity * sizeof(gc_range_t));
+        }
+        gc_mark_stack = stack;
+        gc_mark_stack_capacity = capacity;
+    }
 
-    if (heap_index != -1)
+    gc_mark_stack[gc_mark_stack_size++] = (gc_range_t){(void **)begin, (void **)end, arena};
+}
+
+// marks the allocation starting at ptr and queues its contents if it was white
+static void gc_shade(void *ptr)
+{
+    arena_t *arena = find_arena(ptr);
+    if (!arena)
     {
-        metadata = &alloc_array[heap_index];
+        return;
     }
-    else
+
+    switch (arena->type)
     {
-        if ((uintptr_t)ptr >= (uintptr_t)bin_8 && (uintptr_t)ptr < (uintptr_t)bin_8 + BIN_8_CAPACITY * BIN_8_SIZE)
+    case ALLOC_TYPE_HEAP:
+    {
+        heap_chunk_t *chunk = find_heap_chunk(arena, ptr);
+        if (!chunk)
         {
-            heap_index = search_by_ptr(ptr, alloc_bin_8, alloc_bin_8_size);
-            metadata = (heap_index != -1) ? &alloc_bin_8[heap_index] : NULL;
+            return;
         }
-        else if ((uintptr_t)ptr >= (uintptr_t)bin_16 && (uintptr_t)ptr < (uintptr_t)bin_16 + BIN_16_CAPACITY * BIN_16_SIZE)
+
+        size_t granule = chunk_granule(arena, chunk);
+        uint64_t bit = (uint64_t)1 << (granule % 64);
+        if ((__atomic_load_n(&arena->marks[granule / 64], __ATOMIC_RELAXED) & bit) ||
+            (__atomic_fetch_or(&arena->marks[granule / 64], bit, __ATOMIC_RELAXED) & bit))
         {
-            heap_index = search_by_ptr(ptr, alloc_bin_16, alloc_bin_16_size);
-            metadata = (heap_index != -1) ? &alloc_bin_16[heap_index] : NULL;
+            return;
         }
-        else if ((uintptr_t)ptr >= (uintptr_t)bin_32 && (uintptr_t)ptr < (uintptr_t)bin_32 + BIN_32_CAPACITY * BIN_32_SIZE)
+        gc_push_range(arena, ptr, chunk_next(chunk));
+        return;
+    }
+    case ALLOC_TYPE_BIN:
+    {
+        bin_t *bin = &bins[arena->bin_index];
+        size_t slot;
+        if (!bin_slot_index(bin, arena, ptr, &slot) ||
+            !((__atomic_load_n(&arena->occupied[slot / 64], __ATOMIC_RELAXED) >> (slot % 64)) & 1))
         {
-            heap_index = search_by_ptr(ptr, alloc_bin_32, alloc_bin_32_size);
-            metadata = (heap_index != -1) ? &alloc_bin_32[heap_index] : NULL;
+            return;
         }
-    }
 
-    if (!metadata)
+        uint64_t bit = (uint64_t)1 << (slot % 64);
+        if (__atomic_fetch_or(&arena->marks[slot / 64], bit, __ATOMIC_RELAXED) & bit)
+        {
+            return;
+        }
+        gc_push_range(arena, ptr, (uint8_t *)ptr + bin->slot_size);
         return;
-
-    metadata->mark = true;
-
-    for (size_t offset = 0; offset < metadata->usable_size; offset += sizeof(void *))
+    }
+    case ALLOC_TYPE_HUGE:
     {
-        void *potential_ptr = *(void **)((char *)ptr + offset);
-        mark_object(potential_ptr);
+        // any address in the first block of the mapping counts, header included: huge_alloc links the
+        // arena in before the pointer it returns exists and may hold nothing but the base meanwhile
+        if (__atomic_exchange_n(&arena->mark, true, __ATOMIC_RELAXED))
+        {
+            return;
+        }
+        void **object = (void **)((uint8_t *)arena + ARENA_HEADER_SIZE);
+        gc_push_range(arena, object, object + arena->usable_size / sizeof(void *));
+        return;
+    }
+    default:
+        return;
     }
 }
 
-static void mark_roots()
+// scans grey ranges until the stack is empty or budget words were read, returns the unused budget
+static size_t gc_drain(size_t budget)
 {
-    for (size_t i = 0; i < gc_roots_count; i++)
+    while (gc_mark_stack_size && budget)
     {
-        mark_object(gc_roots[i]);
-    }
+        gc_range_t *range = &gc_mark_stack[gc_mark_stack_size - 1];
+        if (range->arena && find_arena(range->arena) != range->arena)
+        {
+            gc_mark_stack_size--; // freed and unmapped since it was greyed
+            continue;
+        }
 
-    uintptr_t stack_bottom, stack_top;
+        size_t words = (size_t)(range->end - range->begin);
+        void **begin = range->begin;
+
+        // a large object is scanned in slices, the rest of it stays on the stack
+        if (words > budget)
+        {
+            words = budget;
+            range->begin += words;
+        }
+        else
+        {
+            gc_mark_stack_size--;
+        }
+
+        budget -= words;
+        for (void **word = begin; word < begin + words; word++)
+        {
+            gc_shade(*word);
+        }
+    }
+    return budget;
+}
 
+static uintptr_t gc_thread_stack_top()
+{
+    if (!gc_stack_top)
+    {
 #if defined(__linux__)
-    void *stack_base;
-    size_t stack_size;
-    pthread_attr_t attr;
-    pthread_attr_init(&attr);
-    pthread_attr_getstack(&attr, &stack_base, &stack_size);
-    stack_bottom = (uintptr_t)stack_base;
-    stack_top = stack_bottom + stack_size;
-    pthread_attr_destroy(&attr);
+        pthread_attr_t attr;
+        void *stack_base;
+        size_t stack_size;
+        if (!pthread_getattr_np(pthread_self(), &attr))
+        {
+            pthread_attr_getstack(&attr, &stack_base, &stack_size);
+            gc_stack_top = (uintptr_t)stack_base + stack_size;
+            pthread_attr_destroy(&attr);
+        }
 #elif defined(__APPLE__)
-    stack_bottom = (uintptr_t)pthread_get_stackaddr_np(pthread_self());
-    stack_top = stack_bottom - pthread_get_stacksize_np(pthread_self());
+        gc_stack_top = (uintptr_t)pthread_get_stackaddr_np(pthread_self()); // the highest address of the stack
 #else
-    uintptr_t sp;
-    __asm__ __volatile__("mov %%rsp, %0" : "=r"(sp));
-    stack_bottom = sp;
-    stack_top = ;
+#error "gc: no way to find the stack bounds of a thread on this platform"
 #endif
+    }
+    return gc_stack_top;
+}
+
+static void gc_scan_stack(uintptr_t bottom, uintptr_t top)
+{
+    for (void **word = (void **)(bottom & ~(uintptr_t)(sizeof(void *) - 1)); word < (void **)top; word++)
+    {
+        gc_shade(*word);
+    }
+}
+
+// a thread stopped in gc_occupy_slot may have seen no cycle running and not have set the occupied bit
+// of its slot yet; setting it and the mark here keeps the sweep from handing the slot out again
+static void gc_occupy_stopped(const gc_thread_t *thread)
+{
+    void *slot = __atomic_load_n(&thread->occupying, __ATOMIC_RELAXED);
+    if (!slot)
+    {
+        return;
+    }
+
+    arena_t *arena = arena_of(slot);
+    size_t index;
+    if (bin_slot_index(&bins[arena->bin_index], arena, slot, &index))
+    {
+        uint64_t bit = (uint64_t)1 << (index % 64);
+        __atomic_fetch_or(&arena->occupied[index / 64], bit, __ATOMIC_RELAXED);
+        __atomic_fetch_or(&arena->marks[index / 64], bit, __ATOMIC_RELAXED);
+    }
+}
+
+// greys the registered roots and everything on the stacks, queues .data and .bss; the world is stopped
+__attribute__((noinline)) static void gc_push_roots()
+{
+    for (size_t i = 0; i < gc_roots_count; i++)
+    {
+        gc_shade(gc_roots[i]);
+    }
+
+    gc_push_range(NULL, &__data_start, &_edata);
+    gc_push_range(NULL, &__bss_start, &_end);
+
+    // stacks are scanned right away, a thread may exit and unmap its stack once the world runs again
+    for (gc_thread_t *thread = gc_threads; thread; thread = thread->next)
+    {
+        if (thread->stack_bottom)
+        {
+            gc_occupy_stopped(thread);
+            gc_scan_stack(thread->stack_bottom, thread->stack_top);
+        }
+    }
+
+    // spills the callee-saved registers into this frame, which lies inside the scanned range
+    jmp_buf registers;
+    setjmp(registers);
+    gc_scan_stack((uintptr_t)&registers, gc_thread_stack_top());
+}
+
+static void gc_suspend_handler(int signal)
+{
+    (void)signal;
+    int saved_errno = errno;
+
+    volatile uintptr_t frame = 0;
+    __atomic_store_n(&gc_self.stack_bottom, (uintptr_t)&frame, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&gc_handshakes, 1, __ATOMIC_RELEASE);
+
+    sigset_t wait_mask;
+    sigfillset(&wait_mask);
+    sigdelset(&wait_mask, GC_RESUME_SIGNAL);
+    while (__atomic_load_n(&gc_world_stopped, __ATOMIC_ACQUIRE))
+    {
+        sigsuspend(&wait_mask);
+    }
+
+    __atomic_fetch_add(&gc_handshakes, 1, __ATOMIC_RELEASE);
+    errno = saved_errno;
+}
+
+static void gc_resume_handler(int signal)
+{
+    (void)signal;
+}
+
+static void gc_unlink_thread(gc_thread_t *thread)
+{
+    pthread_mutex_lock(&gc_threads_lock);
+    if (thread->prev)
+    {
+        thread->prev->next = thread->next;
+    }
+    else
+    {
+        gc_threads = thread->next;
+    }
+    if (thread->next)
+    {
+        thread->next->prev = thread->prev;
+    }
+    pthread_mutex_unlock(&gc_threads_lock);
+}
+
+// key destructor, a registered thread that exits without unregistering is removed here
+static void gc_thread_exit(void *arg)
+{
+    if (arg)
+    {
+        gc_unlink_thread((gc_thread_t *)arg);
+    }
+}
+
+static void gc_threads_init()
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaddset(&action.sa_mask, GC_SUSPEND_SIGNAL);
+    sigaddset(&action.sa_mask, GC_RESUME_SIGNAL);
+
+    action.sa_handler = gc_suspend_handler;
+    sigaction(GC_SUSPEND_SIGNAL, &action, NULL);
+    action.sa_handler = gc_resume_handler;
+    sigaction(GC_RESUME_SIGNAL, &action, NULL);
+
+    pthread_key_create(&gc_thread_key, gc_thread_exit);
+}
+
+void gc_register_thread()
+{
+    if (gc_self_registered)
+    {
+        return;
+    }
+
+    pthread_once(&gc_threads_once, gc_threads_init);
+    gc_self.id = pthread_self();
+    gc_self.stack_top = gc_thread_stack_top();
+    gc_self.prev = NULL;
+
+    pthread_mutex_lock(&gc_threads_lock);
+    gc_self.next = gc_threads;
+    if (gc_threads)
+    {
+        gc_threads->prev = &gc_self;
+    }
+    gc_threads = &gc_self;
+    pthread_mutex_unlock(&gc_threads_lock);
+
+    gc_self_registered = true;
+    pthread_setspecific(gc_thread_key, &gc_self);
+}
+
+void gc_unregister_thread()
+{
+    if (!gc_self_registered)
+    {
+        return;
+    }
+
+    gc_unlink_thread(&gc_self);
+    gc_self_registered = false;
+    pthread_setspecific(gc_thread_key, NULL);
+}
+
+// stops every other registered thread, the caller holds all allocator locks
+static void gc_stop_world()
+{
+    pthread_mutex_lock(&gc_threads_lock);
+    __atomic_store_n(&gc_handshakes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&gc_world_stopped, true, __ATOMIC_RELEASE);
+
+    gc_stopped_threads = 0;
+    for (gc_thread_t *thread = gc_threads; thread; thread = thread->next)
+    {
+        thread->stack_bottom = 0;
+        if (!pthread_equal(thread->id, pthread_self()) && !pthread_kill(thread->id, GC_SUSPEND_SIGNAL))
+        {
+            gc_stopped_threads++;
+        }
+    }
+
+    while (__atomic_load_n(&gc_handshakes, __ATOMIC_ACQUIRE) < gc_stopped_threads)
+    {
+        sched_yield();
+    }
+}
+
+static void gc_start_world()
+{
+    __atomic_store_n(&gc_handshakes, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&gc_world_stopped, false, __ATOMIC_RELEASE);
 
-    for (uintptr_t *ptr = (uintptr_t *)stack_bottom;
-         ptr < (uintptr_t *)stack_top;
-         ptr++)
+    for (gc_thread_t *thread = gc_threads; thread; thread = thread->next)
     {
-        mark_object((void *)*ptr);
+        if (thread->stack_bottom)
+        {
+            pthread_kill(thread->id, GC_RESUME_SIGNAL);
+        }
+    }
+
+    // waiting for every thread to leave its handler keeps a quick next stop from being missed
+    while (__atomic_load_n(&gc_handshakes, __ATOMIC_ACQUIRE) < gc_stopped_threads)
+    {
+        sched_yield();
+    }
+    pthread_mutex_unlock(&gc_threads_lock);
+}
+
+// scans one grey range, handing the part beyond GC_MARK_SLICE words back to the deque for thieves
+static void gc_scan_range(gc_range_t range)
+{
+    if (range.arena && find_arena(range.arena) != range.arena)
+    {
+        return;
+    }
+
+    if (range.end - range.begin > GC_MARK_SLICE &&
+        gc_deque_push(gc_local_deque, (gc_range_t){range.begin + GC_MARK_SLICE, range.end, range.arena}))
+    {
+        range.end = range.begin + GC_MARK_SLICE;
     }
 
-    for (void **ptr = (void **)&__data_start;
-         ptr < (void **)&_edata;
-         ptr++)
+    for (void **word = range.begin; word < range.end; word++)
     {
-        mark_object(*ptr);
+        gc_shade(*word);
     }
+}
+
+static void gc_mark_worker(size_t index)
+{
+    gc_deque_t *own = &gc_deques[index];
+    gc_local_deque = own;
 
-    for (void **ptr = (void **)&__bss_start;
-         ptr < (void **)&_end;
-         ptr++)
+    for (;;)
     {
-        mark_object(*ptr);
+        gc_range_t range;
+        bool found = gc_deque_pop(own, &range);
+        for (size_t i = 1; !found && i < gc_active_markers; i++)
+        {
+            found = gc_deque_steal(&gc_deques[(index + i) % gc_active_markers], &range);
+        }
+        if (found)
+        {
+            gc_scan_range(range);
+            continue;
+        }
+
+        // an idle marker's own deque is empty, so once every marker is idle no work is left anywhere
+        __atomic_fetch_add(&gc_idle_markers, 1, __ATOMIC_SEQ_CST);
+        for (;;)
+        {
+            if (__atomic_load_n(&gc_idle_markers, __ATOMIC_SEQ_CST) == gc_active_markers)
+            {
+                gc_local_deque = NULL;
+                return;
+            }
+
+            bool work = false;
+            for (size_t i = 0; !work && i < gc_active_markers; i++)
+            {
+                work = !gc_deque_empty(&gc_deques[i]);
+            }
+            if (work)
+            {
+                __atomic_fetch_sub(&gc_idle_markers, 1, __ATOMIC_SEQ_CST);
+                break;
+            }
+            sched_yield();
+        }
+    }
+}
+
+static void *gc_marker_main(void *arg)
+{
+    size_t index = (size_t)(uintptr_t)arg;
+    unsigned long seen = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&gc_marker_lock);
+        while (gc_mark_round == seen)
+        {
+            pthread_cond_wait(&gc_marker_wake, &gc_marker_lock);
+        }
+        seen = gc_mark_round;
+        bool active = index < gc_active_markers;
+        pthread_mutex_unlock(&gc_marker_lock);
+
+        if (active)
+        {
+            gc_mark_worker(index);
+        }
+
+        pthread_mutex_lock(&gc_marker_lock);
+        gc_helpers_finished++;
+        pthread_cond_signal(&gc_marker_done);
+        pthread_mutex_unlock(&gc_marker_lock);
+    }
+    return NULL;
+}
+
+void gc_set_marker_threads(size_t count)
+{
+    pthread_mutex_lock(&gc_marker_lock);
+    gc_requested_markers = count;
+    pthread_mutex_unlock(&gc_marker_lock);
+}
+
+// brings the helper pool up to the requested size, thread creation allocates so it runs before any lock is taken
+static void gc_start_markers()
+{
+    pthread_mutex_lock(&gc_marker_lock);
+
+    size_t wanted = gc_requested_markers;
+    if (!wanted)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        wanted = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (wanted > GC_MAX_MARKERS)
+    {
+        wanted = GC_MAX_MARKERS;
+    }
+
+    size_t ready = 0;
+    while (ready < wanted)
+    {
+        gc_deque_t *deque = &gc_deques[ready];
+        if (!deque->buffer)
+        {
+            gc_range_t *buffer = mmap(NULL, GC_DEQUE_CAPACITY * sizeof(gc_range_t), PROT_READ | PROT_WRITE,
+                                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (buffer == MAP_FAILED)
+            {
+                break;
+            }
+            deque->buffer = buffer;
+        }
+
+        if (ready > gc_helpers_started)
+        {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, gc_marker_main, (void *)(uintptr_t)ready))
+            {
+                break;
+            }
+            pthread_detach(thread);
+            gc_helpers_started++;
+        }
+        ready++;
+    }
+    gc_ready_markers = ready ? ready : 1;
+
+    pthread_mutex_unlock(&gc_marker_lock);
+}
+
+// drains the mark stack with every active marker, the caller holds the heap
+static void gc_drain_parallel()
+{
+    pthread_mutex_lock(&gc_marker_lock);
+    gc_active_markers = gc_ready_markers;
+    pthread_mutex_unlock(&gc_marker_lock);
+
+    if (gc_active_markers <= 1)
+    {
+        gc_drain(SIZE_MAX);
+        return;
+    }
+
+    while (gc_mark_stack_size)
+    {
+        // deal the shared stack out round robin, whatever does not fit waits for the next round
+        for (size_t i = 0; gc_mark_stack_size; i = (i + 1) % gc_active_markers)
+        {
+            if (!gc_deque_push(&gc_deques[i], gc_mark_stack[gc_mark_stack_size - 1]))
+            {
+                break;
+            }
+            gc_mark_stack_size--;
+        }
+
+        pthread_mutex_lock(&gc_marker_lock);
+        __atomic_store_n(&gc_idle_markers, 0, __ATOMIC_SEQ_CST);
+        gc_helpers_finished = 0;
+        gc_mark_round++;
+        pthread_cond_broadcast(&gc_marker_wake);
+        pthread_mutex_unlock(&gc_marker_lock);
+
+        gc_mark_worker(0);
+
+        pthread_mutex_lock(&gc_marker_lock);
+        while (gc_helpers_finished < gc_helpers_started)
+        {
+            pthread_cond_wait(&gc_marker_done, &gc_marker_lock);
+        }
+        pthread_mutex_unlock(&gc_marker_lock);
+    }
+}
+
+// rescans every marked object, needed after a grey range was dropped, the caller holds arena_lock
+static void gc_rescan_marked()
+{
+    for (arena_t *arena = heap_arenas; arena; arena = arena->next)
+    {
+        for (size_t word = 0; word < HEAP_START_BITMAP_SIZE / sizeof(uint64_t); word++)
+        {
+            uint64_t marked = arena->occupied[word] & arena->marks[word];
+            while (marked)
+            {
+                size_t granule = word * 64 + (size_t)__builtin_ctzll(marked);
+                marked &= marked - 1;
+                void *ptr = (uint8_t *)arena + granule * CHUNK_GRANULE;
+                gc_push_range(arena, ptr, chunk_next(find_heap_chunk(arena, ptr)));
+            }
+        }
+    }
+
+    for (size_t b = 0; b < BIN_COUNT; b++)
+    {
+        bin_t *bin = &bins[b];
+        for (arena_t *arena = bin->arenas; arena; arena = arena->next)
+        {
+            for (size_t word = 0; word < (bin->capacity + 63) / 64; word++)
+            {
+                uint64_t marked = __atomic_load_n(&arena->occupied[word], __ATOMIC_RELAXED) & arena->marks[word];
+                while (marked)
+                {
+                    size_t slot = word * 64 + (size_t)__builtin_ctzll(marked);
+                    marked &= marked - 1;
+                    uint8_t *ptr = (uint8_t *)arena + bin->slots_offset + slot * bin->slot_size;
+                    gc_push_range(arena, ptr, ptr + bin->slot_size);
+                }
+            }
+        }
+    }
+
+    for (arena_t *arena = huge_arenas; arena; arena = arena->next)
+    {
+        if (arena->mark)
+        {
+            void **ptr = (void **)((uint8_t *)arena + ARENA_HEADER_SIZE);
+            gc_push_range(arena, ptr, ptr + arena->usable_size / sizeof(void *));
+        }
+    }
+}
+
+// the only unbounded pause of a cycle: rescans the roots and finishes marking, the world is stopped
+static void gc_finish_mark_stopped()
+{
+    gc_push_roots();
+    gc_drain_parallel();
+
+    while (__atomic_load_n(&gc_mark_overflow, __ATOMIC_RELAXED))
+    {
+        __atomic_store_n(&gc_mark_overflow, false, __ATOMIC_RELAXED);
+        gc_rescan_marked();
+        gc_drain_parallel();
+    }
+
+    // every arena alive now gets swept, the ones mapped from here on start out clean
+    for (arena_t *arena = heap_arenas; arena; arena = arena->next)
+    {
+        arena->swept = false;
+    }
+    for (size_t b = 0; b < BIN_COUNT; b++)
+    {
+        for (arena_t *arena = bins[b].arenas; arena; arena = arena->next)
+        {
+            __atomic_store_n(&arena->swept, false, __ATOMIC_RELAXED);
+        }
+    }
+    for (arena_t *arena = huge_arenas; arena; arena = arena->next)
+    {
+        arena->swept = false;
+    }
+
+    gc_sweep_list = 0;
+    gc_sweep_cursor = heap_arenas;
+    __atomic_store_n(&gc_phase, GC_PHASE_SWEEP, __ATOMIC_SEQ_CST);
+}
+
+// huge_alloc reads the phase under arena_lock, holding it keeps the switch to sweeping atomic for it
+static void gc_finish_mark()
+{
+    pthread_mutex_lock(&arena_lock);
+    gc_stop_world();
+    gc_finish_mark_stopped();
+    gc_start_world();
+    pthread_mutex_unlock(&arena_lock);
+}
+
+// frees the white chunks of a heap arena, returns the work done
+static size_t gc_sweep_heap_arena(arena_t *arena)
+{
+    size_t work = HEAP_START_BITMAP_SIZE / sizeof(uint64_t);
+
+    for (size_t word = 0; word < HEAP_START_BITMAP_SIZE / sizeof(uint64_t); word++)
+    {
+        uint64_t dead = arena->occupied[word] & ~arena->marks[word];
+        arena->marks[word] = 0;
+        while (dead)
+        {
+            size_t granule = word * 64 + (size_t)__builtin_ctzll(dead);
+            dead &= dead - 1;
+            heap_chunk_t *chunk = (heap_chunk_t *)((uint8_t *)arena + granule * CHUNK_GRANULE - CHUNK_HEADER_SIZE);
+            stats_free(chunk_size(chunk) - CHUNK_HEADER_SIZE);
+            heap_chunk_free(chunk);
+            work += GC_SWEEP_FREE_COST;
+        }
+    }
+
+    arena->swept = true;
+    if (release_empty_heap_arena(arena))
+    {
+        work += ARENA_SIZE >> GC_UNMAP_COST_SHIFT;
+    }
+    return work;
+}
+
+static size_t gc_sweep_slab_arena(bin_t *bin, arena_t *arena)
+{
+    size_t words = (bin->capacity + 63) / 64;
+    size_t work = words;
+    bool empty = false;
+
+    for (size_t word = 0; word < words; word++)
+    {
+        uint64_t dead = __atomic_load_n(&arena->occupied[word], __ATOMIC_RELAXED) &
+                        ~__atomic_exchange_n(&arena->marks[word], 0, __ATOMIC_RELAXED);
+        if (dead)
+        {
+            // a slot its owner frees meanwhile is left to bin_free
+            dead &= __atomic_fetch_and(&arena->occupied[word], ~dead, __ATOMIC_RELAXED);
+        }
+        while (dead)
+        {
+            size_t slot = word * 64 + (size_t)__builtin_ctzll(dead);
+            dead &= dead - 1;
+            empty = bin_push(bin, arena, (uint8_t *)arena + bin->slots_offset + slot * bin->slot_size);
+            stats_free(bin->slot_size);
+            work += GC_SWEEP_FREE_COST;
+        }
+    }
+
+    __atomic_store_n(&arena->swept, true, __ATOMIC_RELAXED);
+    if (empty)
+    {
+        release_slab_arena(bin, arena);
+        work += ARENA_SIZE >> GC_UNMAP_COST_SHIFT;
+    }
+    return work;
+}
+
+static size_t gc_sweep_huge_arena(arena_t *arena)
+{
+    arena->swept = true;
+    if (!arena->mark)
+    {
+        size_t work = GC_SWEEP_FREE_COST + (arena->map_size >> GC_UNMAP_COST_SHIFT);
+        huge_free(arena);
+        return work;
+    }
+    arena->mark = false;
+    return 1;
+}
+
+// sweeps whole arenas until the budget is spent, returns true once every list is done
+static bool gc_sweep(size_t budget)
+{
+    while (budget)
+    {
+        arena_t *arena = gc_sweep_cursor;
+        if (!arena)
+        {
+            if (++gc_sweep_list > BIN_COUNT + 1)
+            {
+                return true;
+            }
+
+            if (gc_sweep_list <= BIN_COUNT)
+            {
+                gc_sweep_cursor = bins[gc_sweep_list - 1].arenas;
+            }
+            else
+            {
+                pthread_mutex_lock(&arena_lock);
+                gc_sweep_cursor = huge_arenas;
+                pthread_mutex_unlock(&arena_lock);
+            }
+            continue;
+        }
+
+        // released arenas advance the cursor themselves, see gc_unlink_arena
+        gc_sweep_cursor = arena->next;
+        if (arena->swept)
+        {
+            continue;
+        }
+
+        size_t work;
+        if (gc_sweep_list == 0)
+        {
+            work = gc_sweep_heap_arena(arena);
+        }
+        else if (gc_sweep_list <= BIN_COUNT)
+        {
+            work = gc_sweep_slab_arena(&bins[gc_sweep_list - 1], arena);
+        }
+        else
+        {
+            work = gc_sweep_huge_arena(arena);
+        }
+        budget = work < budget ? budget - work : 0;
+    }
+    return false;
+}
+
+// one bounded step of the current cycle, starting a cycle when none runs, the caller holds the heap
+static bool gc_advance(size_t budget)
+{
+    switch (gc_phase)
+    {
+    case GC_PHASE_IDLE:
+        __atomic_store_n(&gc_phase, GC_PHASE_MARK, __ATOMIC_SEQ_CST);
+        gc_stop_world();
+        gc_push_roots();
+        gc_start_world();
+        return false;
+    case GC_PHASE_MARK:
+        if (!gc_drain(budget) || gc_mark_stack_size)
+        {
+            return false;
+        }
+        gc_finish_mark();
+        return false;
+    case GC_PHASE_SWEEP:
+        if (!gc_sweep(budget))
+        {
+            return false;
+        }
+        __atomic_store_n(&gc_phase, GC_PHASE_IDLE, __ATOMIC_RELAXED);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool gc_step()
+{
+    heap_init();
+    gc_start_markers();
+    gc_lock_heap();
+    bool finished = gc_advance(gc_step_budget);
+    gc_unlock_heap();
+    return finished;
+}
+
+void gc_write_barrier(void *value)
+{
+    if (__atomic_load_n(&gc_phase, __ATOMIC_RELAXED) != GC_PHASE_MARK)
+    {
+        return;
+    }
+
+    gc_lock_heap();
+    if (gc_phase == GC_PHASE_MARK)
+    {
+        gc_shade(value);
+    }
+    gc_unlock_heap();
+}
+
+// stop-the-world collection: finishes a cycle in progress, then runs a complete one
+void gc_collect()
+{
+    heap_init();
+    gc_start_markers();
+    gc_lock_heap();
+
+    if (gc_phase == GC_PHASE_MARK)
+    {
+        gc_finish_mark();
+    }
+    if (gc_phase == GC_PHASE_SWEEP)
+    {
+        gc_sweep(SIZE_MAX);
+        __atomic_store_n(&gc_phase, GC_PHASE_IDLE, __ATOMIC_RELAXED);
+    }
+
+    // marks in one pause, the registered threads stay stopped from the first root to the last object
+    pthread_mutex_lock(&arena_lock);
+    gc_stop_world();
+    __atomic_store_n(&gc_phase, GC_PHASE_MARK, __ATOMIC_SEQ_CST);
+    gc_finish_mark_stopped();
+    gc_start_world();
+    pthread_mutex_unlock(&arena_lock);
+
+    gc_sweep(SIZE_MAX);
+    __atomic_store_n(&gc_phase, GC_PHASE_IDLE, __ATOMIC_RELAXED);
+
+    gc_unlock_heap();
+}
+
+// allocations made while marking, or in an arena the sweep has not reached yet, must survive the cycle
+static inline bool gc_allocate_black(const arena_t *arena)
+{
+    gc_phase_t phase = __atomic_load_n(&gc_phase, __ATOMIC_RELAXED);
+    return phase == GC_PHASE_MARK || (phase == GC_PHASE_SWEEP && !__atomic_load_n(&arena->swept, __ATOMIC_RELAXED));
+}
+
+static inline void gc_shade_new(arena_t *arena, size_t index)
+{
+    if (gc_allocate_black(arena))
+    {
+        __atomic_fetch_or(&arena->marks[index / 64], (uint64_t)1 << (index % 64), __ATOMIC_RELAXED);
+    }
+}
+
+// magazines hand out slots without the bin lock; during a cycle the slot and its mark are set under it
+// so that a sweep holding the lock never sees an occupied slot that is not shaded yet. A stop of the
+// world can fall between the phase check and the bit, so the slot is recorded for gc_occupy_stopped
+static inline void gc_occupy_slot(bin_t *bin, arena_t *arena, size_t index)
+{
+    uint64_t bit = (uint64_t)1 << (index % 64);
+    void *slot = (uint8_t *)arena + bin->slots_offset + index * bin->slot_size;
+    __atomic_store_n(&gc_self.occupying, slot, __ATOMIC_RELAXED);
+    __atomic_signal_fence(__ATOMIC_SEQ_CST); // read by the collector once the suspend handler ran on this thread
+
+    if (__atomic_load_n(&gc_phase, __ATOMIC_SEQ_CST) == GC_PHASE_IDLE)
+    {
+        __atomic_fetch_or(&arena->occupied[index / 64], bit, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&gc_phase, __ATOMIC_SEQ_CST) == GC_PHASE_IDLE)
+        {
+            __atomic_signal_fence(__ATOMIC_SEQ_CST);
+            __atomic_store_n(&gc_self.occupying, NULL, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    pthread_mutex_lock(&bin->lock);
+    __atomic_fetch_or(&arena->occupied[index / 64], bit, __ATOMIC_RELAXED);
+    gc_shade_new(arena, index);
+    pthread_mutex_unlock(&bin->lock);
+
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    __atomic_store_n(&gc_self.occupying, NULL, __ATOMIC_RELAXED);
+}
+
+// a moving realloc copies references the barrier never saw into a black object, so the copy is scanned
+static void gc_rescan_moved(void *ptr, size_t size)
+{
+    if (__atomic_load_n(&gc_phase, __ATOMIC_RELAXED) != GC_PHASE_MARK)
+    {
+        return;
+    }
+
+    gc_lock_heap();
+    if (gc_phase == GC_PHASE_MARK)
+    {
+        gc_push_range(find_arena(ptr), ptr, (void **)ptr + size / sizeof(void *));
+    }
+    gc_unlock_heap();
+}
+
+// called before an arena leaves its list so the sweep cursor never points at it
+static inline void gc_unlink_arena(arena_t *arena)
+{
+    if (gc_sweep_cursor == arena)
+    {
+        gc_sweep_cursor = arena->next;
+    }
+}
+
+#else
+
+static inline bool gc_allocate_black(const arena_t *arena)
+{
+    (void)arena;
+    return false;
+}
+
+static inline void gc_rescan_moved(void *ptr, size_t size)
+{
+    (void)ptr;
+    (void)size;
+}
+
+static inline void gc_occupy_slot(bin_t *bin, arena_t *arena, size_t index)
+{
+    (void)bin;
+    __atomic_fetch_or(&arena->occupied[index / 64], (uint64_t)1 << (index % 64), __ATOMIC_RELAXED);
+}
+
+static inline void gc_unlink_arena(arena_t *arena)
+{
+    (void)arena;
+}
+
+#endif // GC_COLLECT
+
+/* Statistics */
+
+// folds the counters of an exiting thread into the retired totals
+static void retire_thread_stats(void *arg)
+{
+    thread_stats_t *stats = (thread_stats_t *)arg;
+
+    pthread_mutex_lock(&stats_lock);
+    retired_stats.allocs += stats->allocs;
+    retired_stats.frees += stats->frees;
+    retired_stats.reallocs += stats->reallocs;
+    retired_stats.failed_allocs += stats->failed_allocs;
+    retired_stats.coalesces += stats->coalesces;
+    for (size_t c = 0; c < HEAP_STATS_CLASS_COUNT; c++)
+    {
+        retired_stats.live_by_class[c] += stats->live_by_class[c];
+    }
+    __atomic_add_fetch(&stats_bytes_in_use, (size_t)stats->pending_bytes, __ATOMIC_RELAXED);
+
+    if (stats->prev)
+    {
+        stats->prev->next = stats->next;
+    }
+    else
+    {
+        stats_threads = stats->next;
+    }
+    if (stats->next)
+    {
+        stats->next->prev = stats->prev;
+    }
+    pthread_mutex_unlock(&stats_lock);
+
+    // a destructor running after this one may still allocate, which registers the thread again
+    memset(stats, 0, sizeof(*stats));
+    thread_stats_registered = false;
+}
+
+static void create_thread_stats_key()
+{
+    pthread_key_create(&thread_stats_key, retire_thread_stats);
+}
+
+// kept out of line, every allocation path checks for it
+__attribute__((noinline, cold)) static void register_thread_stats()
+{
+    thread_stats_registered = true;
+    pthread_once(&thread_stats_key_once, create_thread_stats_key);
+
+    pthread_mutex_lock(&stats_lock);
+    thread_stats.prev = NULL;
+    thread_stats.next = stats_threads;
+    if (stats_threads)
+    {
+        stats_threads->prev = &thread_stats;
+    }
+    stats_threads = &thread_stats;
+    pthread_mutex_unlock(&stats_lock);
+
+    pthread_setspecific(thread_stats_key, &thread_stats);
+}
+
+static inline thread_stats_t *get_thread_stats()
+{
+    if (!thread_stats_registered)
+    {
+        register_thread_stats();
+    }
+    return &thread_stats;
+}
+
+// only the owning thread writes its counters, so a relaxed load and store is enough and costs no bus lock
+static inline void stats_add(uint64_t *counter, uint64_t count)
+{
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + count, __ATOMIC_RELAXED);
+}
+
+static inline void stats_bytes(thread_stats_t *stats, int64_t change)
+{
+    int64_t pending = __atomic_load_n(&stats->pending_bytes, __ATOMIC_RELAXED) + change;
+    if (pending >= -STATS_FLUSH_BYTES && pending <= STATS_FLUSH_BYTES)
+    {
+        __atomic_store_n(&stats->pending_bytes, pending, __ATOMIC_RELAXED);
+        return;
+    }
+
+    // the peak is therefore exact to within STATS_FLUSH_BYTES per thread
+    __atomic_store_n(&stats->pending_bytes, 0, __ATOMIC_RELAXED);
+    size_t total = __atomic_add_fetch(&stats_bytes_in_use, (size_t)pending, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&stats_peak_bytes, __ATOMIC_RELAXED);
+    while (total > peak &&
+           !__atomic_compare_exchange_n(&stats_peak_bytes, &peak, total, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+static inline void stats_alloc(size_t size)
+{
+    thread_stats_t *stats = get_thread_stats();
+    stats_add(&stats->allocs, 1);
+    stats_add(&stats->live_by_class[heap_stats_class(size)], 1);
+    stats_bytes(stats, (int64_t)size);
+}
+
+static inline void stats_free(size_t size)
+{
+    thread_stats_t *stats = get_thread_stats();
+    stats_add(&stats->frees, 1);
+    stats_add(&stats->live_by_class[heap_stats_class(size)], (uint64_t)-1);
+    stats_bytes(stats, -(int64_t)size);
+}
+
+// a live allocation that grew or shrank in place
+static inline void stats_resize(size_t old_size, size_t new_size)
+{
+    thread_stats_t *stats = get_thread_stats();
+    stats_add(&stats->live_by_class[heap_stats_class(old_size)], (uint64_t)-1);
+    stats_add(&stats->live_by_class[heap_stats_class(new_size)], 1);
+    stats_bytes(stats, (int64_t)new_size - (int64_t)old_size);
+}
+
+static void stats_sum(heap_stats_t *total, const thread_stats_t *stats, int64_t *pending_bytes)
+{
+    total->allocs += __atomic_load_n(&stats->allocs, __ATOMIC_RELAXED);
+    total->frees += __atomic_load_n(&stats->frees, __ATOMIC_RELAXED);
+    total->reallocs += __atomic_load_n(&stats->reallocs, __ATOMIC_RELAXED);
+    total->failed_allocs += __atomic_load_n(&stats->failed_allocs, __ATOMIC_RELAXED);
+    total->coalesces += __atomic_load_n(&stats->coalesces, __ATOMIC_RELAXED);
+    for (size_t c = 0; c < HEAP_STATS_CLASS_COUNT; c++)
+    {
+        total->live_by_class[c] += __atomic_load_n(&stats->live_by_class[c], __ATOMIC_RELAXED);
+    }
+    *pending_bytes += __atomic_load_n(&stats->pending_bytes, __ATOMIC_RELAXED);
+}
+
+// lower bound of the highest non-empty free list, within one second level class of the largest chunk, the caller holds heap_lock
+static size_t largest_free_chunk()
+{
+    if (!free_fl_bitmap)
+    {
+        return 0;
+    }
+
+    size_t fl = (sizeof(unsigned int) * 8 - 1) - (size_t)__builtin_clz(free_fl_bitmap);
+    size_t sl = (sizeof(unsigned int) * 8 - 1) - (size_t)__builtin_clz(free_sl_bitmap[fl]);
+    size_t size = fl ? ((size_t)TLSF_SL_COUNT + sl) << (fl + TLSF_FL_SHIFT - 1 - TLSF_SL_BITS)
+                     : sl << CHUNK_GRANULE_SHIFT;
+    return size - CHUNK_HEADER_SIZE;
+}
+
+void heap_stats_snapshot(heap_stats_t *stats)
+{
+    heap_init();
+    memset(stats, 0, sizeof(*stats));
+
+    int64_t pending_bytes = 0;
+    pthread_mutex_lock(&stats_lock);
+    stats_sum(stats, &retired_stats, &pending_bytes);
+    for (thread_stats_t *thread = stats_threads; thread; thread = thread->next)
+    {
+        stats_sum(stats, thread, &pending_bytes);
+    }
+    pthread_mutex_unlock(&stats_lock);
+
+    stats->bytes_in_use = __atomic_load_n(&stats_bytes_in_use, __ATOMIC_RELAXED) + (size_t)pending_bytes;
+    stats->peak_bytes_in_use = __atomic_load_n(&stats_peak_bytes, __ATOMIC_RELAXED);
+    if (stats->bytes_in_use > stats->peak_bytes_in_use)
+    {
+        stats->peak_bytes_in_use = stats->bytes_in_use;
+    }
+    stats->bytes_mapped = __atomic_load_n(&stats_bytes_mapped, __ATOMIC_RELAXED);
+
+    // a handful of loads under heap_lock, the free lists themselves are not walked
+    pthread_mutex_lock(&heap_lock);
+    stats->bytes_free = free_chunk_bytes;
+    stats->largest_free_block = largest_free_chunk();
+    pthread_mutex_unlock(&heap_lock);
+    stats->fragmentation = heap_stats_fragmentation(stats->bytes_free, stats->largest_free_block);
+}
+
+/* Arena management */
+
+// maps size bytes aligned to ARENA_SIZE by over-mapping and trimming the excess
+static arena_t *map_arena(size_t size)
+{
+    size = (size + ARENA_SIZE - 1) & ~(ARENA_SIZE - 1);
+    uint8_t *raw = mmap(NULL, size + ARENA_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)raw + ARENA_SIZE - 1) & ~(uintptr_t)(ARENA_SIZE - 1));
+    if (aligned != raw)
+    {
+        munmap(raw, aligned - raw);
+    }
+    if (aligned + size != raw + size + ARENA_SIZE)
+    {
+        munmap(aligned + size, (raw + size + ARENA_SIZE) - (aligned + size));
+    }
+
+    arena_t *arena = (arena_t *)aligned;
+    arena->map_size = size;
+    __atomic_add_fetch(&stats_bytes_mapped, size, __ATOMIC_RELAXED);
+    return arena;
+}
+
+// the caller holds arena_lock
+static void register_arena(arena_t *arena, bool owned)
+{
+    uintptr_t key = (uintptr_t)arena >> ARENA_SHIFT;
+    uint8_t *leaf = arena_map[key >> ARENA_MAP_LEAF_BITS];
+    if (!leaf)
+    {
+        if (!owned)
+        {
+            return;
+        }
+
+        leaf = mmap(NULL, (size_t)1 << ARENA_MAP_LEAF_BITS, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (leaf == MAP_FAILED)
+        {
+            return;
+        }
+        __atomic_store_n(&arena_map[key >> ARENA_MAP_LEAF_BITS], leaf, __ATOMIC_RELEASE);
+    }
+
+    __atomic_store_n(&leaf[key & (((uintptr_t)1 << ARENA_MAP_LEAF_BITS) - 1)], owned, __ATOMIC_RELEASE);
+}
+
+// arena of a pointer already known to be ours
+static inline arena_t *arena_of(const void *ptr)
+{
+    return (arena_t *)((uintptr_t)ptr & ~(uintptr_t)(ARENA_SIZE - 1));
+}
+
+static inline arena_t *find_arena(const void *ptr)
+{
+    uintptr_t key = (uintptr_t)ptr >> ARENA_SHIFT;
+    if (key >> ARENA_MAP_BITS)
+    {
+        return NULL;
+    }
+
+    uint8_t *leaf = __atomic_load_n(&arena_map[key >> ARENA_MAP_LEAF_BITS], __ATOMIC_ACQUIRE);
+    if (!leaf || !__atomic_load_n(&leaf[key & (((uintptr_t)1 << ARENA_MAP_LEAF_BITS) - 1)], __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    return arena_of(ptr);
+}
+
+// returns an ARENA_SIZE arena, reusing a cached one when possible
+static arena_t *acquire_arena()
+{
+    pthread_mutex_lock(&arena_lock);
+
+    arena_t *arena = cached_arenas;
+    if (arena)
+    {
+        cached_arenas = arena->next;
+        cached_arena_count--;
+    }
+    else
+    {
+        arena = map_arena(ARENA_SIZE);
+    }
+
+    if (arena)
+    {
+        register_arena(arena, true);
+    }
+
+    pthread_mutex_unlock(&arena_lock);
+    return arena;
+}
+
+// keeps up to arena_retention fully free arenas mapped, unmaps the rest
+static void release_arena(arena_t *arena)
+{
+    pthread_mutex_lock(&arena_lock);
+
+    register_arena(arena, false);
+    if (arena->map_size == ARENA_SIZE && cached_arena_count < arena_retention)
+    {
+        arena->type = ALLOC_TYPE_NONE;
+        arena->next = cached_arenas;
+        cached_arenas = arena;
+        cached_arena_count++;
+    }
+    else
+    {
+        __atomic_sub_fetch(&stats_bytes_mapped, arena->map_size, __ATOMIC_RELAXED);
+        munmap(arena, arena->map_size);
+    }
+
+    pthread_mutex_unlock(&arena_lock);
+}
+
+void heap_set_arena_retention(size_t arena_count)
+{
+    pthread_mutex_lock(&arena_lock);
+
+    arena_retention = arena_count;
+    while (cached_arena_count > arena_retention)
+    {
+        arena_t *arena = cached_arenas;
+        cached_arenas = arena->next;
+        cached_arena_count--;
+        __atomic_sub_fetch(&stats_bytes_mapped, arena->map_size, __ATOMIC_RELAXED);
+        munmap(arena, arena->map_size);
+    }
+
+    pthread_mutex_unlock(&arena_lock);
+}
+
+/* Slab arenas */
+
+static void init_slab_arena(arena_t *arena, size_t bin_index)
+{
+    bin_t *bin = &bins[bin_index];
+    size_t bitmap_words = (bin->capacity + 63) / 64;
+
+    arena->type = ALLOC_TYPE_BIN;
+    arena->bin_index = bin_index;
+    arena->next_partial = arena->prev_partial = NULL;
+    arena->in_partial = false;
+    arena->untouched = 0;
+    arena->live = 0;
+    arena->free_list = NULL;
+    arena->occupied = (uint64_t *)((uint8_t *)arena + ARENA_HEADER_SIZE);
+    arena->marks = arena->occupied + bitmap_words;
+    arena->swept = true;
+    memset(arena->occupied, 0, 2 * bitmap_words * sizeof(uint64_t));
+}
+
+static inline bin_t *find_bin_for_size(size_t size, alignment_t alignment)
+{
+    if (size > BIN_MAX_SIZE)
+    {
+        return NULL;
+    }
+
+    // slots are only aligned to their own size, so a stricter alignment moves up a class
+    for (size_t b = bin_lookup[(size + 7) / 8]; b < BIN_COUNT; b++)
+    {
+        if (bins[b].slot_alignment >= (size_t)alignment)
+        {
+            return &bins[b];
+        }
+    }
+    return NULL;
+}
+
+static inline bool bin_slot_index(const bin_t *bin, const arena_t *arena, const void *ptr, size_t *index)
+{
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)arena - bin->slots_offset;
+    if (offset >= bin->capacity * bin->slot_size)
+    {
+        return false;
+    }
+
+    size_t slot = (size_t)((offset * bin->slot_reciprocal) >> 32);
+    if (slot * bin->slot_size != offset)
+    {
+        return false; // interior pointer
+    }
+
+    *index = slot;
+    return true;
+}
+
+static void add_to_partial(bin_t *bin, arena_t *arena)
+{
+    arena->in_partial = true;
+    arena->prev_partial = NULL;
+    arena->next_partial = bin->partial;
+    if (bin->partial)
+    {
+        bin->partial->prev_partial = arena;
+    }
+    bin->partial = arena;
+}
+
+static void remove_from_partial(bin_t *bin, arena_t *arena)
+{
+    if (arena->prev_partial)
+    {
+        arena->prev_partial->next_partial = arena->next_partial;
+    }
+    else
+    {
+        bin->partial = arena->next_partial;
+    }
+    if (arena->next_partial)
+    {
+        arena->next_partial->prev_partial = arena->prev_partial;
+    }
+    arena->in_partial = false;
+}
+
+// central pool operations, the caller holds bin->lock
+static void *bin_pop(bin_t *bin)
+{
+    arena_t *arena = bin->partial;
+    if (!arena)
+    {
+        arena = acquire_arena();
+        if (!arena)
+        {
+            return NULL;
+        }
+
+        init_slab_arena(arena, bin - bins);
+        arena->prev = NULL;
+        arena->next = bin->arenas;
+        if (bin->arenas)
+        {
+            bin->arenas->prev = arena;
+        }
+        bin->arenas = arena;
+        add_to_partial(bin, arena);
+    }
+
+    bin_slot_t *slot = arena->free_list;
+    if (slot)
+    {
+        arena->free_list = slot->next;
+    }
+    else
+    {
+        slot = (bin_slot_t *)((uint8_t *)arena + bin->slots_offset + arena->untouched++ * bin->slot_size);
+    }
+
+    if (++arena->live == bin->capacity)
+    {
+        remove_from_partial(bin, arena);
+    }
+    return slot;
+}
+
+// returns true when the arena no longer holds any live slot
+static bool bin_push(bin_t *bin, arena_t *arena, void *ptr)
+{
+    bin_slot_t *slot = (bin_slot_t *)ptr;
+    slot->next = arena->free_list;
+    arena->free_list = slot;
+
+    if (!arena->in_partial)
+    {
+        add_to_partial(bin, arena);
+    }
+    return --arena->live == 0;
+}
+
+static void release_slab_arena(bin_t *bin, arena_t *arena)
+{
+    gc_unlink_arena(arena);
+    remove_from_partial(bin, arena);
+    if (arena->prev)
+    {
+        arena->prev->next = arena->next;
+    }
+    else
+    {
+        bin->arenas = arena->next;
+    }
+    if (arena->next)
+    {
+        arena->next->prev = arena->prev;
+    }
+
+    release_arena(arena);
+}
+
+static void create_magazine_key()
+{
+    pthread_key_create(&magazine_key, flush_magazines);
+}
+
+static magazine_t *get_magazines()
+{
+    if (!magazines_registered)
+    {
+        // the key destructor hands cached slots back to the central pools when the thread exits
+        magazines_registered = true;
+        pthread_once(&magazine_key_once, create_magazine_key);
+        pthread_setspecific(magazine_key, magazines);
+    }
+    return magazines;
+}
+
+static void flush_magazines(void *arg)
+{
+    magazine_t *thread_magazines = (magazine_t *)arg;
+    for (size_t b = 0; b < BIN_COUNT; b++)
+    {
+        magazine_t *magazine = &thread_magazines[b];
+        if (!magazine->count)
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&bins[b].lock);
+        while (magazine->count)
+        {
+            void *ptr = magazine->slots[--magazine->count];
+            arena_t *arena = arena_of(ptr);
+            if (bin_push(&bins[b], arena, ptr))
+            {
+                release_slab_arena(&bins[b], arena);
+            }
+        }
+        pthread_mutex_unlock(&bins[b].lock);
     }
 }
 
-static void sweep()
+static void *bin_alloc(bin_t *bin)
 {
-    for (size_t i = 0; i < alloc_array_size; i++)
+    magazine_t *magazine = &get_magazines()[bin - bins];
+
+    if (!magazine->count)
     {
-        if (!alloc_array[i].mark)
+        pthread_mutex_lock(&bin->lock);
+        while (magazine->count < MAGAZINE_BATCH)
         {
-            heap_free(alloc_array[i].data_ptr);
-            i--;
+            void *slot = bin_pop(bin);
+            if (!slot)
+            {
+                break;
+            }
+            magazine->slots[magazine->count++] = slot;
         }
-        else
+        pthread_mutex_unlock(&bin->lock);
+
+        if (!magazine->count)
         {
-            alloc_array[i].mark = false;
+            return NULL;
         }
     }
 
-    void (*sweep_bin)(void *) = heap_free;
+    void *ptr = magazine->slots[--magazine->count];
+    arena_t *arena = arena_of(ptr);
+    size_t index = (size_t)((((uintptr_t)ptr - (uintptr_t)arena - bin->slots_offset) * bin->slot_reciprocal) >> 32);
+    gc_occupy_slot(bin, arena, index);
+    stats_alloc(bin->slot_size);
+    return ptr;
+}
 
-    for (size_t i = 0; i < alloc_bin_8_size; i++)
+static bool bin_free(arena_t *arena, void *ptr)
+{
+    bin_t *bin = &bins[arena->bin_index];
+    size_t index;
+    if (!bin_slot_index(bin, arena, ptr, &index))
     {
-        if (!alloc_bin_8[i].mark)
-        {
-            sweep_bin(alloc_bin_8[i].data_ptr);
-            i--;
-        }
-        else
-        {
-            alloc_bin_8[i].mark = false;
-        }
+        return false;
     }
 
-    for (size_t i = 0; i < alloc_bin_16_size; i++)
+    uint64_t bit = (uint64_t)1 << (index % 64);
+    if (!(__atomic_fetch_and(&arena->occupied[index / 64], ~bit, __ATOMIC_RELAXED) & bit))
     {
-        if (!alloc_bin_16[i].mark)
-        {
-            sweep_bin(alloc_bin_16[i].data_ptr);
-            i--;
-        }
-        else
-        {
-            alloc_bin_16[i].mark = false;
-        }
+        return false; // double free or a pointer that was never handed out
     }
 
-    for (size_t i = 0; i < alloc_bin_32_size; i++)
+    magazine_t *magazine = &get_magazines()[bin - bins];
+    if (magazine->count == MAGAZINE_CAPACITY)
     {
-        if (!alloc_bin_32[i].mark)
-        {
-            sweep_bin(alloc_bin_32[i].data_ptr);
-            i--;
-        }
-        else
+        pthread_mutex_lock(&bin->lock);
+        while (magazine->count > MAGAZINE_BATCH)
         {
-            alloc_bin_32[i].mark = false;
+            void *slot = magazine->slots[--magazine->count];
+            arena_t *slot_arena = arena_of(slot);
+            if (bin_push(bin, slot_arena, slot))
+            {
+                release_slab_arena(bin, slot_arena);
+            }
         }
+        pthread_mutex_unlock(&bin->lock);
     }
+
+    magazine->slots[magazine->count++] = ptr;
+    stats_free(bin->slot_size);
+    return true;
 }
 
-void gc_collect()
+/* Huge allocations */
+
+static void *huge_alloc(size_t size)
 {
-    static bool collecting = false;
-    if (collecting)
-        return;
-    collecting = true;
+    pthread_mutex_lock(&arena_lock);
 
-    mark_roots();
+    arena_t *arena = map_arena(ARENA_HEADER_SIZE + size);
+    if (!arena)
+    {
+        pthread_mutex_unlock(&arena_lock);
+        return NULL;
+    }
 
-    sweep();
+    arena->type = ALLOC_TYPE_HUGE;
+    arena->usable_size = size;
+    arena->swept = true;
+    arena->mark = gc_allocate_black(arena);
+    arena->prev = NULL;
+    arena->next = huge_arenas;
+    if (huge_arenas)
+    {
+        huge_arenas->prev = arena;
+    }
+    huge_arenas = arena;
+    register_arena(arena, true);
 
-    collecting = false;
+    pthread_mutex_unlock(&arena_lock);
+    stats_alloc(size);
+    return (uint8_t *)arena + ARENA_HEADER_SIZE;
 }
 
-#endif // GC_COLLECT
-
-static int64_t search_by_ptr(void *ptr, metadata_t *array, size_t array_size)
+static void huge_free(arena_t *arena)
 {
-    size_t left = 0;
-    size_t right = array_size;
+    size_t usable_size = arena->usable_size;
+    pthread_mutex_lock(&arena_lock);
 
-    while (left < right)
+    gc_unlink_arena(arena);
+
+    if (arena->prev)
     {
-        size_t mid = (left + right) / 2;
-        if (array[mid].data_ptr == ptr)
-        {
-            return mid;
-        }
-        if (array[mid].data_ptr < ptr)
-        {
-            left = mid + 1;
-        }
-        else
-        {
-            right = mid;
-        }
+        arena->prev->next = arena->next;
     }
-    return -1;
+    else
+    {
+        huge_arenas = arena->next;
+    }
+    if (arena->next)
+    {
+        arena->next->prev = arena->prev;
+    }
+
+    register_arena(arena, false);
+    __atomic_sub_fetch(&stats_bytes_mapped, arena->map_size, __ATOMIC_RELAXED);
+    munmap(arena, arena->map_size);
+
+    pthread_mutex_unlock(&arena_lock);
+    stats_free(usable_size);
 }
 
-static int64_t search_by_ptr_in_free_array(void *ptr)
+/* General heap */
+
+static inline size_t chunk_size(const heap_chunk_t *chunk)
 {
-    return search_by_ptr(ptr, free_array, free_array_size);
+    return chunk->head & ~CHUNK_FLAGS;
 }
 
-static int64_t search_by_ptr_in_alloc_array(void *ptr)
+static inline heap_chunk_t *chunk_next(const heap_chunk_t *chunk)
 {
-    return search_by_ptr(ptr, alloc_array, alloc_array_size);
+    return (heap_chunk_t *)((uint8_t *)chunk + chunk_size(chunk));
 }
 
-static int64_t search_by_size_in_free_array(size_t size, alignment_t alignment)
+// chunk size needed to hold size bytes of data
+static inline size_t chunk_size_for(size_t size)
 {
-    size_t left = 0;
-    size_t right = free_array_size;
-    int64_t best_fit = -1;
-    size_t smallest_sufficient_size = SIZE_MAX;
+    size_t needed = (size + CHUNK_HEADER_SIZE + CHUNK_GRANULE - 1) & ~(size_t)(CHUNK_GRANULE - 1);
+    return needed < CHUNK_MIN_SIZE ? CHUNK_MIN_SIZE : needed;
+}
 
-    while (left < right)
+// bytes to skip at the front of a free chunk so its data meets the alignment, the skipped part must fit a chunk
+static inline size_t chunk_padding(const heap_chunk_t *chunk, alignment_t alignment)
+{
+    size_t padding = ((size_t)alignment - ((uintptr_t)chunk + CHUNK_HEADER_SIZE)) & ((size_t)alignment - 1);
+    if (padding && padding < CHUNK_MIN_SIZE)
     {
-        size_t mid = (left + right) / 2;
-        metadata_t *current = &free_array[mid];
+        padding += alignment;
+    }
+    return padding;
+}
 
-        size_t padding = ((alignment - (size_t)current->chunk_ptr) & (alignment - 1));
-        size_t total_required = size + padding;
+// the chunk whose data starts at ptr, or NULL if ptr is not a live allocation of this heap arena
+static inline heap_chunk_t *find_heap_chunk(arena_t *arena, const void *ptr)
+{
+    uintptr_t offset = (uintptr_t)ptr - (uintptr_t)arena;
+    if (offset & (CHUNK_GRANULE - 1))
+    {
+        return NULL;
+    }
 
-        if (current->size >= total_required)
-        {
-            if (current->size < smallest_sufficient_size)
-            {
-                smallest_sufficient_size = current->size;
-                best_fit = mid;
-            }
-            right = mid;
-        }
-        else
-        {
-            left = mid + 1;
-        }
+    size_t granule = offset / CHUNK_GRANULE;
+    if (!((arena->occupied[granule / 64] >> (granule % 64)) & 1))
+    {
+        return NULL;
     }
 
-    return best_fit;
+    return (heap_chunk_t *)((uint8_t *)ptr - CHUNK_HEADER_SIZE);
 }
 
-static inline alignment_t calculate_alignment(const void *ptr)
+// index of the granule where the data of the chunk starts
+static inline size_t chunk_granule(const arena_t *arena, const heap_chunk_t *chunk)
 {
-    uintptr_t addr = (uintptr_t)ptr;
-    size_t alignment = ALIGN_1;
+    return ((uintptr_t)chunk + CHUNK_HEADER_SIZE - (uintptr_t)arena) / CHUNK_GRANULE;
+}
 
-    while (alignment <= MAX_ALIGNMENT && !(addr & (alignment - 1)))
+static inline void set_chunk_start(heap_chunk_t *chunk, bool allocated)
+{
+    arena_t *arena = arena_of(chunk);
+    size_t granule = chunk_granule(arena, chunk);
+    if (allocated)
     {
-        alignment = (alignment << 1);
+        arena->occupied[granule / 64] |= (uint64_t)1 << (granule % 64);
+    }
+    else
+    {
+        arena->occupied[granule / 64] &= ~((uint64_t)1 << (granule % 64));
     }
-
-    return (alignment_t)(alignment >> 1);
 }
 
-static bool remove_from_array(size_t index, metadata_t *array, size_t *array_size)
+static inline void tlsf_mapping(size_t size, size_t *fl, size_t *sl)
 {
-    if (index >= *array_size)
+    if (size < ((size_t)1 << TLSF_FL_SHIFT))
     {
-        return false;
+        *fl = 0;
+        *sl = size >> CHUNK_GRANULE_SHIFT;
+        return;
     }
 
-    memmove(&array[index], &array[index + 1],
-            (*array_size - index - 1) * sizeof(metadata_t));
-    (*array_size)--;
-    return true;
+    size_t msb = (sizeof(unsigned long long) * 8 - 1) - (size_t)__builtin_clzll(size);
+    *fl = msb - TLSF_FL_SHIFT + 1;
+    *sl = (size >> (msb - TLSF_SL_BITS)) ^ TLSF_SL_COUNT;
 }
 
-static bool remove_from_free_array(size_t index)
+static void insert_free_chunk(heap_chunk_t *chunk)
 {
-    return remove_from_array(index, free_array, &free_array_size);
-}
+    size_t fl, sl;
+    tlsf_mapping(chunk_size(chunk), &fl, &sl);
 
-static bool remove_from_alloc_array(size_t index)
-{
-    return remove_from_array(index, alloc_array, &alloc_array_size);
+    chunk->prev_free = NULL;
+    chunk->next_free = free_chunks[fl][sl];
+    if (free_chunks[fl][sl])
+    {
+        free_chunks[fl][sl]->prev_free = chunk;
+    }
+    free_chunks[fl][sl] = chunk;
+
+    free_fl_bitmap |= (uint32_t)1 << fl;
+    free_sl_bitmap[fl] |= (uint32_t)1 << sl;
+    free_chunk_bytes += chunk_size(chunk);
 }
 
-static size_t find_insertion_position(void *data_ptr, metadata_t *array, size_t array_size)
+static void remove_free_chunk(heap_chunk_t *chunk)
 {
-    size_t left = 0;
-    size_t right = array_size;
+    size_t fl, sl;
+    tlsf_mapping(chunk_size(chunk), &fl, &sl);
 
-    while (left < right)
+    if (chunk->prev_free)
     {
-        size_t mid = (left + right) / 2;
-        if (array[mid].data_ptr <= data_ptr)
-        {
-            left = mid + 1;
-        }
-        else
+        chunk->prev_free->next_free = chunk->next_free;
+    }
+    else
+    {
+        free_chunks[fl][sl] = chunk->next_free;
+    }
+    if (chunk->next_free)
+    {
+        chunk->next_free->prev_free = chunk->prev_free;
+    }
+
+    if (!free_chunks[fl][sl])
+    {
+        free_sl_bitmap[fl] &= ~((uint32_t)1 << sl);
+        if (!free_sl_bitmap[fl])
         {
-            right = mid;
+            free_fl_bitmap &= ~((uint32_t)1 << fl);
         }
     }
-    return left;
+    free_chunk_bytes -= chunk_size(chunk);
 }
 
-static bool add_into_array(metadata_t chunk, metadata_t *array, size_t *array_size, size_t capacity)
+// good fit in constant time: the first chunk of the smallest non-empty class whose every member is large enough
+static heap_chunk_t *search_free_chunk(size_t size, alignment_t alignment)
 {
-    if (*array_size >= capacity)
+    if ((size_t)alignment > CHUNK_GRANULE)
     {
-        return false;
+        size += (size_t)alignment + CHUNK_MIN_SIZE; // worst case chunk_padding
     }
 
-    size_t pos = find_insertion_position(chunk.data_ptr, array, *array_size);
+    // round up to the next class boundary so any chunk found is big enough
+    if (size >= ((size_t)1 << TLSF_FL_SHIFT))
+    {
+        size_t msb = (sizeof(unsigned long long) * 8 - 1) - (size_t)__builtin_clzll(size);
+        size += ((size_t)1 << (msb - TLSF_SL_BITS)) - 1;
+    }
 
-    if (pos < *array_size)
+    size_t fl, sl;
+    tlsf_mapping(size, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT)
     {
-        memmove(&array[pos + 1], &array[pos],
-                (*array_size - pos) * sizeof(metadata_t));
+        return NULL;
     }
 
-    array[pos] = chunk;
-    (*array_size)++;
-    return true;
-}
+    uint32_t sl_map = free_sl_bitmap[fl] & (~(uint32_t)0 << sl);
+    if (!sl_map)
+    {
+        uint32_t fl_map = fl + 1 < TLSF_FL_COUNT ? free_fl_bitmap & (~(uint32_t)0 << (fl + 1)) : 0;
+        if (!fl_map)
+        {
+            return NULL;
+        }
 
-static bool add_into_free_array(void *chunk_ptr, void *data_ptr, void *prev_chunk_ptr,
-                                size_t size, size_t usable_size, alignment_t alignment)
-{
-    metadata_t chunk = {
-        .chunk_ptr = chunk_ptr,
-        .data_ptr = data_ptr,
-        .prev_chunk_ptr = prev_chunk_ptr,
-        .size = size,
-        .usable_size = usable_size,
-        .current_alignment = alignment};
-    return add_into_array(chunk, free_array, &free_array_size, FREE_CAPACITY);
-}
+        fl = (size_t)__builtin_ctz(fl_map);
+        sl_map = free_sl_bitmap[fl];
+    }
 
-static bool add_into_alloc_array(void *chunk_ptr, void *data_ptr, void *prev_chunk_ptr,
-                                 size_t size, size_t usable_size, alignment_t alignment)
-{
-    metadata_t chunk = {
-        .chunk_ptr = chunk_ptr,
-        .data_ptr = data_ptr,
-        .prev_chunk_ptr = prev_chunk_ptr,
-        .size = size,
-        .usable_size = usable_size,
-        .current_alignment = alignment};
-    return add_into_array(chunk, alloc_array, &alloc_array_size, ALLOC_CAPACITY);
+    return free_chunks[fl][(size_t)__builtin_ctz(sl_map)];
 }
 
-static void defragment_heap()
+// frees a used chunk and merges it with its free neighbours, returns the resulting free chunk
+static heap_chunk_t *heap_chunk_free(heap_chunk_t *chunk)
 {
-    bool defragmented;
-    do
+    set_chunk_start(chunk, false);
+
+    size_t size = chunk_size(chunk);
+    heap_chunk_t *next = chunk_next(chunk);
+    if (!(next->head & CHUNK_USED))
     {
-        defragmented = false;
-        for (size_t i = 0; i < free_array_size; i++)
-        {
-            metadata_t *current = &free_array[i];
+        remove_free_chunk(next);
+        size += chunk_size(next);
+        stats_add(&get_thread_stats()->coalesces, 1);
+    }
 
-            void *next_chunk = (uint8_t *)current->chunk_ptr + current->size;
-            for (size_t j = 0; j < free_array_size; j++)
-            {
-                if (i != j && free_array[j].chunk_ptr == next_chunk)
-                {
-                    current->size += free_array[j].size;
-                    remove_from_free_array(j);
-                    defragmented = true;
-                    break;
-                }
-            }
+    if (!(chunk->head & CHUNK_PREV_USED))
+    {
+        chunk = (heap_chunk_t *)((uint8_t *)chunk - chunk->prev_size);
+        remove_free_chunk(chunk);
+        size += chunk_size(chunk);
+        stats_add(&get_thread_stats()->coalesces, 1);
+    }
 
-            int64_t prev_idx = search_by_ptr_in_free_array(current->prev_chunk_ptr);
-            if (prev_idx >= 0)
-            {
-                metadata_t *prev = &free_array[prev_idx];
-                prev->size += current->size;
-                remove_from_free_array(i);
-                defragmented = true;
-                break;
-            }
-        }
-    } while (defragmented);
+    // free chunks never touch, so whatever precedes the merged chunk is in use
+    chunk->head = size | CHUNK_PREV_USED;
+    next = chunk_next(chunk);
+    next->prev_size = size;
+    next->head &= ~CHUNK_PREV_USED;
+
+    insert_free_chunk(chunk);
+    return chunk;
 }
 
-void heap_init()
+// trims a used chunk down to size and frees the rest if it can hold a chunk of its own
+static void split_chunk(heap_chunk_t *chunk, size_t size)
 {
-    static bool has_run = false;
-    if (has_run)
+    size_t remaining = chunk_size(chunk) - size;
+    if (remaining < CHUNK_MIN_SIZE)
     {
         return;
     }
 
-    has_run = true;
-    free_array_size = 0;
-    alloc_array_size = 0;
-
-    add_into_free_array(heap, heap, NULL, HEAP_CAPACITY, HEAP_CAPACITY, MAX_ALIGNMENT);
-    free_array[0].alloc_type = ALLOC_TYPE_HEAP;
-
-    init_bins();
+    chunk->head = size | (chunk->head & CHUNK_FLAGS);
+    heap_chunk_t *tail = chunk_next(chunk);
+    tail->head = remaining | CHUNK_USED | CHUNK_PREV_USED;
+    heap_chunk_free(tail);
 }
 
-void *heap_alloc(size_t size, alignment_t alignment)
+// maps a new heap arena and returns its single free chunk, the caller holds heap_lock
+static heap_chunk_t *add_heap_arena()
 {
-    if (!size)
+    arena_t *arena = acquire_arena();
+    if (!arena)
     {
         return NULL;
     }
 
-    heap_init();
-
-    if (((alignment) & (alignment - 1)) || (alignment > MAX_ALIGNMENT))
+    arena->type = ALLOC_TYPE_HEAP;
+    arena->prev = NULL;
+    arena->next = heap_arenas;
+    if (heap_arenas)
     {
-        alignment = DEFAULT_ALIGNMENT;
+        heap_arenas->prev = arena;
     }
+    heap_arenas = arena;
+
+    arena->occupied = (uint64_t *)((uint8_t *)arena + ARENA_HEADER_SIZE);
+    arena->marks = (uint64_t *)((uint8_t *)arena->occupied + HEAP_START_BITMAP_SIZE);
+    arena->swept = true;
+    memset(arena->occupied, 0, 2 * HEAP_START_BITMAP_SIZE);
+
+    // a used fence at the end keeps the last chunk from merging past the arena
+    heap_chunk_t *chunk = (heap_chunk_t *)((uint8_t *)arena + HEAP_CHUNKS_OFFSET);
+    chunk->head = HEAP_ARENA_PAYLOAD | CHUNK_PREV_USED;
+    heap_chunk_t *fence = chunk_next(chunk);
+    fence->prev_size = HEAP_ARENA_PAYLOAD;
+    fence->head = CHUNK_USED;
+
+    insert_free_chunk(chunk);
+    return chunk;
+}
 
-    metadata_t *target_free_array;
-    metadata_t *target_alloc_array;
-    size_t *target_free_size;
-    size_t *target_alloc_size;
-    size_t target_capacity;
-    allocation_type_t alloc_type;
+// gives the arena back once a single free chunk covers it, the last heap arena is kept, the caller holds heap_lock
+static bool release_empty_heap_arena(arena_t *arena)
+{
+    heap_chunk_t *chunk = (heap_chunk_t *)((uint8_t *)arena + HEAP_CHUNKS_OFFSET);
+    if ((chunk->head & CHUNK_USED) || chunk_size(chunk) != HEAP_ARENA_PAYLOAD ||
+        (heap_arenas == arena && !arena->next))
+    {
+        return false;
+    }
 
-    if (size <= BIN_8_SIZE)
+    remove_free_chunk(chunk);
+    gc_unlink_arena(arena);
+    if (arena->prev)
     {
-        target_free_array = free_bin_8;
-        target_alloc_array = alloc_bin_8;
-        target_free_size = &free_bin_8_size;
-        target_alloc_size = &alloc_bin_8_size;
-        target_capacity = BIN_8_CAPACITY;
-        size = BIN_8_SIZE;
-        alloc_type = ALLOC_TYPE_BIN_8;
+        arena->prev->next = arena->next;
     }
-    else if (size <= BIN_16_SIZE)
+    else
     {
-        target_free_array = free_bin_16;
-        target_alloc_array = alloc_bin_16;
-        target_free_size = &free_bin_16_size;
-        target_alloc_size = &alloc_bin_16_size;
-        target_capacity = BIN_16_CAPACITY;
-        size = BIN_16_SIZE;
-        alloc_type = ALLOC_TYPE_BIN_16;
+        heap_arenas = arena->next;
     }
-    else if (size <= BIN_32_SIZE)
+    if (arena->next)
     {
-        target_free_array = free_bin_32;
-        target_alloc_array = alloc_bin_32;
-        target_free_size = &free_bin_32_size;
-        target_alloc_size = &alloc_bin_32_size;
-        target_capacity = BIN_32_CAPACITY;
-        size = BIN_32_SIZE;
-        alloc_type = ALLOC_TYPE_BIN_32;
+        arena->next->prev = arena->prev;
     }
-    else
+
+    release_arena(arena);
+    return true;
+}
+
+void heap_init()
+{
+    pthread_once(&heap_init_once, heap_init_once_routine);
+}
+
+static void heap_init_once_routine()
+{
+    for (size_t b = 0; b < BIN_COUNT; b++)
     {
-        int64_t best_fit_index = search_by_size_in_free_array(size, alignment);
-        if (best_fit_index < 0)
+        bin_t *bin = &bins[b];
+        bin->slot_alignment = bin->slot_size & -bin->slot_size;
+        if (bin->slot_alignment > MAX_ALIGNMENT_INT)
         {
-            return NULL;
+            bin->slot_alignment = MAX_ALIGNMENT_INT;
         }
+        bin->slot_reciprocal = (((uint64_t)1 << 32) + bin->slot_size - 1) / bin->slot_size;
 
-        metadata_t *chunk = &free_array[best_fit_index];
-        size_t padding = ((alignment - (size_t)chunk->chunk_ptr) & (alignment - 1));
-        void *data_ptr = (uint8_t *)chunk->chunk_ptr + padding;
-
-        if (padding >= SPLIT_CUTOFF)
+        // largest slot count whose two bitmaps and slots fit after the header
+        size_t capacity = (ARENA_SIZE - ARENA_HEADER_SIZE) / bin->slot_size;
+        size_t slots_offset;
+        do
         {
-            add_into_free_array(chunk->chunk_ptr, chunk->chunk_ptr,
-                                chunk->prev_chunk_ptr, padding, padding,
-                                calculate_alignment(chunk->chunk_ptr));
-            free_array[free_array_size - 1].alloc_type = ALLOC_TYPE_HEAP;
+            size_t bitmap_bytes = 2 * ((capacity + 63) / 64) * sizeof(uint64_t);
+            slots_offset = (ARENA_HEADER_SIZE + bitmap_bytes + MAX_ALIGNMENT_INT - 1) & ~(size_t)(MAX_ALIGNMENT_INT - 1);
+        } while (slots_offset + capacity * bin->slot_size > ARENA_SIZE && capacity--);
 
-            chunk->chunk_ptr = (uint8_t *)chunk->chunk_ptr + padding;
-            chunk->size -= padding;
-            chunk->prev_chunk_ptr = (uint8_t *)chunk->chunk_ptr - padding;
-        }
+        bin->capacity = capacity;
+        bin->slots_offset = slots_offset;
+    }
 
-        size_t remaining = chunk->size - size;
-        if (remaining >= SPLIT_CUTOFF)
+    for (size_t i = 0, b = 0; i <= BIN_MAX_SIZE / 8; i++)
+    {
+        while (bins[b].slot_size < i * 8)
         {
-            void *new_chunk_ptr = (uint8_t *)chunk->chunk_ptr + size;
-            add_into_free_array(new_chunk_ptr, new_chunk_ptr,
-                                chunk->chunk_ptr, remaining, remaining,
-                                calculate_alignment(new_chunk_ptr));
-            free_array[free_array_size - 1].alloc_type = ALLOC_TYPE_HEAP;
-            chunk->size = size;
+            b++;
         }
-
-        add_into_alloc_array(chunk->chunk_ptr, data_ptr,
-                             chunk->prev_chunk_ptr, chunk->size,
-                             chunk->size - padding, alignment);
-        alloc_array[alloc_array_size - 1].alloc_type = ALLOC_TYPE_HEAP;
-        remove_from_free_array(best_fit_index);
-
-        return data_ptr;
+        bin_lookup[i] = (uint8_t)b;
     }
+}
 
-    if (*target_free_size == 0)
+void *heap_alloc(size_t size, alignment_t alignment)
+{
+    if (!size)
     {
         return NULL;
     }
 
-    metadata_t chunk = target_free_array[0];
-
-    size_t padding = ((alignment - (size_t)chunk.chunk_ptr) & (alignment - 1));
-    void *data_ptr = (uint8_t *)chunk.chunk_ptr + padding;
+    heap_init();
 
-    size_t aligned_size = size;
-    if (alignment < size)
+    if (((alignment) & (alignment - 1)) || (alignment > MAX_ALIGNMENT))
     {
-        aligned_size = ((size + (size - 1)) / size) * size;
+        alignment = DEFAULT_ALIGNMENT;
     }
 
-    uint8_t *bin_start;
-    uint8_t *bin_end;
-    switch (alloc_type)
+    void *data_ptr;
+    bin_t *bin = find_bin_for_size(size, alignment);
+    if (bin)
     {
-    case ALLOC_TYPE_BIN_8:
-        bin_start = bin_8;
-        bin_end = bin_8 + (BIN_8_CAPACITY * BIN_8_SIZE);
-        break;
-    case ALLOC_TYPE_BIN_16:
-        bin_start = bin_16;
-        bin_end = bin_16 + (BIN_16_CAPACITY * BIN_16_SIZE);
-        break;
-    case ALLOC_TYPE_BIN_32:
-        bin_start = bin_32;
-        bin_end = bin_32 + (BIN_32_CAPACITY * BIN_32_SIZE);
-        break;
-    default:
-        return NULL;
+        data_ptr = bin_alloc(bin);
     }
-
-    if ((uint8_t *)data_ptr + aligned_size > bin_end || (uint8_t *)data_ptr < bin_start)
+    else if (size >= HUGE_THRESHOLD)
     {
-        return NULL;
+        data_ptr = huge_alloc(size);
     }
-
-    metadata_t alloc_chunk = {
-        .chunk_ptr = chunk.chunk_ptr,
-        .data_ptr = data_ptr,
-        .prev_chunk_ptr = chunk.prev_chunk_ptr,
-        .size = aligned_size,
-        .usable_size = aligned_size - padding,
-        .current_alignment = alignment,
-        .alloc_type = alloc_type};
-
-    if (!add_into_array(alloc_chunk, target_alloc_array, target_alloc_size, target_capacity))
+    else
     {
-        return NULL;
+        pthread_mutex_lock(&heap_lock);
+        data_ptr = heap_region_alloc(size, alignment);
+        pthread_mutex_unlock(&heap_lock);
     }
 
-    remove_from_array(0, target_free_array, target_free_size);
-
+    if (!data_ptr)
+    {
+        stats_add(&get_thread_stats()->failed_allocs, 1);
+    }
     return data_ptr;
 }
 
-static void init_bins()
+static void *heap_region_alloc(size_t size, alignment_t alignment)
 {
-    static bool has_run = false;
-    if (has_run)
+    size_t needed = chunk_size_for(size);
+
+    heap_chunk_t *chunk = search_free_chunk(needed, alignment);
+    if (!chunk)
     {
-        return;
+        chunk = add_heap_arena();
+        if (!chunk)
+        {
+            return NULL;
+        }
     }
+    size_t padding = chunk_padding(chunk, alignment);
 
-    has_run = true;
+    remove_free_chunk(chunk);
 
-    free_bin_8_size = 0;
-    for (size_t i = 0; i < BIN_8_CAPACITY; i++)
+    if (padding)
     {
-        void *chunk_ptr = &bin_8[i * BIN_8_SIZE];
-        metadata_t chunk = {
-            .chunk_ptr = chunk_ptr,
-            .data_ptr = chunk_ptr,
-            .prev_chunk_ptr = i > 0 ? &bin_8[(i - 1) * BIN_8_SIZE] : NULL,
-            .size = BIN_8_SIZE,
-            .usable_size = BIN_8_SIZE,
-            .current_alignment = MAX_ALIGNMENT,
-            .alloc_type = ALLOC_TYPE_BIN_8};
-        add_into_array(chunk, free_bin_8, &free_bin_8_size, BIN_8_CAPACITY);
+        // the space in front of the aligned data stays free as a chunk of its own
+        heap_chunk_t *aligned = (heap_chunk_t *)((uint8_t *)chunk + padding);
+        aligned->head = chunk_size(chunk) - padding;
+        aligned->prev_size = padding;
+        chunk->head = padding | (chunk->head & CHUNK_PREV_USED);
+        insert_free_chunk(chunk);
+        chunk = aligned;
     }
 
-    free_bin_16_size = 0;
-    for (size_t i = 0; i < BIN_16_CAPACITY; i++)
-    {
-        void *chunk_ptr = &bin_16[i * BIN_16_SIZE];
-        metadata_t chunk = {
-            .chunk_ptr = chunk_ptr,
-            .data_ptr = chunk_ptr,
-            .prev_chunk_ptr = i > 0 ? &bin_16[(i - 1) * BIN_16_SIZE] : NULL,
-            .size = BIN_16_SIZE,
-            .usable_size = BIN_16_SIZE,
-            .current_alignment = MAX_ALIGNMENT,
-            .alloc_type = ALLOC_TYPE_BIN_16};
-        add_into_array(chunk, free_bin_16, &free_bin_16_size, BIN_16_CAPACITY);
-    }
+    chunk->head |= CHUNK_USED;
+    chunk_next(chunk)->head |= CHUNK_PREV_USED;
+    set_chunk_start(chunk, true);
+#ifdef GC_COLLECT
+    gc_shade_new(arena_of(chunk), chunk_granule(arena_of(chunk), chunk));
+#endif
+    split_chunk(chunk, needed);
+    stats_alloc(chunk_size(chunk) - CHUNK_HEADER_SIZE);
 
-    free_bin_32_size = 0;
-    for (size_t i = 0; i < BIN_32_CAPACITY; i++)
-    {
-        void *chunk_ptr = &bin_32[i * BIN_32_SIZE];
-        metadata_t chunk = {
-            .chunk_ptr = chunk_ptr,
-            .data_ptr = chunk_ptr,
-            .prev_chunk_ptr = i > 0 ? &bin_32[(i - 1) * BIN_32_SIZE] : NULL,
-            .size = BIN_32_SIZE,
-            .usable_size = BIN_32_SIZE,
-            .current_alignment = MAX_ALIGNMENT,
-            .alloc_type = ALLOC_TYPE_BIN_32};
-        add_into_array(chunk, free_bin_32, &free_bin_32_size, BIN_32_CAPACITY);
-    }
+    return (uint8_t *)chunk + CHUNK_HEADER_SIZE;
 }
 
 void heap_free(void *ptr)
@@ -773,96 +2509,61 @@ void heap_free(void *ptr)
         return;
     }
 
-    metadata_t *chunk = NULL;
-    metadata_t *source_alloc_array = NULL;
-    metadata_t *target_free_array = NULL;
-    size_t *source_alloc_size = NULL;
-    size_t *target_free_size = NULL;
-    size_t target_capacity = 0;
-    int64_t alloc_index = -1;
-
-    uintptr_t heap_start = (uintptr_t)heap;
-    uintptr_t heap_end = heap_start + HEAP_CAPACITY;
-    uintptr_t bin_8_start = (uintptr_t)bin_8;
-    uintptr_t bin_8_end = bin_8_start + BIN_8_CAPACITY * BIN_8_SIZE;
-    uintptr_t bin_16_start = (uintptr_t)bin_16;
-    uintptr_t bin_16_end = (uintptr_t)bin_16 + BIN_16_CAPACITY * BIN_16_SIZE;
-    uintptr_t bin_32_start = (uintptr_t)bin_32;
-    uintptr_t bin_32_end = bin_32_start + BIN_32_SIZE * BIN_32_CAPACITY;
-
-    if ((uintptr_t)ptr >= bin_8_start && (uintptr_t)ptr < bin_8_end)
-    {
-        source_alloc_array = alloc_bin_8;
-        target_free_array = free_bin_8;
-        source_alloc_size = &alloc_bin_8_size;
-        target_free_size = &free_bin_8_size;
-        target_capacity = BIN_8_CAPACITY;
-        alloc_index = search_by_ptr(ptr, alloc_bin_8, alloc_bin_8_size);
-    }
-    else if ((uintptr_t)ptr >= bin_16_start && (uintptr_t)ptr < bin_16_end)
-    {
-        source_alloc_array = alloc_bin_16;
-        target_free_array = free_bin_16;
-        source_alloc_size = &alloc_bin_16_size;
-        target_free_size = &free_bin_16_size;
-        target_capacity = BIN_16_CAPACITY;
-        alloc_index = search_by_ptr(ptr, alloc_bin_16, alloc_bin_16_size);
-    }
-    else if ((uintptr_t)ptr >= bin_32_start && (uintptr_t)ptr < bin_32_end)
-    {
-        source_alloc_array = alloc_bin_32;
-        target_free_array = free_bin_32;
-        source_alloc_size = &alloc_bin_32_size;
-        target_free_size = &free_bin_32_size;
-        target_capacity = BIN_32_CAPACITY;
-        alloc_index = search_by_ptr(ptr, alloc_bin_32, alloc_bin_32_size);
-    }
-    else if ((uintptr_t)ptr >= heap_start && (uintptr_t)ptr < heap_end)
-    {
-        alloc_index = search_by_ptr_in_alloc_array(ptr);
-    }
-    else
+    arena_t *arena = find_arena(ptr);
+    if (!arena)
     {
         return;
     }
 
-    if (source_alloc_array && alloc_index >= 0)
+    switch (arena->type)
     {
-        chunk = &source_alloc_array[alloc_index];
-        metadata_t free_chunk = {
-            .chunk_ptr = chunk->chunk_ptr,
-            .data_ptr = chunk->data_ptr,
-            .prev_chunk_ptr = chunk->prev_chunk_ptr,
-            .size = chunk->size,
-            .usable_size = chunk->usable_size,
-            .current_alignment = chunk->current_alignment,
-            .alloc_type = chunk->alloc_type};
-
-        if (!add_into_array(free_chunk, target_free_array, target_free_size, target_capacity))
+    case ALLOC_TYPE_BIN:
+        bin_free(arena, ptr);
+        return;
+    case ALLOC_TYPE_HUGE:
+        if (ptr == (uint8_t *)arena + ARENA_HEADER_SIZE)
         {
-            return;
+            huge_free(arena);
         }
-        remove_from_array(alloc_index, source_alloc_array, source_alloc_size);
+        return;
+    case ALLOC_TYPE_HEAP:
+        pthread_mutex_lock(&heap_lock);
+        heap_region_free(arena, ptr);
+        pthread_mutex_unlock(&heap_lock);
+        return;
+    default:
         return;
     }
+}
 
-    if (alloc_index >= 0)
+static void heap_region_free(arena_t *arena, void *ptr)
+{
+    heap_chunk_t *chunk = find_heap_chunk(arena, ptr);
+    if (!chunk)
     {
-        chunk = &alloc_array[alloc_index];
-        add_into_free_array(
-            chunk->chunk_ptr,
-            chunk->data_ptr,
-            chunk->prev_chunk_ptr,
-            chunk->size,
-            chunk->usable_size,
-            chunk->current_alignment);
-        free_array[free_array_size - 1].alloc_type = ALLOC_TYPE_HEAP;
-        remove_from_alloc_array(alloc_index);
-        if (!num_of_free_called_on_heap && (FREE_DEFRAG_CUTOFF - 1))
-        {
-            defragment_heap();
-        }
+        return; // not a live allocation, e.g. a double free
+    }
+
+    stats_free(chunk_size(chunk) - CHUNK_HEADER_SIZE);
+    heap_chunk_free(chunk);
+    release_empty_heap_arena(arena);
+}
+
+// grows a used chunk into the free chunk after it, the caller holds heap_lock
+static bool try_extend_chunk(heap_chunk_t *chunk, size_t size)
+{
+    heap_chunk_t *next = chunk_next(chunk);
+    if ((next->head & CHUNK_USED) || chunk_size(chunk) + chunk_size(next) < size)
+    {
+        return false;
     }
+
+    remove_free_chunk(next);
+    chunk->head = (chunk_size(chunk) + chunk_size(next)) | (chunk->head & CHUNK_FLAGS);
+    chunk_next(chunk)->head |= CHUNK_PREV_USED;
+    stats_add(&get_thread_stats()->coalesces, 1);
+    split_chunk(chunk, size);
+    return true;
 }
 
 void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
@@ -878,49 +2579,101 @@ void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
         return NULL;
     }
 
-    if (((new_alignment) & (new_alignment - 1)) || (new_alignment > MAX_ALIGNMENT))
+    if (new_alignment == ALIGN_SAME)
+    {
+        // keep whatever alignment the block already has
+        uintptr_t lowest_bit = (uintptr_t)ptr & -(uintptr_t)ptr;
+        new_alignment = lowest_bit > MAX_ALIGNMENT_INT ? MAX_ALIGNMENT : (alignment_t)lowest_bit;
+    }
+    else if (((new_alignment) & (new_alignment - 1)) || (new_alignment > MAX_ALIGNMENT))
     {
         new_alignment = DEFAULT_ALIGNMENT;
     }
 
-    int64_t ptr_index = search_by_ptr_in_alloc_array(ptr);
-    if (ptr_index < 0)
+    arena_t *arena = find_arena(ptr);
+    if (!arena)
     {
         return NULL;
     }
 
-    metadata_t *chunk = &alloc_array[ptr_index];
+    bool aligned = !((uintptr_t)ptr & (new_alignment - 1));
+    size_t usable_size;
 
-    if (new_size <= chunk->size)
+    switch (arena->type)
+    {
+    case ALLOC_TYPE_BIN:
     {
-        if (new_alignment != chunk->current_alignment)
+        size_t slot;
+        bin_t *bin = &bins[arena->bin_index];
+        if (!bin_slot_index(bin, arena, ptr, &slot) ||
+            !((__atomic_load_n(&arena->occupied[slot / 64], __ATOMIC_RELAXED) >> (slot % 64)) & 1))
         {
-            void *new_ptr = heap_alloc(new_size, new_alignment);
-            if (!new_ptr)
-            {
-                return NULL;
-            }
+            return NULL;
+        }
+
+        stats_add(&get_thread_stats()->reallocs, 1);
+        usable_size = bin->slot_size;
+        if (new_size <= usable_size && aligned)
+        {
+            return ptr; // still fits its slot
+        }
+        break; // promoted to a larger class or the general heap below
+    }
+    case ALLOC_TYPE_HUGE:
+        if (ptr != (uint8_t *)arena + ARENA_HEADER_SIZE)
+        {
+            return NULL;
+        }
+
+        stats_add(&get_thread_stats()->reallocs, 1);
 
-            size_t copy_size = new_size < chunk->usable_size ? new_size : chunk->usable_size;
-            memcpy(new_ptr, ptr, copy_size);
-            heap_free(ptr);
-            return new_ptr;
+        // the mapping is rounded up to ARENA_SIZE, so there is often slack to grow into
+        if (new_size <= arena->map_size - ARENA_HEADER_SIZE && new_size >= HUGE_THRESHOLD && aligned)
+        {
+            stats_resize(arena->usable_size, new_size);
+            arena->usable_size = new_size;
+            return ptr;
         }
+        usable_size = arena->usable_size;
+        break;
+    case ALLOC_TYPE_HEAP:
+    {
+        pthread_mutex_lock(&heap_lock);
 
-        // now if the alignment is same and the size is below
-        size_t remaining = chunk->size - new_size;
+        heap_chunk_t *chunk = find_heap_chunk(arena, ptr);
+        if (!chunk)
+        {
+            pthread_mutex_unlock(&heap_lock);
+            return NULL;
+        }
 
-        // only split if remaining space is above cutoff
-        if (remaining >= SPLIT_CUTOFF)
+        stats_add(&get_thread_stats()->reallocs, 1);
+        usable_size = chunk_size(chunk) - CHUNK_HEADER_SIZE;
+        if (aligned && new_size < HUGE_THRESHOLD)
         {
-            void *new_chunk_ptr = (uint8_t *)chunk->chunk_ptr + new_size;
-            add_into_free_array(new_chunk_ptr, new_chunk_ptr,
-                                chunk->chunk_ptr, remaining, remaining,
-                                calculate_alignment(new_chunk_ptr));
-            chunk->size = new_size;
+            size_t needed = chunk_size_for(new_size);
+            if (needed <= chunk_size(chunk))
+            {
+                // shrinking in place, the tail goes back to the heap
+                split_chunk(chunk, needed);
+                stats_resize(usable_size, chunk_size(chunk) - CHUNK_HEADER_SIZE);
+                pthread_mutex_unlock(&heap_lock);
+                return ptr;
+            }
+
+            if (try_extend_chunk(chunk, needed))
+            {
+                stats_resize(usable_size, chunk_size(chunk) - CHUNK_HEADER_SIZE);
+                pthread_mutex_unlock(&heap_lock);
+                return ptr;
+            }
         }
 
-        return ptr;
+        pthread_mutex_unlock(&heap_lock);
+        break;
+    }
+    default:
+        return NULL;
     }
 
     void *new_ptr = heap_alloc(new_size, new_alignment);
@@ -929,30 +2682,61 @@ void *heap_realloc(void *ptr, size_t new_size, alignment_t new_alignment)
         return NULL;
     }
 
-    memcpy(new_ptr, ptr, chunk->usable_size);
+    memcpy(new_ptr, ptr, new_size < usable_size ? new_size : usable_size);
+    gc_rescan_moved(new_ptr, new_size < usable_size ? new_size : usable_size);
     heap_free(ptr);
     return new_ptr;
 }
 
 #endif // MEM_IMPLEMENTATION
 
-#undef HEAP_CAPACITY
-#undef FREE_CAPACITY
-#undef ALLOC_CAPACITY
+#undef ARENA_SHIFT
+#undef ARENA_SIZE
+#undef HUGE_THRESHOLD
+#undef DEFAULT_ARENA_RETENTION
+
+#undef ARENA_MAP_BITS
+#undef ARENA_MAP_LEAF_BITS
+#undef ARENA_MAP_ROOT_BITS
 
 #undef MAX_ALIGNMENT
 #undef MAX_ALIGNMENT_INT
 #undef DEFAULT_ALIGNMENT // by default align on pointer size, this is enough for most platforms and architectures
 
-#undef SPLIT_CUTOFF
-
-#undef FREE_DEFRAG_CUTOFF // must be a power of 2
-
-#undef BIN_8_SIZE
-#undef BIN_16_SIZE
-#undef BIN_32_SIZE
-#undef BIN_8_CAPACITY
-#undef BIN_16_CAPACITY
-#undef BIN_32_CAPACITY
+#undef CHUNK_USED
+#undef CHUNK_PREV_USED
+#undef CHUNK_FLAGS
+#undef CHUNK_HEADER_SIZE
+#undef CHUNK_MIN_SIZE
+#undef CHUNK_GRANULE
+#undef CHUNK_GRANULE_SHIFT
+
+#undef TLSF_SL_BITS
+#undef TLSF_SL_COUNT
+#undef TLSF_FL_SHIFT
+#undef TLSF_FL_COUNT
+
+#undef ARENA_HEADER_SIZE
+#undef HEAP_START_BITMAP_SIZE
+#undef HEAP_CHUNKS_OFFSET
+#undef HEAP_ARENA_PAYLOAD
+
+#undef BIN_COUNT
+#undef BIN_MAX_SIZE
+
+#undef MAGAZINE_CAPACITY
+#undef MAGAZINE_BATCH
+
+#undef STATS_FLUSH_BYTES
+
+#undef GC_DEFAULT_STEP_BUDGET
+#undef GC_SWEEP_FREE_COST
+#undef GC_UNMAP_COST_SHIFT
+#undef GC_MARK_STACK_INITIAL
+#undef GC_MAX_MARKERS
+#undef GC_DEQUE_CAPACITY
+#undef GC_MARK_SLICE
+#undef GC_SUSPEND_SIGNAL
+#undef GC_RESUME_SIGNAL
 
 #endif /* D46AFE7A_7823_4C7A_A759_A5737B4A74D1 */
@@ -4,12 +4,25 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CRC32C_HARDWARE_ARM
+#elif defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_HARDWARE_X86
+#endif
 
 #define CRC32_POLYNOMIAL 0xEDB88320
+#define CRC32C_POLYNOMIAL 0x82F63B78
 
 static uint32_t crc32_table[256];
+static uint32_t crc32c_table[256];
 
 uint32_t crc32(const uint8_t *data, size_t length);
+uint32_t crc32c(const uint8_t *data, size_t length);
+uint32_t crc32c_header(uint64_t first, uint64_t second, uint16_t last);
 
 static void crc32_init_table()
 {
@@ -46,4 +59,173 @@ uint32_t crc32(const uint8_t *data, size_t length)
     return crc ^ 0xFFFFFFFF;
 }
 
+/*
+ * CRC32C (Castagnoli) is the polynomial implemented by the SSE4.2 crc32
+ * instruction and the ARMv8 crc32c* instructions, the table-driven
+ * version below produces the same values on CPUs without either.
+ */
+static void crc32c_init_table()
+{
+    static bool has_run = false;
+
+    if (has_run)
+    {
+        return;
+    }
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t crc = i;
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL * (crc & 1));
+        }
+        crc32c_table[i] = crc;
+    }
+    has_run = true;
+}
+
+static inline uint32_t crc32c_software_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = (crc >> 8) ^ crc32c_table[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+#if defined(CRC32C_HARDWARE_ARM)
+
+static inline bool crc32c_has_hardware(void)
+{
+    return true;
+}
+
+static inline uint32_t crc32c_hardware_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    for (; length >= 8; data += 8, length -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; length; data++, length--)
+    {
+        crc = __crc32cb(crc, *data);
+    }
+    return crc;
+}
+
+static inline uint32_t crc32c_hardware_header(uint64_t first, uint64_t second, uint16_t last)
+{
+    return ~__crc32ch(__crc32cd(__crc32cd(0xFFFFFFFF, first), second), last);
+}
+
+#elif defined(CRC32C_HARDWARE_X86)
+
+/* resolved once, the cpuid probe is too slow to repeat on every checksum */
+static inline bool crc32c_has_hardware(void)
+{
+    static int has_sse42 = -1;
+
+    if (__builtin_expect(has_sse42 < 0, 0))
+    {
+        __builtin_cpu_init();
+        has_sse42 = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+    }
+    return has_sse42;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t crc32c_hardware_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+    for (; length >= 8; data += 8, length -= 8)
+    {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t)crc64;
+#endif
+    for (; length >= 4; data += 4, length -= 4)
+    {
+        uint32_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; length; data++, length--)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+    }
+    return crc;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t crc32c_hardware_header(uint64_t first, uint64_t second, uint16_t last)
+{
+#ifdef __x86_64__
+    uint64_t crc = _mm_crc32_u64(_mm_crc32_u64(0xFFFFFFFF, first), second);
+    return ~_mm_crc32_u16((uint32_t)crc, last);
+#else
+    uint32_t crc = 0xFFFFFFFF;
+    crc = _mm_crc32_u32(_mm_crc32_u32(crc, (uint32_t)first), (uint32_t)(first >> 32));
+    crc = _mm_crc32_u32(_mm_crc32_u32(crc, (uint32_t)second), (uint32_t)(second >> 32));
+    return ~_mm_crc32_u16(crc, last);
+#endif
+}
+
+#else
+
+static inline bool crc32c_has_hardware(void)
+{
+    return false;
+}
+
+static inline uint32_t crc32c_hardware_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    return crc32c_software_update(crc, data, length);
+}
+
+static inline uint32_t crc32c_hardware_header(uint64_t first, uint64_t second, uint16_t last)
+{
+    (void)first;
+    (void)second;
+    (void)last;
+    return 0;
+}
+
+#endif
+
+uint32_t crc32c(const uint8_t *data, size_t length)
+{
+    if (crc32c_has_hardware())
+    {
+        return ~crc32c_hardware_update(0xFFFFFFFF, data, length);
+    }
+
+    crc32c_init_table();
+    return ~crc32c_software_update(0xFFFFFFFF, data, length);
+}
+
+/*
+ * CRC32C of the 18 bytes first | second | last in memory order, the shape of
+ * the inline allocator's checksummed header. Takes the fields by value so the
+ * hardware path is three crc32 instructions with no loop and no byte loads.
+ */
+uint32_t crc32c_header(uint64_t first, uint64_t second, uint16_t last)
+{
+    if (crc32c_has_hardware())
+    {
+        return crc32c_hardware_header(first, second, last);
+    }
+
+    uint8_t bytes[sizeof(first) + sizeof(second) + sizeof(last)];
+    memcpy(bytes, &first, sizeof(first));
+    memcpy(bytes + sizeof(first), &second, sizeof(second));
+    memcpy(bytes + sizeof(first) + sizeof(second), &last, sizeof(last));
+
+    crc32c_init_table();
+    return ~crc32c_software_update(0xFFFFFFFF, bytes, sizeof(bytes));
+}
+
 #endif /* A22AC708_4D34_4C8A_BF18_17748638D6F8 */
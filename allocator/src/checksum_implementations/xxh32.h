@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 #define XXH_PRIME32_1 0x9E3779B1U
 #define XXH_PRIME32_2 0x85EBCA77U
@@ -15,6 +16,14 @@ static inline uint32_t xxh_rotl32(uint32_t x, int r)
     return (x << r) | (x >> (32 - r));
 }
 
+/* inputs such as packed headers are not 4-byte aligned, memcpy keeps the load legal and still compiles to a single mov */
+static inline uint32_t xxh_read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
 uint32_t xxh32(const void *input, size_t length, uint32_t seed)
 {
     const uint8_t *p = (const uint8_t *)input;
@@ -31,22 +40,22 @@ uint32_t xxh32(const void *input, size_t length, uint32_t seed)
 
         while (p <= limit)
         {
-            v1 += (*(const uint32_t *)p) * XXH_PRIME32_2;
+            v1 += xxh_read32(p) * XXH_PRIME32_2;
             v1 = xxh_rotl32(v1, 13);
             v1 *= XXH_PRIME32_1;
             p += 4;
 
-            v2 += (*(const uint32_t *)p) * XXH_PRIME32_2;
+            v2 += xxh_read32(p) * XXH_PRIME32_2;
             v2 = xxh_rotl32(v2, 13);
             v2 *= XXH_PRIME32_1;
             p += 4;
 
-            v3 += (*(const uint32_t *)p) * XXH_PRIME32_2;
+            v3 += xxh_read32(p) * XXH_PRIME32_2;
             v3 = xxh_rotl32(v3, 13);
             v3 *= XXH_PRIME32_1;
             p += 4;
 
-            v4 += (*(const uint32_t *)p) * XXH_PRIME32_2;
+            v4 += xxh_read32(p) * XXH_PRIME32_2;
             v4 = xxh_rotl32(v4, 13);
             v4 *= XXH_PRIME32_1;
             p += 4;
@@ -63,7 +72,7 @@ uint32_t xxh32(const void *input, size_t length, uint32_t seed)
 
     while (p + 4 <= end)
     {
-        h32 += (*(const uint32_t *)p) * XXH_PRIME32_3;
+        h32 += xxh_read32(p) * XXH_PRIME32_3;
         h32 = xxh_rotl32(h32, 17) * XXH_PRIME32_4;
         p += 4;
     }
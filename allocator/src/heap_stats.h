@@ -0,0 +1,43 @@
+#ifndef E93C51B2_6A0D_4F7E_8E21_7B4D0A5C93F6
+#define E93C51B2_6A0D_4F7E_8E21_7B4D0A5C93F6
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HEAP_STATS_CLASS_COUNT (32) // size classes by power of two, the last one takes every larger size
+
+/*
+ * Allocator telemetry. Both allocators keep these counters up to date as they go, so a snapshot
+ * only copies them out and never walks the heap. Sizes are the usable sizes of the blocks handed
+ * out, not the sizes asked for.
+ */
+typedef struct
+{
+    size_t bytes_in_use; // live allocations
+    size_t peak_bytes_in_use;
+    size_t bytes_mapped;       // memory the allocator holds, metadata and free space included
+    size_t bytes_free;         // free space of the general heap
+    size_t largest_free_block; // largest request the general heap serves without growing
+    double fragmentation;      // external fragmentation index, 1 - largest_free_block / bytes_free
+    uint64_t allocs;
+    uint64_t frees;
+    uint64_t reallocs;      // heap_realloc calls on a live block, one that moves also counts an alloc and a free
+    uint64_t failed_allocs; // allocations that returned NULL
+    uint64_t coalesces;     // free blocks merged with a free neighbour
+    uint64_t live_by_class[HEAP_STATS_CLASS_COUNT]; // live allocations whose usable size has its highest bit at i
+} heap_stats_t;
+
+void heap_stats_snapshot(heap_stats_t *stats);
+
+static inline size_t heap_stats_class(size_t size)
+{
+    size_t index = (sizeof(unsigned long long) * 8 - 1) - (size_t)__builtin_clzll(size | 1);
+    return index < HEAP_STATS_CLASS_COUNT ? index : HEAP_STATS_CLASS_COUNT - 1;
+}
+
+static inline double heap_stats_fragmentation(size_t bytes_free, size_t largest_free_block)
+{
+    return bytes_free ? 1.0 - (double)largest_free_block / (double)bytes_free : 0.0;
+}
+
+#endif // E93C51B2_6A0D_4F7E_8E21_7B4D0A5C93F6
@@ -0,0 +1,508 @@
+/*
+ * Micro-benchmark for the custom allocators against glibc malloc.
+ *
+ * Build (segmented allocator, the default):
+ *     gcc -O2 allocator_bench.c -o allocator_bench -lpthread
+ * Build (inline allocator):
+ *     gcc -O2 -DINLINE_ALLOCATOR allocator_bench.c -o allocator_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#define MEM_IMPLEMENTATION
+#include "../allocator/mem_alloc.h"
+
+#define BENCH_ROUNDS (2000)
+#define BENCH_BATCH (256)
+#define BENCH_THREAD_BATCH (8)
+#define BENCH_MAX_THREADS (32)
+#define BENCH_GROWTH_COUNT (200000)
+#define BENCH_CHURN_OPS (200000)
+#define BENCH_CHURN_MAX_LIVE (4096)
+#define BENCH_GC_OBJECTS (100000)
+#define BENCH_GC_MAX_STEPS (200000)
+#define BENCH_GC_MUTATORS (4)
+#define BENCH_GC_COLLECTIONS (400) // full ones, then a tenth as many incremental cycles
+#define BENCH_GC_LIST_BYTES (4u << 20) // a mutator drops its list once it holds this much
+#define BENCH_GC_HUGE_SIZE (256 * 1024) // HUGE_THRESHOLD of the segmented heap
+
+typedef struct
+{
+    const char *name;
+    void *(*alloc)(size_t size);
+    void (*free)(void *ptr);
+} bench_allocator_t;
+
+static void *bench_heap_alloc(size_t size)
+{
+    return heap_alloc(size, ALIGN_8);
+}
+
+static void bench_heap_free(void *ptr)
+{
+    heap_free(ptr);
+}
+
+static const bench_allocator_t bench_allocators[] = {
+    {"custom", bench_heap_alloc, bench_heap_free},
+    {"malloc", malloc, free},
+};
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/* allocate a batch, then free it in LIFO order */
+static double bench_lifo(const bench_allocator_t *allocator, size_t size)
+{
+    void *ptrs[BENCH_BATCH];
+    uint64_t start = now_ns();
+
+    for (size_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (size_t i = 0; i < BENCH_BATCH; i++)
+        {
+            ptrs[i] = allocator->alloc(size);
+        }
+        for (size_t i = BENCH_BATCH; i > 0; i--)
+        {
+            allocator->free(ptrs[i - 1]);
+        }
+    }
+
+    return (double)(now_ns() - start) / (BENCH_ROUNDS * BENCH_BATCH * 2);
+}
+
+/* allocate a batch, then free it in a shuffled order */
+static double bench_random(const bench_allocator_t *allocator, size_t size)
+{
+    void *ptrs[BENCH_BATCH];
+    size_t order[BENCH_BATCH];
+    uint32_t seed = 0x2545F491;
+
+    for (size_t i = 0; i < BENCH_BATCH; i++)
+    {
+        order[i] = i;
+    }
+    for (size_t i = BENCH_BATCH - 1; i > 0; i--)
+    {
+        size_t j = xorshift32(&seed) % (i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    uint64_t start = now_ns();
+
+    for (size_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for (size_t i = 0; i < BENCH_BATCH; i++)
+        {
+            ptrs[i] = allocator->alloc(size);
+        }
+        for (size_t i = 0; i < BENCH_BATCH; i++)
+        {
+            allocator->free(ptrs[order[i]]);
+        }
+    }
+
+    return (double)(now_ns() - start) / (BENCH_ROUNDS * BENCH_BATCH * 2);
+}
+
+#ifndef INLINE_ALLOCATOR // only run against the segmented heap, see main
+typedef struct
+{
+    const bench_allocator_t *allocator;
+    size_t size;
+    size_t failures;
+} bench_thread_arg_t;
+
+static void *bench_thread_worker(void *arg)
+{
+    bench_thread_arg_t *thread_arg = (bench_thread_arg_t *)arg;
+    void *ptrs[BENCH_THREAD_BATCH];
+
+    for (size_t round = 0; round < BENCH_ROUNDS * 16; round++)
+    {
+        for (size_t i = 0; i < BENCH_THREAD_BATCH; i++)
+        {
+            ptrs[i] = thread_arg->allocator->alloc(thread_arg->size);
+            if (!ptrs[i])
+            {
+                thread_arg->failures++;
+            }
+        }
+        for (size_t i = BENCH_THREAD_BATCH; i > 0; i--)
+        {
+            thread_arg->allocator->free(ptrs[i - 1]);
+        }
+    }
+
+    return NULL;
+}
+
+/* every thread allocates and frees small batches concurrently, returns wall-clock ns per op over all threads */
+static double bench_threads(const bench_allocator_t *allocator, size_t size, size_t thread_count, size_t *failures)
+{
+    pthread_t threads[BENCH_MAX_THREADS];
+    bench_thread_arg_t args[BENCH_MAX_THREADS];
+
+    uint64_t start = now_ns();
+    for (size_t t = 0; t < thread_count; t++)
+    {
+        args[t] = (bench_thread_arg_t){allocator, size, 0};
+        pthread_create(&threads[t], NULL, bench_thread_worker, &args[t]);
+    }
+
+    *failures = 0;
+    for (size_t t = 0; t < thread_count; t++)
+    {
+        pthread_join(threads[t], NULL);
+        *failures += args[t].failures;
+    }
+
+    return (double)(now_ns() - start) / (thread_count * BENCH_ROUNDS * 16 * BENCH_THREAD_BATCH * 2);
+}
+
+/* hold BENCH_GROWTH_COUNT live objects at once, then release them all, returns ns per op */
+static double bench_growth(const bench_allocator_t *allocator, size_t size, size_t *failures)
+{
+    static void *ptrs[BENCH_GROWTH_COUNT];
+    uint64_t start = now_ns();
+
+    *failures = 0;
+    for (size_t i = 0; i < BENCH_GROWTH_COUNT; i++)
+    {
+        ptrs[i] = allocator->alloc(size);
+        if (!ptrs[i])
+        {
+            (*failures)++;
+        }
+    }
+    for (size_t i = 0; i < BENCH_GROWTH_COUNT; i++)
+    {
+        allocator->free(ptrs[i]);
+    }
+
+    return (double)(now_ns() - start) / (BENCH_GROWTH_COUNT * 2);
+}
+
+typedef struct
+{
+    double mean_ns;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+    uint64_t max_ns;
+} bench_latency_t;
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* replace random members of a live set with blocks of random general-heap sizes, timing every free + alloc pair */
+static bench_latency_t bench_churn(const bench_allocator_t *allocator, size_t live)
+{
+    static void *ptrs[BENCH_CHURN_MAX_LIVE];
+    static uint64_t latencies[BENCH_CHURN_OPS];
+    uint32_t seed = 0x9E3779B9;
+
+    for (size_t i = 0; i < live; i++)
+    {
+        ptrs[i] = allocator->alloc(1025 + xorshift32(&seed) % 15360);
+    }
+
+    uint64_t total = 0;
+    for (size_t op = 0; op < BENCH_CHURN_OPS; op++)
+    {
+        size_t i = xorshift32(&seed) % live;
+        size_t size = 1025 + xorshift32(&seed) % 15360;
+
+        uint64_t op_start = now_ns();
+        allocator->free(ptrs[i]);
+        ptrs[i] = allocator->alloc(size);
+        latencies[op] = now_ns() - op_start;
+        total += latencies[op];
+    }
+
+    for (size_t i = 0; i < live; i++)
+    {
+        allocator->free(ptrs[i]);
+    }
+
+    qsort(latencies, BENCH_CHURN_OPS, sizeof(latencies[0]), compare_u64);
+    return (bench_latency_t){
+        .mean_ns = (double)total / BENCH_CHURN_OPS,
+        .p50_ns = latencies[BENCH_CHURN_OPS / 2],
+        .p99_ns = latencies[BENCH_CHURN_OPS - BENCH_CHURN_OPS / 100],
+        .p999_ns = latencies[BENCH_CHURN_OPS - BENCH_CHURN_OPS / 1000],
+        .max_ns = latencies[BENCH_CHURN_OPS - 1],
+    };
+}
+#endif
+
+#ifdef GC_COLLECT
+typedef struct bench_gc_node
+{
+    struct bench_gc_node *next;
+    uint64_t payload[7];
+} bench_gc_node_t;
+
+static bench_gc_node_t *bench_gc_lists[64];
+
+/* keeps BENCH_GC_OBJECTS reachable linked objects, replacing some of them between steps */
+static void bench_gc_mutate(uint32_t *seed, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t list = xorshift32(seed) % 64;
+        bench_gc_node_t *node = heap_alloc(sizeof(bench_gc_node_t) + xorshift32(seed) % 2048, ALIGN_8);
+        node->next = bench_gc_lists[list] ? bench_gc_lists[list]->next : NULL;
+        gc_write_barrier(node->next);
+        if (bench_gc_lists[list])
+        {
+            bench_gc_lists[list]->next = node; // drops the old successor, which becomes garbage
+            gc_write_barrier(node);
+        }
+        else
+        {
+            bench_gc_lists[list] = node;
+        }
+    }
+}
+
+/* pause of one full gc_collect against the pauses of gc_step while the mutator keeps running */
+static void bench_gc(size_t budget)
+{
+    static uint64_t pauses[BENCH_GC_MAX_STEPS];
+    uint32_t seed = 0xC0FFEE;
+
+    memset(bench_gc_lists, 0, sizeof(bench_gc_lists));
+    bench_gc_mutate(&seed, BENCH_GC_OBJECTS);
+
+    uint64_t start = now_ns();
+    gc_collect();
+    uint64_t full = now_ns() - start;
+
+    gc_set_step_budget(budget);
+    size_t steps = 0, cycles = 0;
+    uint64_t total = 0;
+    while (cycles < 3 && steps < BENCH_GC_MAX_STEPS)
+    {
+        bench_gc_mutate(&seed, 8);
+
+        start = now_ns();
+        cycles += gc_step();
+        pauses[steps] = now_ns() - start;
+        total += pauses[steps++];
+    }
+
+    qsort(pauses, steps, sizeof(pauses[0]), compare_u64);
+    printf("%8zu %10.2f %8zu %10.2f %8llu %8llu %10llu\n", budget, full / 1000.0, steps / cycles,
+           (double)total / steps / 1000.0, (unsigned long long)pauses[steps / 2] / 1000,
+           (unsigned long long)pauses[steps - steps / 100 - 1] / 1000, (unsigned long long)pauses[steps - 1] / 1000);
+
+    memset(bench_gc_lists, 0, sizeof(bench_gc_lists));
+    gc_collect();
+}
+
+typedef struct bench_gc_link
+{
+    struct bench_gc_link *next;
+    size_t index;
+} bench_gc_link_t;
+
+typedef struct
+{
+    size_t size;
+    bool stop;
+    size_t failures;
+} bench_gc_mutator_arg_t;
+
+// walks at most length links, an object the collector freed and handed out again breaks the chain
+static bool bench_gc_check(const bench_gc_link_t *list, size_t length)
+{
+    for (; length; length--, list = list->next)
+    {
+        if (!list || list->index != length - 1)
+        {
+            return false;
+        }
+    }
+    return !list;
+}
+
+/* a registered thread whose list is only referenced from its own stack and registers */
+static void *bench_gc_mutator(void *arg)
+{
+    bench_gc_mutator_arg_t *mutator = (bench_gc_mutator_arg_t *)arg;
+    gc_register_thread();
+
+    bench_gc_link_t *list = NULL;
+    size_t length = 0;
+    while (!__atomic_load_n(&mutator->stop, __ATOMIC_RELAXED))
+    {
+        bench_gc_link_t *link = heap_alloc(mutator->size, ALIGN_8);
+        if (!link)
+        {
+            mutator->failures++;
+            break;
+        }
+        memset(link, 0, mutator->size); // also keeps the mutators of huge objects from outrunning the collector
+        link->next = list;
+        link->index = length++;
+        gc_write_barrier(list);
+        list = link;
+
+        if (length * mutator->size >= BENCH_GC_LIST_BYTES)
+        {
+            mutator->failures += !bench_gc_check(list, length);
+            list = NULL;
+            length = 0;
+        }
+    }
+    mutator->failures += !bench_gc_check(list, length);
+
+    gc_unregister_thread();
+    return NULL;
+}
+
+/* collections, full and incremental, while registered threads allocate; returns the broken lists */
+static size_t bench_gc_mutators(size_t size)
+{
+    pthread_t threads[BENCH_GC_MUTATORS];
+    bench_gc_mutator_arg_t args[BENCH_GC_MUTATORS];
+
+    for (size_t t = 0; t < BENCH_GC_MUTATORS; t++)
+    {
+        args[t] = (bench_gc_mutator_arg_t){size, false, 0};
+        pthread_create(&threads[t], NULL, bench_gc_mutator, &args[t]);
+    }
+
+    for (size_t c = 0; c < BENCH_GC_COLLECTIONS; c++)
+    {
+        gc_collect();
+    }
+    for (size_t c = 0; c < BENCH_GC_COLLECTIONS / 10; c++)
+    {
+        while (!gc_step())
+        {
+        }
+    }
+
+    size_t failures = 0;
+    for (size_t t = 0; t < BENCH_GC_MUTATORS; t++)
+    {
+        __atomic_store_n(&args[t].stop, true, __ATOMIC_RELAXED);
+        pthread_join(threads[t], NULL);
+        failures += args[t].failures;
+    }
+    gc_collect();
+    return failures;
+}
+#endif
+
+int main(void)
+{
+    static const size_t sizes[] = {8, 16, 32};
+
+#ifdef INLINE_ALLOCATOR
+    heap_init();
+#endif
+
+    printf("%-8s %-8s %6s %12s\n", "alloc", "pattern", "size", "ns/op");
+    for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+    {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            printf("%-8s %-8s %6zu %12.2f\n", bench_allocators[a].name, "lifo",
+                   sizes[s], bench_lifo(&bench_allocators[a], sizes[s]));
+            printf("%-8s %-8s %6zu %12.2f\n", bench_allocators[a].name, "random",
+                   sizes[s], bench_random(&bench_allocators[a], sizes[s]));
+        }
+    }
+
+#ifndef INLINE_ALLOCATOR
+    static const size_t thread_counts[] = {1, 2, 4, 8, 16, 32};
+
+    printf("\n%-8s %6s %8s %12s %10s\n", "alloc", "size", "threads", "ns/op", "failures");
+    for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+    {
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++)
+        {
+            size_t failures;
+            double ns = bench_threads(&bench_allocators[a], 16, thread_counts[t], &failures);
+            printf("%-8s %6d %8zu %12.2f %10zu\n", bench_allocators[a].name, 16, thread_counts[t], ns, failures);
+        }
+    }
+
+    static const size_t growth_sizes[] = {8, 48, 128, 1024};
+
+    printf("\n%-8s %-8s %6s %12s %10s\n", "alloc", "pattern", "size", "ns/op", "failures");
+    for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+    {
+        for (size_t s = 0; s < sizeof(growth_sizes) / sizeof(growth_sizes[0]); s++)
+        {
+            size_t failures;
+            double ns = bench_growth(&bench_allocators[a], growth_sizes[s], &failures);
+            printf("%-8s %-8s %6zu %12.2f %10zu\n", bench_allocators[a].name, "growth", growth_sizes[s], ns, failures);
+        }
+    }
+
+    static const size_t churn_live[] = {64, 512, 4096};
+
+    printf("\n%-8s %-8s %6s %10s %8s %8s %8s %10s\n", "alloc", "pattern", "live", "mean ns", "p50", "p99", "p99.9", "max");
+    for (size_t a = 0; a < sizeof(bench_allocators) / sizeof(bench_allocators[0]); a++)
+    {
+        for (size_t l = 0; l < sizeof(churn_live) / sizeof(churn_live[0]); l++)
+        {
+            bench_latency_t latency = bench_churn(&bench_allocators[a], churn_live[l]);
+            printf("%-8s %-8s %6zu %10.2f %8llu %8llu %8llu %10llu\n", bench_allocators[a].name, "churn",
+                   churn_live[l], latency.mean_ns, (unsigned long long)latency.p50_ns,
+                   (unsigned long long)latency.p99_ns, (unsigned long long)latency.p999_ns,
+                   (unsigned long long)latency.max_ns);
+        }
+    }
+
+#ifdef GC_COLLECT
+    static const size_t gc_budgets[] = {2048, 8192, 32768};
+
+    printf("\n%8s %10s %8s %10s %8s %8s %10s\n", "budget", "full us", "steps", "mean us", "p50 us", "p99 us", "max us");
+    for (size_t b = 0; b < sizeof(gc_budgets) / sizeof(gc_budgets[0]); b++)
+    {
+        bench_gc(gc_budgets[b]);
+    }
+
+    static const size_t gc_sizes[] = {40, 1024, BENCH_GC_HUGE_SIZE};
+
+    printf("\n%8s %8s %12s %10s\n", "size", "threads", "collections", "failures");
+    for (size_t s = 0; s < sizeof(gc_sizes) / sizeof(gc_sizes[0]); s++)
+    {
+        printf("%8zu %8d %12d %10zu\n", gc_sizes[s], BENCH_GC_MUTATORS, BENCH_GC_COLLECTIONS + BENCH_GC_COLLECTIONS / 10,
+               bench_gc_mutators(gc_sizes[s]));
+    }
+#endif
+#endif
+
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * Throughput and quality of the hashes of strix_hash.h, reported as JSON so runs can be diffed.
+ *
+ * Throughput: strix_hash64, strix_hash128, the streaming API fed in 4 KiB pieces and FNV-1a as a
+ * baseline, on random bytes from 4 B up to --max-size (64 MiB by default). Per result: ns/op
+ * (median and best of the timed rounds) and bytes/s.
+ *
+ * Quality, on strix_hash64 and on both halves of strix_hash128:
+ *   avalanche    flipping one input bit should flip every output bit with probability 1/2; the
+ *                worst and mean distance from 1/2 over all pairs of input and output bits
+ *   collisions   "key0", "key1", ... and 64 zero bytes with the key number in 4 of them; full collisions
+ *                (should be 0) and collisions of the low 32 bits next to the number expected of a
+ *                random function
+ *   buckets      the low 16 bits of the keys as table indexes; chi-square per degree of freedom,
+ *                close to 1 for a random function
+ *
+ * Build:
+ *     make bench
+ * Run (STRIX_FORCE_ISA=scalar|sse4.2|avx2|avx512 to compare instruction sets, see strix_cpu.h):
+ *     ./hash_bench [--max-size 1G] [--filter avalanche] > results.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../header/strix_hash.h"
+#include "../header/strix_cpu.h"
+
+#define BENCH_MIN_NS (20000000ull) // time spent on one result at least
+#define BENCH_MIN_ROUNDS (3)
+#define BENCH_MAX_ROUNDS (1000)
+#define BENCH_BATCH_BYTES (4 * 1024 * 1024) // input bytes per timed round at most
+#define BENCH_DEFAULT_MAX_SIZE (64ull << 20)
+#define BENCH_STREAM_PIECE (4096)
+#define BENCH_AVALANCHE_KEYS (400)
+#define BENCH_COLLISION_KEYS (1u << 22)
+#define BENCH_BUCKETS (1u << 16)
+
+typedef uint64_t (*bench_hash_t)(const uint8_t *data, size_t len);
+
+typedef struct
+{
+    const char *name;
+    bench_hash_t hash;
+    bool throughput;
+    bool quality;
+} bench_case_t;
+
+static volatile uint64_t bench_sink;
+static bool bench_first_result = true;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_random(uint64_t *state)
+{
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    uint64_t value = *state;
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    return value ^ (value >> 33);
+}
+
+static void bench_fill(uint8_t *data, size_t len, uint64_t seed)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        data[i] = (uint8_t)bench_random(&seed);
+    }
+}
+
+static void result_begin(void)
+{
+    printf("%s\n    {", bench_first_result ? "" : ",");
+    bench_first_result = false;
+}
+
+/* hashes, folded to 64 bits where the test only needs one value */
+
+static uint64_t hash_fnv1a(const uint8_t *data, size_t len)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ data[i]) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static uint64_t hash_64(const uint8_t *data, size_t len)
+{
+    return strix_hash64_bytes(data, len, 0);
+}
+
+static uint64_t hash_128(const uint8_t *data, size_t len)
+{
+    strix_hash128_t hash = strix_hash128_bytes(data, len, 0);
+    return hash.low ^ hash.high;
+}
+
+static uint64_t hash_128_low(const uint8_t *data, size_t len)
+{
+    return strix_hash128_bytes(data, len, 0).low;
+}
+
+static uint64_t hash_128_high(const uint8_t *data, size_t len)
+{
+    return strix_hash128_bytes(data, len, 0).high;
+}
+
+static uint64_t hash_stream(const uint8_t *data, size_t len)
+{
+    strix_hash_state_t state;
+    strix_hash_init(&state, 0);
+    for (size_t at = 0; at < len; at += BENCH_STREAM_PIECE)
+    {
+        strix_hash_update(&state, data + at, len - at < BENCH_STREAM_PIECE ? len - at : BENCH_STREAM_PIECE);
+    }
+    return strix_hash_digest64(&state);
+}
+
+/* throughput */
+
+static void bench_throughput(const bench_case_t *bench_case, const uint8_t *data, size_t size)
+{
+    static double round_ns[BENCH_MAX_ROUNDS];
+
+    size_t batch = BENCH_BATCH_BYTES / size;
+    batch = batch < 1 ? 1 : batch;
+
+    size_t rounds = 0;
+    uint64_t elapsed = 0;
+    while (rounds < BENCH_MAX_ROUNDS && (rounds < BENCH_MIN_ROUNDS || elapsed < BENCH_MIN_NS))
+    {
+        uint64_t sum = 0;
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < batch; i++)
+        {
+            sum += bench_case->hash(data, size - (i & 1)); // alternating lengths keep the calls from being merged
+        }
+        uint64_t round = now_ns() - start;
+        bench_sink += sum;
+
+        round_ns[rounds++] = (double)round / batch;
+        elapsed += round;
+    }
+
+    qsort(round_ns, rounds, sizeof(round_ns[0]), compare_double);
+    double ns = round_ns[rounds / 2];
+    result_begin();
+    printf("\"test\": \"throughput\", \"function\": \"%s\", \"size\": %zu, \"ops\": %zu, \"ns_per_op\": %.2f, "
+           "\"ns_per_op_min\": %.2f, \"bytes_per_sec\": %.0f}",
+           bench_case->name, size, rounds * batch, ns, round_ns[0], ns > 0 ? size * 1e9 / ns : 0.0);
+    fflush(stdout);
+}
+
+/* quality */
+
+static void bench_avalanche(const bench_case_t *bench_case, size_t len)
+{
+    size_t bits = len * 8;
+    uint32_t *flips = calloc(bits * 64, sizeof(uint32_t));
+    uint8_t *key = malloc(len);
+    if (!flips || !key)
+    {
+        free(flips);
+        free(key);
+        return;
+    }
+
+    uint64_t seed = len;
+    for (size_t k = 0; k < BENCH_AVALANCHE_KEYS; k++)
+    {
+        bench_fill(key, len, bench_random(&seed));
+        uint64_t base = bench_case->hash(key, len);
+        for (size_t bit = 0; bit < bits; bit++)
+        {
+            key[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+            uint64_t diff = base ^ bench_case->hash(key, len);
+            key[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+
+            for (; diff; diff &= diff - 1)
+            {
+                flips[bit * 64 + __builtin_ctzll(diff)]++;
+            }
+        }
+    }
+
+    double worst = 0, total = 0;
+    for (size_t i = 0; i < bits * 64; i++)
+    {
+        double bias = (double)flips[i] / BENCH_AVALANCHE_KEYS - 0.5;
+        bias = bias < 0 ? -bias : bias;
+        worst = bias > worst ? bias : worst;
+        total += bias;
+    }
+
+    result_begin();
+    printf("\"test\": \"avalanche\", \"function\": \"%s\", \"size\": %zu, \"keys\": %d, \"worst_bias\": %.4f, "
+           "\"mean_bias\": %.4f, \"random_mean_bias\": %.4f}",
+           bench_case->name, len, BENCH_AVALANCHE_KEYS, worst, total / (bits * 64),
+           0.3989 / __builtin_sqrt(BENCH_AVALANCHE_KEYS)); // mean |p - 1/2| of a fair coin, sqrt(1 / (2 pi n))
+    fflush(stdout);
+    free(flips);
+    free(key);
+}
+
+static void bench_key_set(const bench_case_t *bench_case, const char *keys, uint64_t *hashes)
+{
+    uint8_t key[64] = {0};
+    for (uint32_t i = 0; i < BENCH_COLLISION_KEYS; i++)
+    {
+        if (!strcmp(keys, "sequential"))
+        {
+            hashes[i] = bench_case->hash(key, (size_t)sprintf((char *)key, "key%u", i));
+        }
+        else
+        {
+            memcpy(key + 30, &i, sizeof(i));
+            hashes[i] = bench_case->hash(key, sizeof(key));
+        }
+    }
+}
+
+static void bench_collisions(const bench_case_t *bench_case, const char *keys)
+{
+    uint64_t *hashes = malloc(BENCH_COLLISION_KEYS * sizeof(uint64_t));
+    uint32_t *buckets = calloc(BENCH_BUCKETS, sizeof(uint32_t));
+    if (!hashes || !buckets)
+    {
+        free(hashes);
+        free(buckets);
+        return;
+    }
+
+    bench_key_set(bench_case, keys, hashes);
+
+    for (uint32_t i = 0; i < BENCH_COLLISION_KEYS; i++)
+    {
+        buckets[hashes[i] % BENCH_BUCKETS]++;
+    }
+    double expected = (double)BENCH_COLLISION_KEYS / BENCH_BUCKETS, chi_square = 0;
+    for (uint32_t i = 0; i < BENCH_BUCKETS; i++)
+    {
+        chi_square += (buckets[i] - expected) * (buckets[i] - expected) / expected;
+    }
+
+    // equal pairs in sorted order, once on full hashes and once on their low 32 bits
+    qsort(hashes, BENCH_COLLISION_KEYS, sizeof(uint64_t), compare_u64);
+    uint64_t full = 0;
+    for (uint32_t i = 1; i < BENCH_COLLISION_KEYS; i++)
+    {
+        full += hashes[i] == hashes[i - 1];
+    }
+    for (uint32_t i = 0; i < BENCH_COLLISION_KEYS; i++)
+    {
+        hashes[i] &= 0xFFFFFFFF;
+    }
+    qsort(hashes, BENCH_COLLISION_KEYS, sizeof(uint64_t), compare_u64);
+    uint64_t low = 0;
+    for (uint32_t i = 1; i < BENCH_COLLISION_KEYS; i++)
+    {
+        low += hashes[i] == hashes[i - 1];
+    }
+
+    double pairs = (double)BENCH_COLLISION_KEYS * (BENCH_COLLISION_KEYS - 1) / 2;
+    result_begin();
+    printf("\"test\": \"collisions\", \"function\": \"%s\", \"keys\": \"%s\", \"count\": %u, \"full\": %llu, "
+           "\"low32\": %llu, \"low32_expected\": %.0f, \"bucket_chi_square_per_df\": %.3f}",
+           bench_case->name, keys, BENCH_COLLISION_KEYS, (unsigned long long)full, (unsigned long long)low,
+           pairs / 4294967296.0, chi_square / (BENCH_BUCKETS - 1));
+    fflush(stdout);
+    free(hashes);
+    free(buckets);
+}
+
+static size_t parse_size(const char *arg)
+{
+    char *end;
+    unsigned long long size = strtoull(arg, &end, 10);
+    switch (*end)
+    {
+    case 'G':
+    case 'g':
+        size <<= 10;
+        // fall through
+    case 'M':
+    case 'm':
+        size <<= 10;
+        // fall through
+    case 'K':
+    case 'k':
+        size <<= 10;
+    }
+    return (size_t)size;
+}
+
+static bool selected(const char *filter, const char *test, const char *name)
+{
+    return !filter || strstr(test, filter) || strstr(name, filter);
+}
+
+int main(int argc, char **argv)
+{
+    static const bench_case_t cases[] = {
+        {"strix_hash64", hash_64, true, true},
+        {"strix_hash128", hash_128, true, false},
+        {"strix_hash128.low", hash_128_low, false, true},
+        {"strix_hash128.high", hash_128_high, false, true},
+        {"strix_hash_update", hash_stream, true, false}, // same values as strix_hash64
+        {"fnv1a", hash_fnv1a, true, true},
+    };
+    static const size_t avalanche_sizes[] = {3, 8, 16, 100, 200, 1024};
+
+    size_t max_size = BENCH_DEFAULT_MAX_SIZE;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--max-size") && i + 1 < argc)
+        {
+            max_size = parse_size(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--max-size BYTES[K|M|G]] [--filter SUBSTRING]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    uint8_t *data = malloc(max_size);
+    if (!data)
+    {
+        fprintf(stderr, "hash_bench: could not allocate %zu bytes\n", max_size);
+        return 1;
+    }
+    bench_fill(data, max_size, 1);
+
+    printf("{\n  \"suite\": \"strix_hash\",\n  \"isa\": \"%s\",\n  \"max_size\": %zu,\n  \"results\": [",
+           strix_cpu_isa_name(strix_cpu_isa()), max_size);
+
+    for (size_t size = 4; size <= max_size; size *= 4)
+    {
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+        {
+            if (cases[c].throughput && selected(filter, "throughput", cases[c].name))
+            {
+                bench_throughput(&cases[c], data, size);
+            }
+        }
+    }
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        if (!cases[c].quality)
+        {
+            continue;
+        }
+
+        for (size_t s = 0; s < sizeof(avalanche_sizes) / sizeof(avalanche_sizes[0]); s++)
+        {
+            if (selected(filter, "avalanche", cases[c].name))
+            {
+                bench_avalanche(&cases[c], avalanche_sizes[s]);
+            }
+        }
+        if (selected(filter, "collisions", cases[c].name))
+        {
+            bench_collisions(&cases[c], "sequential");
+            bench_collisions(&cases[c], "sparse");
+        }
+    }
+
+    printf("\n  ]\n}\n");
+    free(data);
+    return 0;
+}
@@ -0,0 +1,267 @@
+/*
+ * Sorting speed of strix_sort.h against qsort with strix_compare, reported as JSON so runs can be
+ * diffed.
+ *
+ * Datasets, from 1K strings up to --max-count (1M by default):
+ *   words        random lowercase words of 1 to 20 letters
+ *   urls         "https://example.com/..." paths sharing a 25 byte prefix
+ *   duplicates   64 distinct keys repeated
+ * Per result: ns per sort (median and best of the timed rounds) and ns per string. Every sort is
+ * checked against the qsort result; a mismatch is reported as "failed": true.
+ *
+ * Build:
+ *     make bench
+ * Run:
+ *     ./sort_bench [--max-count 4M] [--threads 8] [--filter urls] > results.json
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../header/strix_sort.h"
+
+#define BENCH_MIN_NS (200000000ull) // time spent on one result at least
+#define BENCH_MIN_ROUNDS (3)
+#define BENCH_MAX_ROUNDS (100)
+#define BENCH_DEFAULT_MAX_COUNT (1u << 20)
+#define BENCH_MAX_LEN (64)
+
+typedef bool (*bench_sort_t)(strix_arr_t *strix_arr, size_t threads);
+
+typedef struct
+{
+    const char *name;
+    bench_sort_t sort;
+} bench_case_t;
+
+static bool bench_first_result = true;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_strix(const void *a, const void *b)
+{
+    return strix_compare(*(strix_t *const *)a, *(strix_t *const *)b);
+}
+
+static uint64_t bench_random(uint64_t *state)
+{
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+    uint64_t value = *state;
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDull;
+    return value ^ (value >> 33);
+}
+
+static void result_begin(void)
+{
+    printf("%s\n    {", bench_first_result ? "" : ",");
+    bench_first_result = false;
+}
+
+/* sorts */
+
+static bool sort_qsort(strix_arr_t *strix_arr, size_t threads)
+{
+    (void)threads;
+    qsort(strix_arr->strix_arr, strix_arr->len, sizeof(strix_t *), compare_strix);
+    return true;
+}
+
+static bool sort_unstable(strix_arr_t *strix_arr, size_t threads)
+{
+    (void)threads;
+    return strix_arr_sort(strix_arr, STRIX_SORT_UNSTABLE);
+}
+
+static bool sort_stable(strix_arr_t *strix_arr, size_t threads)
+{
+    (void)threads;
+    return strix_arr_sort(strix_arr, STRIX_SORT_STABLE);
+}
+
+static bool sort_parallel(strix_arr_t *strix_arr, size_t threads)
+{
+    return strix_arr_sort_parallel(strix_arr, STRIX_SORT_UNSTABLE, threads);
+}
+
+/* datasets, every string gets BENCH_MAX_LEN bytes of one block */
+
+static void bench_dataset(const char *name, size_t count, strix_t *strings, char *bytes, strix_t **order)
+{
+    uint64_t seed = count;
+    for (size_t i = 0; i < count; i++)
+    {
+        char *str = bytes + i * BENCH_MAX_LEN;
+        size_t len;
+        if (!strcmp(name, "words"))
+        {
+            len = 1 + bench_random(&seed) % 20;
+            for (size_t j = 0; j < len; j++)
+            {
+                str[j] = (char)('a' + bench_random(&seed) % 26);
+            }
+        }
+        else if (!strcmp(name, "urls"))
+        {
+            uint64_t value = bench_random(&seed);
+            len = (size_t)snprintf(str, BENCH_MAX_LEN, "https://example.com/item/%u/%u", (unsigned)(value % 1000),
+                                   (unsigned)(value >> 32));
+        }
+        else
+        {
+            len = (size_t)snprintf(str, BENCH_MAX_LEN, "key-%u", (unsigned)(bench_random(&seed) % 64));
+        }
+        strings[i].str = str;
+        strings[i].len = len;
+        order[i] = &strings[i];
+    }
+}
+
+static void bench_sort(const bench_case_t *bench_case, const char *dataset, strix_t *const *input, strix_t *const *expected,
+                       size_t count, size_t threads)
+{
+    static double round_ns[BENCH_MAX_ROUNDS];
+
+    strix_arr_t strix_arr = {NULL, count};
+    strix_arr.strix_arr = malloc(count * sizeof(strix_t *));
+    if (!strix_arr.strix_arr)
+    {
+        return;
+    }
+
+    bool failed = false;
+    size_t rounds = 0;
+    uint64_t elapsed = 0;
+    while (rounds < BENCH_MAX_ROUNDS && (rounds < BENCH_MIN_ROUNDS || elapsed < BENCH_MIN_NS))
+    {
+        memcpy(strix_arr.strix_arr, input, count * sizeof(strix_t *));
+        uint64_t start = now_ns();
+        failed |= !bench_case->sort(&strix_arr, threads);
+        uint64_t round = now_ns() - start;
+
+        round_ns[rounds++] = (double)round;
+        elapsed += round;
+    }
+
+    for (size_t i = 0; i < count && !failed; i++)
+    {
+        failed = strix_compare(strix_arr.strix_arr[i], expected[i]) != 0;
+    }
+
+    qsort(round_ns, rounds, sizeof(round_ns[0]), compare_double);
+    double ns = round_ns[rounds / 2];
+    result_begin();
+    printf("\"dataset\": \"%s\", \"function\": \"%s\", \"count\": %zu, \"threads\": %zu, \"ns_per_sort\": %.0f, "
+           "\"ns_per_sort_min\": %.0f, \"ns_per_string\": %.2f, \"failed\": %s}",
+           dataset, bench_case->name, count, threads, ns, round_ns[0], ns / count, failed ? "true" : "false");
+    fflush(stdout);
+    free(strix_arr.strix_arr);
+}
+
+static size_t parse_count(const char *arg)
+{
+    char *end;
+    unsigned long long count = strtoull(arg, &end, 10);
+    switch (*end)
+    {
+    case 'M':
+    case 'm':
+        count <<= 10;
+        // fall through
+    case 'K':
+    case 'k':
+        count <<= 10;
+    }
+    return (size_t)count;
+}
+
+static bool selected(const char *filter, const char *dataset, const char *name)
+{
+    return !filter || strstr(dataset, filter) || strstr(name, filter);
+}
+
+int main(int argc, char **argv)
+{
+    static const bench_case_t cases[] = {
+        {"qsort", sort_qsort},
+        {"strix_arr_sort", sort_unstable},
+        {"strix_arr_sort.stable", sort_stable},
+        {"strix_arr_sort_parallel", sort_parallel},
+    };
+    static const char *const datasets[] = {"words", "urls", "duplicates"};
+
+    size_t max_count = BENCH_DEFAULT_MAX_COUNT;
+    size_t threads = 0;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--max-count") && i + 1 < argc)
+        {
+            max_count = parse_count(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+        {
+            threads = (size_t)strtoull(argv[++i], NULL, 10);
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--max-count COUNT[K|M]] [--threads N] [--filter SUBSTRING]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    strix_t *strings = malloc(max_count * sizeof(strix_t));
+    char *bytes = malloc(max_count * BENCH_MAX_LEN);
+    strix_t **input = malloc(max_count * sizeof(strix_t *));
+    strix_t **expected = malloc(max_count * sizeof(strix_t *));
+    if (!strings || !bytes || !input || !expected)
+    {
+        fprintf(stderr, "sort_bench: could not allocate %zu strings\n", max_count);
+        return 1;
+    }
+
+    printf("{\n  \"suite\": \"strix_sort\",\n  \"max_count\": %zu,\n  \"threads\": %zu,\n  \"results\": [", max_count,
+           threads);
+
+    for (size_t d = 0; d < sizeof(datasets) / sizeof(datasets[0]); d++)
+    {
+        for (size_t count = 1024; count <= max_count; count *= 4)
+        {
+            bench_dataset(datasets[d], count, strings, bytes, input);
+            memcpy(expected, input, count * sizeof(strix_t *));
+            qsort(expected, count, sizeof(strix_t *), compare_strix);
+
+            for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+            {
+                if (selected(filter, datasets[d], cases[c].name))
+                {
+                    bench_sort(&cases[c], datasets[d], input, expected, count, threads);
+                }
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+    free(strings);
+    free(bytes);
+    free(input);
+    free(expected);
+    return 0;
+}
@@ -0,0 +1,720 @@
+/*
+ * Benchmarks for the public functions of strix.h, reported as JSON so runs can be diffed.
+ *
+ * Every case runs on generated text from 16 B up to --max-size (16 MiB by default, 1 GiB at most).
+ * Searching, splitting, counting and joining also run with no, sparse (one per KiB) and dense (one
+ * per 16 B) matches of ",needle". Each case runs under malloc, the custom allocator of the build
+ * and a strix_arena_t. Per result: ns/op (median and best of the timed batches), input bytes/s and
+ * calls into the allocator per op. Whatever an op returns is freed inside the timed region, so
+ * strix_free, strix_free_strix_arr, strix_free_position and strix_free_char_arr are covered by the
+ * ops that need them. strix_modify is left out: it frees the strix_t it is given.
+ *
+ * Build (segmented allocator, the default; HEAP=inline for the inline allocator, whose 64 KiB heap
+ * fails the larger sizes):
+ *     make bench
+ * or without make:
+ *     gcc -O2 -DDEBUG_LOGGING=0 strix_bench.c ../source/main.c -o strix_bench -lpthread
+ * Run (STRIX_FORCE_ISA=scalar|sse4.2|avx2|avx512 to compare instruction sets, see strix_cpu.h):
+ *     ./strix_bench [--max-size 1G] [--filter split] > results.json
+ */
+
+#include <time.h>
+#include <unistd.h>
+
+#include "../header/strix.h"
+#include "../header/strix_arena.h"
+#include "../header/strix_allocator.h"
+#include "../header/strix_cpu.h"
+#include "../allocator/mem_alloc.h"
+
+#define BENCH_MIN_NS (20000000ull) // time spent on one result at least
+#define BENCH_MIN_ROUNDS (3)
+#define BENCH_MAX_ROUNDS (1000)
+#define BENCH_BATCH (256)                     // ops per timed round at most
+#define BENCH_BATCH_BYTES (64 * 1024 * 1024)  // input bytes per timed round at most
+#define BENCH_DEFAULT_MAX_SIZE (16ull << 20)
+#define BENCH_NEEDLE ",needle"
+#define BENCH_TAIL "0123456789abcdef"
+
+#ifdef INLINE_ALLOCATOR
+#define BENCH_CUSTOM_NAME "inline"
+#else
+#define BENCH_CUSTOM_NAME "segmented"
+#endif
+
+typedef struct
+{
+    size_t size;
+    const char *density;
+    char *cstr;          // the text, null terminated
+    strix_t *text;       // the text
+    strix_t *copy;       // equal to text, for strix_equal
+    strix_t *needle;     // BENCH_NEEDLE
+    strix_arr_t *parts;  // text split at ',', for the joins
+    char path[32];       // the text in a file, for conv_file_to_strix
+} bench_input_t;
+
+typedef bool (*bench_op_t)(const bench_input_t *input, strix_t *strix);
+
+typedef struct
+{
+    const char *name;
+    bench_op_t op;
+    bool fresh;   // changes its strix_t, every op gets its own copy of the text
+    bool sized;   // depends on the input size, otherwise runs once on the smallest input
+    bool matches; // depends on the match density, otherwise runs on text without matches
+} bench_case_t;
+
+typedef struct
+{
+    const char *name;
+    const strix_allocator_t *base;
+    bool arena;
+} bench_allocator_t;
+
+typedef struct
+{
+    const strix_allocator_t *base;
+    uint64_t calls;
+} bench_counter_t;
+
+static volatile uint64_t bench_sink;
+
+static strix_t *bench_double;
+static strix_t *bench_signed;
+static strix_t *bench_unsigned;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* counting allocator, sits between strix and the allocator under test */
+
+static void *counting_alloc(void *user_data, size_t size)
+{
+    bench_counter_t *counter = (bench_counter_t *)user_data;
+    counter->calls++;
+    return counter->base->alloc(counter->base->user_data, size);
+}
+
+static void *counting_realloc(void *user_data, void *ptr, size_t size)
+{
+    bench_counter_t *counter = (bench_counter_t *)user_data;
+    counter->calls++;
+    return counter->base->realloc(counter->base->user_data, ptr, size);
+}
+
+static void counting_free(void *user_data, void *ptr)
+{
+    bench_counter_t *counter = (bench_counter_t *)user_data;
+    counter->base->free(counter->base->user_data, ptr);
+}
+
+/* cases */
+
+static bool op_create(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = strix_create(input->cstr);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_create_empty(const bench_input_t *input, strix_t *strix)
+{
+    (void)input, (void)strix;
+    strix_t *result = strix_create_empty();
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_duplicate(const bench_input_t *input, strix_t *strix)
+{
+    strix_t *result = strix_duplicate(strix);
+    (void)input;
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_to_cstr(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    char *result = strix_to_cstr(strix);
+    bool ok = result != NULL;
+    free(result);
+    return ok;
+}
+
+static bool op_conv_file(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = conv_file_to_strix(input->path);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_clear(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_clear(strix);
+}
+
+static bool op_concat(const bench_input_t *input, strix_t *strix)
+{
+    return strix_concat(strix, input->text);
+}
+
+static bool op_append(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_append(strix, BENCH_TAIL);
+}
+
+// builds a string of the input size out of 16 byte appends
+static bool op_append_build(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = strix_create(BENCH_TAIL);
+    bool ok = result != NULL;
+    while (ok && result->len < input->size)
+    {
+        ok = strix_append(result, BENCH_TAIL);
+    }
+    strix_free(result);
+    return ok;
+}
+
+static bool op_insert(const bench_input_t *input, strix_t *strix)
+{
+    return strix_insert(strix, input->needle, strix->len / 2);
+}
+
+static bool op_insert_str(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_insert_str(strix, strix->len / 2, BENCH_NEEDLE);
+}
+
+static bool op_erase(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_erase(strix, strix->len / 2, strix->len / 4);
+}
+
+static bool op_delete_occurence(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_delete_occurence(strix, BENCH_NEEDLE);
+}
+
+static bool op_trim_whitespace(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_trim_whitespace(strix);
+}
+
+static bool op_trim_char(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    return strix_trim_char(strix, ' ');
+}
+
+static bool op_at(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    bench_sink += (uint64_t)strix_at(strix, strix->len / 2);
+    return true;
+}
+
+static bool op_equal(const bench_input_t *input, strix_t *strix)
+{
+    bench_sink += (uint64_t)strix_equal(strix, input->copy);
+    return true;
+}
+
+static bool op_compare(const bench_input_t *input, strix_t *strix)
+{
+    bench_sink += (uint64_t)strix_compare(strix, input->copy);
+    return strix_errno == STRIX_SUCCESS;
+}
+
+static bool op_equal_fast(const bench_input_t *input, strix_t *strix)
+{
+    bench_sink += (uint64_t)strix_equal_fast(strix, input->copy);
+    return strix_errno == STRIX_SUCCESS;
+}
+
+static bool op_find(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    bench_sink += (uint64_t)strix_find(strix, BENCH_NEEDLE);
+    return true;
+}
+
+static bool op_find_all(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    position_t *result = strix_find_all(strix, BENCH_NEEDLE);
+    bool ok = result != NULL;
+    strix_free_position(result);
+    return ok;
+}
+
+static bool op_find_subtrix(const bench_input_t *input, strix_t *strix)
+{
+    bench_sink += (uint64_t)strix_find_subtrix(strix, input->needle);
+    return true;
+}
+
+static bool op_find_subtrix_all(const bench_input_t *input, strix_t *strix)
+{
+    position_t *result = strix_find_subtrix_all(strix, input->needle);
+    bool ok = result != NULL;
+    strix_free_position(result);
+    return ok;
+}
+
+static bool op_find_all_char(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    position_t *result = strix_find_all_char(strix, ',');
+    bool ok = result != NULL;
+    strix_free_position(result);
+    return ok;
+}
+
+static bool op_find_unique_char(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    char_arr_t *result = strix_find_unique_char(strix);
+    bool ok = result != NULL;
+    strix_free_char_arr(result);
+    return ok;
+}
+
+static bool op_count_char(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    bench_sink += (uint64_t)strix_count_char(strix, ',');
+    return true;
+}
+
+static bool op_count_substr(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    bench_sink += (uint64_t)strix_count_substr(strix, BENCH_NEEDLE);
+    return true;
+}
+
+static bool op_count_substrix(const bench_input_t *input, strix_t *strix)
+{
+    bench_sink += (uint64_t)strix_count_substrix(strix, input->needle);
+    return true;
+}
+
+static bool op_split_by_delim(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    strix_arr_t *result = strix_split_by_delim(strix, ',');
+    bool ok = result != NULL;
+    strix_free_strix_arr(result);
+    return ok;
+}
+
+static bool op_split_by_substr(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    strix_arr_t *result = strix_split_by_substr(strix, BENCH_NEEDLE);
+    bool ok = result != NULL;
+    strix_free_strix_arr(result);
+    return ok;
+}
+
+static bool op_split_by_substrix(const bench_input_t *input, strix_t *strix)
+{
+    strix_arr_t *result = strix_split_by_substrix(strix, input->needle);
+    bool ok = result != NULL;
+    strix_free_strix_arr(result);
+    return ok;
+}
+
+static bool op_slice(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    strix_t *result = strix_slice(strix, strix->len / 4, strix->len / 4 * 3);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_slice_by_stride(const bench_input_t *input, strix_t *strix)
+{
+    (void)input;
+    strix_t *result = strix_slice_by_stride(strix, 0, strix->len - 1, 4);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_join_via_delim(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = strix_join_via_delim((const strix_t **)input->parts->strix_arr, input->parts->len, ',');
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_join_via_substr(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = strix_join_via_substr((const strix_t **)input->parts->strix_arr, input->parts->len, BENCH_NEEDLE);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_join_via_substrix(const bench_input_t *input, strix_t *strix)
+{
+    (void)strix;
+    strix_t *result = strix_join_via_substrix((const strix_t **)input->parts->strix_arr, input->parts->len, input->needle);
+    bool ok = result != NULL;
+    strix_free(result);
+    return ok;
+}
+
+static bool op_to_double(const bench_input_t *input, strix_t *strix)
+{
+    (void)input, (void)strix;
+    bench_sink += (uint64_t)strix_to_double(bench_double);
+    return strix_errno == STRIX_SUCCESS;
+}
+
+static bool op_to_signed_int(const bench_input_t *input, strix_t *strix)
+{
+    (void)input, (void)strix;
+    bench_sink += (uint64_t)strix_to_signed_int(bench_signed);
+    return strix_errno == STRIX_SUCCESS;
+}
+
+static bool op_to_unsigned_int(const bench_input_t *input, strix_t *strix)
+{
+    (void)input, (void)strix;
+    bench_sink += strix_to_unsigned_int(bench_unsigned);
+    return strix_errno == STRIX_SUCCESS;
+}
+
+static const bench_case_t bench_cases[] = {
+    {"strix_create", op_create, false, true, false},
+    {"strix_create_empty", op_create_empty, false, false, false},
+    {"strix_duplicate", op_duplicate, false, true, false},
+    {"strix_to_cstr", op_to_cstr, false, true, false},
+    {"conv_file_to_strix", op_conv_file, false, true, false},
+    {"strix_clear", op_clear, true, true, false},
+    {"strix_concat", op_concat, true, true, false},
+    {"strix_append", op_append, true, true, false},
+    {"strix_append_build", op_append_build, false, true, false},
+    {"strix_insert", op_insert, true, true, false},
+    {"strix_insert_str", op_insert_str, true, true, false},
+    {"strix_erase", op_erase, true, true, false},
+    {"strix_delete_occurence", op_delete_occurence, true, true, true},
+    {"strix_trim_whitespace", op_trim_whitespace, true, true, false},
+    {"strix_trim_char", op_trim_char, true, true, false},
+    {"strix_at", op_at, false, false, false},
+    {"strix_equal", op_equal, false, true, false},
+    {"strix_compare", op_compare, false, true, false},
+    {"strix_equal_fast", op_equal_fast, false, true, false},
+    {"strix_find", op_find, false, true, true},
+    {"strix_find_all", op_find_all, false, true, true},
+    {"strix_find_subtrix", op_find_subtrix, false, true, true},
+    {"strix_find_subtrix_all", op_find_subtrix_all, false, true, true},
+    {"strix_find_all_char", op_find_all_char, false, true, true},
+    {"strix_find_unique_char", op_find_unique_char, false, true, false},
+    {"strix_count_char", op_count_char, false, true, true},
+    {"strix_count_substr", op_count_substr, false, true, true},
+    {"strix_count_substrix", op_count_substrix, false, true, true},
+    {"strix_split_by_delim", op_split_by_delim, false, true, true},
+    {"strix_split_by_substr", op_split_by_substr, false, true, true},
+    {"strix_split_by_substrix", op_split_by_substrix, false, true, true},
+    {"strix_slice", op_slice, false, true, false},
+    {"strix_slice_by_stride", op_slice_by_stride, false, true, false},
+    {"strix_join_via_delim", op_join_via_delim, false, true, true},
+    {"strix_join_via_substr", op_join_via_substr, false, true, true},
+    {"strix_join_via_substrix", op_join_via_substrix, false, true, true},
+    {"strix_to_double", op_to_double, false, false, false},
+    {"strix_to_signed_int", op_to_signed_int, false, false, false},
+    {"strix_to_unsigned_int", op_to_unsigned_int, false, false, false},
+};
+
+/* inputs */
+
+// words without ',' or "needle", spaces at both ends for the trims, ",needle" every period bytes
+static bool bench_input_build(bench_input_t *input, size_t size, const char *density, size_t period)
+{
+    static const char words[] = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod tempor ";
+    size_t needle_len = strlen(BENCH_NEEDLE);
+
+    memset(input, 0, sizeof(*input));
+    input->size = size;
+    input->density = density;
+
+    input->cstr = (char *)malloc(size + 1);
+    if (!input->cstr)
+    {
+        return false;
+    }
+
+    for (size_t i = 0, w = 0; i < size; i++, w = (w + 1) % (sizeof(words) - 1))
+    {
+        input->cstr[i] = words[w];
+    }
+    for (size_t i = period ? period / 2 : size; i + needle_len < size; i += period)
+    {
+        memcpy(input->cstr + i, BENCH_NEEDLE, needle_len);
+    }
+    input->cstr[0] = input->cstr[size - 1] = ' ';
+    input->cstr[size] = 0;
+
+    // inputs live with malloc whatever allocator is under test
+    STRIX_WITH_ALLOCATOR(&strix_allocator_libc)
+    {
+        input->text = strix_create(input->cstr);
+        input->copy = strix_create(input->cstr);
+        input->needle = strix_create(BENCH_NEEDLE);
+        input->parts = input->text ? strix_split_by_delim(input->text, ',') : NULL;
+    }
+    if (!input->text || !input->copy || !input->needle || !input->parts)
+    {
+        return false;
+    }
+
+    strcpy(input->path, "/tmp/strix_bench_XXXXXX");
+    int fd = mkstemp(input->path);
+    if (fd < 0)
+    {
+        input->path[0] = 0;
+        return false;
+    }
+    bool written = write(fd, input->cstr, size) == (ssize_t)size;
+    close(fd);
+    return written;
+}
+
+static void bench_input_free(bench_input_t *input)
+{
+    STRIX_WITH_ALLOCATOR(&strix_allocator_libc)
+    {
+        strix_free(input->text);
+        strix_free(input->copy);
+        strix_free(input->needle);
+        strix_free_strix_arr(input->parts);
+    }
+    if (input->path[0])
+    {
+        unlink(input->path);
+    }
+    free(input->cstr);
+}
+
+/* runner */
+
+static bool bench_first_result = true;
+
+static void bench_run(const bench_case_t *bench_case, const bench_allocator_t *allocator, const bench_input_t *input)
+{
+    static strix_t *copies[BENCH_BATCH];
+    static double round_ns[BENCH_MAX_ROUNDS];
+
+    size_t batch = BENCH_BATCH_BYTES / input->size;
+    batch = batch < 1 ? 1 : batch > BENCH_BATCH ? BENCH_BATCH : batch;
+
+    bench_counter_t counter = {allocator->base, 0};
+    strix_allocator_t counting = {counting_alloc, counting_realloc, counting_free, &counter};
+    strix_allocator_set(&counting);
+
+    strix_arena_t *arena = allocator->arena ? strix_arena_create(0) : NULL;
+    bool failed = allocator->arena && !arena;
+
+    size_t rounds = 0;
+    uint64_t calls = 0, elapsed = 0;
+    while (!failed && rounds < BENCH_MAX_ROUNDS && (rounds < BENCH_MIN_ROUNDS || elapsed < BENCH_MIN_NS))
+    {
+        for (size_t i = 0; bench_case->fresh && i < batch; i++)
+        {
+            copies[i] = strix_duplicate(input->text);
+            failed |= copies[i] == NULL;
+        }
+
+        if (arena)
+        {
+            strix_arena_scope_begin(arena);
+        }
+
+        uint64_t calls_before = counter.calls;
+        uint64_t start = now_ns();
+        for (size_t i = 0; !failed && i < batch; i++)
+        {
+            failed |= !bench_case->op(input, bench_case->fresh ? copies[i] : input->text);
+        }
+        uint64_t round = now_ns() - start;
+        calls += counter.calls - calls_before;
+
+        if (arena)
+        {
+            strix_arena_scope_end(arena);
+            strix_arena_reset(arena);
+        }
+
+        for (size_t i = 0; bench_case->fresh && i < batch; i++)
+        {
+            strix_free(copies[i]);
+        }
+
+        round_ns[rounds++] = (double)round / batch;
+        elapsed += round;
+    }
+
+    strix_arena_destroy(arena);
+    strix_allocator_set(NULL);
+
+    printf("%s\n    {\"function\": \"%s\", \"allocator\": \"%s\", \"size\": %zu, \"density\": \"%s\", ",
+           bench_first_result ? "" : ",", bench_case->name, allocator->name, input->size, input->density);
+    bench_first_result = false;
+    if (failed)
+    {
+        printf("\"failed\": true}");
+        return;
+    }
+
+    qsort(round_ns, rounds, sizeof(round_ns[0]), compare_double);
+    double ns = round_ns[rounds / 2];
+    printf("\"failed\": false, \"ops\": %zu, \"ns_per_op\": %.2f, \"ns_per_op_min\": %.2f, "
+           "\"bytes_per_sec\": %.0f, \"allocs_per_op\": %.3f}",
+           rounds * batch, ns, round_ns[0], ns > 0 ? input->size * 1e9 / ns : 0.0, (double)calls / (rounds * batch));
+    fflush(stdout);
+}
+
+static size_t parse_size(const char *arg)
+{
+    char *end;
+    unsigned long long size = strtoull(arg, &end, 10);
+    switch (*end)
+    {
+    case 'G':
+    case 'g':
+        size <<= 10;
+        // fall through
+    case 'M':
+    case 'm':
+        size <<= 10;
+        // fall through
+    case 'K':
+    case 'k':
+        size <<= 10;
+    }
+    return (size_t)size;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t sizes[] = {16, 256, 4096, 64 << 10, 1 << 20, 16 << 20, 256 << 20, 1 << 30};
+    static const struct
+    {
+        const char *name;
+        size_t period; // bytes between matches, 0 for none
+    } densities[] = {{"none", 0}, {"sparse", 1024}, {"dense", 16}};
+    static const bench_allocator_t allocators[] = {
+        {"malloc", &strix_allocator_libc, false},
+        {BENCH_CUSTOM_NAME, &strix_allocator_heap, false},
+        {"arena", &strix_allocator_libc, true},
+    };
+
+    size_t max_size = BENCH_DEFAULT_MAX_SIZE;
+    const char *filter = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--max-size") && i + 1 < argc)
+        {
+            max_size = parse_size(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--max-size BYTES[K|M|G]] [--filter SUBSTRING]\n", argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef INLINE_ALLOCATOR
+    heap_init();
+#endif
+
+    STRIX_WITH_ALLOCATOR(&strix_allocator_libc)
+    {
+        bench_double = strix_create("-12345.6789012345");
+        bench_signed = strix_create("-1234567890123456789");
+        bench_unsigned = strix_create("18446744073709551615");
+    }
+
+    printf("{\n  \"suite\": \"strix\",\n  \"isa\": \"%s\",\n  \"custom_allocator\": \"%s\",\n  \"max_size\": %zu,\n  \"results\": [",
+           strix_cpu_isa_name(strix_cpu_isa()), BENCH_CUSTOM_NAME, max_size);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= max_size; s++)
+    {
+        for (size_t d = 0; d < sizeof(densities) / sizeof(densities[0]); d++)
+        {
+            bench_input_t input;
+            if (!bench_input_build(&input, sizes[s], densities[d].name, densities[d].period))
+            {
+                fprintf(stderr, "strix_bench: could not build the %zu byte %s input\n", sizes[s], densities[d].name);
+                bench_input_free(&input);
+                return 1;
+            }
+
+            for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++)
+            {
+                const bench_case_t *bench_case = &bench_cases[c];
+                if ((filter && !strstr(bench_case->name, filter)) || (!bench_case->sized && s > 0) ||
+                    (!bench_case->matches && d > 0))
+                {
+                    continue;
+                }
+
+                fprintf(stderr, "%-24s %10zu %-6s\n", bench_case->name, sizes[s], densities[d].name);
+                for (size_t a = 0; a < sizeof(allocators) / sizeof(allocators[0]); a++)
+                {
+                    bench_run(bench_case, &allocators[a], &input);
+                }
+            }
+
+            bench_input_free(&input);
+        }
+    }
+
+    printf("\n  ]\n}\n");
+
+    STRIX_WITH_ALLOCATOR(&strix_allocator_libc)
+    {
+        strix_free(bench_double);
+        strix_free(bench_signed);
+        strix_free(bench_unsigned);
+    }
+    return 0;
+}
+
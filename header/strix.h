@@ -201,6 +201,35 @@ char strix_at(const strix_t *strix, size_t index);
  */
 int strix_equal(const strix_t *strix_one, const strix_t *strix_two);
 
+/**
+ * @brief Orders two strix_t structures byte by byte, as unsigned bytes
+ *
+ * Embedded null bytes are compared like any other byte. When one string is a prefix of the other,
+ * the shorter one comes first.
+ *
+ * @param strix_one First strix_t structure to compare
+ * @param strix_two Second strix_t structure to compare
+ * @return int -1 if strix_one sorts first, 0 if both are equal, 1 if strix_two sorts first
+ *
+ * Edge cases:
+ * - Returns 0 with strix_errno set if either input is NULL
+ * - Returns 0 with strix_errno set if either string is NULL while its length is not 0
+ */
+int strix_compare(const strix_t *strix_one, const strix_t *strix_two);
+
+/**
+ * @brief Tells whether two strix_t structures hold the same bytes, as cheaply as possible
+ *
+ * Checks the lengths and the first and last 8 bytes before comparing the rest, so most unequal
+ * strings of equal length are told apart without a full comparison. Strings of up to 16 bytes are
+ * never compared further.
+ *
+ * @param strix_one First strix_t structure to compare
+ * @param strix_two Second strix_t structure to compare
+ * @return bool true if both strings are equal, false otherwise or on error (strix_errno is set)
+ */
+bool strix_equal_fast(const strix_t *strix_one, const strix_t *strix_two);
+
 /**
  * @brief Finds first occurrence of substring in strix_t structure
  *
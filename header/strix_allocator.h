@@ -0,0 +1,74 @@
+#ifndef F2A86C3E_5D19_4B07_8E4A_1C9B7D36E0A5
+#define F2A86C3E_5D19_4B07_8E4A_1C9B7D36E0A5
+
+#include <stddef.h>
+
+/**
+ * @brief Allocator used by strix for every string and array it creates
+ *
+ * Each thread has its own current allocator, so switching it never races with other threads.
+ * Memory must be resized and freed under the allocator that handed it out: create, grow and free
+ * a strix_t under the same allocator.
+ *
+ * Example usage:
+ * @code
+ * static void *pool_alloc(void *pool, size_t size) { return my_pool_alloc(pool, size); }
+ * static void *pool_realloc(void *pool, void *ptr, size_t size) { return my_pool_realloc(pool, ptr, size); }
+ * static void pool_free(void *pool, void *ptr) { my_pool_free(pool, ptr); }
+ *
+ * strix_allocator_t pool_allocator = {pool_alloc, pool_realloc, pool_free, my_pool};
+ * const strix_allocator_t *previous = strix_allocator_set(&pool_allocator);
+ * strix_t *strix = strix_create("served by my_pool");
+ * strix_free(strix);
+ * strix_allocator_set(previous);
+ * @endcode
+ */
+typedef struct strix_allocator
+{
+    void *(*alloc)(void *user_data, size_t size);
+    void *(*realloc)(void *user_data, void *ptr, size_t size); // same contract as realloc(3)
+    void (*free)(void *user_data, void *ptr);                   // never called with NULL
+    void *user_data;                                            // passed back to every callback
+} strix_allocator_t;
+
+extern const strix_allocator_t strix_allocator_libc; // malloc, realloc and free
+extern const strix_allocator_t strix_allocator_heap; // the allocator in allocator/, see mem_alloc.h
+
+/**
+ * @brief Returns the allocator of the calling thread
+ *
+ * @return const strix_allocator_t* Current allocator, strix_allocator_heap when built with
+ * CUSTOM_ALLOCATOR and strix_allocator_libc otherwise unless strix_allocator_set changed it
+ */
+const strix_allocator_t *strix_allocator_get(void);
+
+/**
+ * @brief Makes allocator serve the strix allocations of the calling thread
+ *
+ * Other threads are not affected. An active arena scope (see strix_arena.h) still takes
+ * precedence, the arena itself takes its blocks from this allocator.
+ *
+ * @param allocator Allocator to install, NULL for the build default; must outlive its use
+ * @return const strix_allocator_t* Allocator that was current before the call
+ */
+const strix_allocator_t *strix_allocator_set(const strix_allocator_t *allocator);
+
+/**
+ * @brief Runs the statement or block that follows with allocator as the allocator of the thread
+ *
+ * Leaving the block with break, goto or return skips restoring the previous allocator.
+ *
+ * Example usage:
+ * @code
+ * STRIX_WITH_ALLOCATOR(&pool_allocator)
+ * {
+ *     strix_append(strix, " more");
+ * }
+ * @endcode
+ */
+#define STRIX_WITH_ALLOCATOR(allocator)                                                              \
+    for (const strix_allocator_t *strix_previous_allocator_ = strix_allocator_set(allocator),       \
+                                 *strix_allocator_once_ = strix_allocator_get();                     \
+         strix_allocator_once_; strix_allocator_set(strix_previous_allocator_), strix_allocator_once_ = NULL)
+
+#endif /* F2A86C3E_5D19_4B07_8E4A_1C9B7D36E0A5 */
@@ -0,0 +1,128 @@
+#ifndef C7F1D2A4_3B8E_4E59_9A06_5D2C8B71E4F3
+#define C7F1D2A4_3B8E_4E59_9A06_5D2C8B71E4F3
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "strix.h"
+
+/**
+ * @brief Bump-pointer arena for request-scoped strix work
+ *
+ * While an arena scope is active on a thread, every strix object that thread creates is carved
+ * out of the arena: allocation is a pointer bump, strix_free and friends are no-ops for arena
+ * memory, and strix_arena_reset hands all of it back at once. Objects created before the scope
+ * keep living on the heap, and changing them inside the scope keeps them there. Arena objects can
+ * still be read after the scope ends, up to the reset, but are only changed or freed inside it.
+ *
+ * Anything that has to outlive strix_arena_reset must be copied out with strix_arena_promote or
+ * strix_arena_promote_arr first. An arena is used by one thread at a time.
+ *
+ * Example usage:
+ * @code
+ * strix_arena_t *arena = strix_arena_create(0);
+ * strix_arena_scope_begin(arena);
+ * strix_t *line = strix_create("key=value");
+ * strix_arr_t *parts = strix_split_by_delim(line, '=');
+ * strix_t *key = strix_arena_promote(parts->strix_arr[0]); // survives the reset
+ * strix_arena_scope_end(arena);
+ * strix_arena_reset(arena); // line and parts are gone
+ * @endcode
+ */
+typedef struct strix_arena strix_arena_t;
+
+#define STRIX_ARENA_DEFAULT_BLOCK_SIZE (64 * 1024) // size of the first block, later ones double
+
+/**
+ * @brief Creates an empty arena
+ *
+ * The arena and its blocks come from the allocator of the calling thread (see strix_allocator.h),
+ * whichever thread grows or destroys it later.
+ *
+ * @param block_size Size of the first block taken from the heap, 0 for STRIX_ARENA_DEFAULT_BLOCK_SIZE
+ * @return strix_arena_t* New arena, or NULL if memory allocation fails
+ */
+strix_arena_t *strix_arena_create(size_t block_size);
+
+/**
+ * @brief Returns every block of the arena to the heap and frees the arena
+ *
+ * Ends the scope of the arena first if it is active on the calling thread, innermost or not. Scopes
+ * begun inside it stay active, and ending them restores the scope that was active before it.
+ *
+ * @param arena Arena to destroy (may be NULL)
+ */
+void strix_arena_destroy(strix_arena_t *arena);
+
+/**
+ * @brief Frees everything allocated from the arena in O(1)
+ *
+ * The blocks stay with the arena and are reused by the next allocations.
+ *
+ * @param arena Arena to reset (may be NULL)
+ */
+void strix_arena_reset(strix_arena_t *arena);
+
+/**
+ * @brief Makes the arena serve all strix allocations of the calling thread
+ *
+ * Scopes nest: the innermost one serves new allocations, memory of an outer arena is still
+ * recognised and left alone by deallocations in an inner scope.
+ *
+ * @param arena Arena to install
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if arena is NULL
+ * - Returns false with STRIX_ERR_ARENA_SCOPE if the arena is already in a scope
+ */
+bool strix_arena_scope_begin(strix_arena_t *arena);
+
+/**
+ * @brief Ends the scope of the arena, restoring the scope that was active before it
+ *
+ * @param arena Arena whose scope ends, must be the innermost one of the calling thread
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if arena is NULL
+ * - Returns false with STRIX_ERR_ARENA_SCOPE if the arena is not the innermost scope
+ */
+bool strix_arena_scope_end(strix_arena_t *arena);
+
+/**
+ * @brief Allocates raw bytes from the arena, whether it is in a scope or not
+ *
+ * The memory is 16 byte aligned and lives until the arena is reset or destroyed. Containers use it
+ * to keep copies of their keys next to the strings of a request.
+ *
+ * @param arena Arena to allocate from
+ * @param size Number of bytes
+ * @return void* Start of the bytes, or NULL on failure
+ *
+ * Edge cases:
+ * - Returns NULL if arena is NULL
+ * - Returns NULL if memory allocation fails
+ */
+void *strix_arena_alloc(strix_arena_t *arena, size_t size);
+
+/**
+ * @brief Copies a strix_t onto the heap so it survives the reset of its arena
+ *
+ * @param strix Strix to copy, from an arena or not
+ * @return strix_t* Heap copy to be released with strix_free, or NULL on failure (see strix_duplicate)
+ */
+strix_t *strix_arena_promote(const strix_t *strix);
+
+/**
+ * @brief Copies a strix_arr_t and all its strings onto the heap
+ *
+ * @param strix_arr Array to copy
+ * @return strix_arr_t* Heap copy to be released with strix_free_strix_arr, or NULL on failure
+ *
+ * Edge cases:
+ * - Returns NULL if strix_arr is NULL
+ * - Returns NULL if memory allocation fails
+ */
+strix_arr_t *strix_arena_promote_arr(const strix_arr_t *strix_arr);
+
+#endif /* C7F1D2A4_3B8E_4E59_9A06_5D2C8B71E4F3 */
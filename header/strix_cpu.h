@@ -0,0 +1,51 @@
+#ifndef E0C4A7D2_3B91_4F6E_A8D5_72C1F9B06E34
+#define E0C4A7D2_3B91_4F6E_A8D5_72C1F9B06E34
+
+#include <stdbool.h>
+
+/**
+ * @brief Instruction sets the hot loops of strix have implementations for
+ *
+ * Searching, counting, splitting and trimming run through one table of kernels. Before main runs,
+ * the table is bound to the best set the CPU supports. Setting the STRIX_FORCE_ISA environment
+ * variable to scalar, sse4.2, avx2 or avx512 caps the choice for testing and benchmarking. A set
+ * the CPU lacks falls back to the best one below it, and unknown values are ignored.
+ *
+ * Example usage:
+ * @code
+ * $ STRIX_FORCE_ISA=scalar ./strix_bench --filter find
+ * @endcode
+ */
+typedef enum
+{
+    STRIX_ISA_SCALAR, ///< Portable C, the only choice off x86
+    STRIX_ISA_SSE42,  ///< 16 byte vectors, SSE4.2 and POPCNT
+    STRIX_ISA_AVX2,   ///< 32 byte vectors
+    STRIX_ISA_AVX512, ///< 64 byte vectors, AVX-512 F and BW
+    STRIX_ISA_COUNT,
+} strix_isa_t;
+
+/**
+ * @brief Returns the instruction set the kernels are bound to
+ *
+ * @return strix_isa_t The best set the CPU supports, lowered by STRIX_FORCE_ISA
+ */
+strix_isa_t strix_cpu_isa(void);
+
+/**
+ * @brief Tells whether the CPU and the operating system support an instruction set
+ *
+ * @param isa Instruction set to check
+ * @return bool true if the kernels for isa can run on this machine
+ */
+bool strix_cpu_supports(strix_isa_t isa);
+
+/**
+ * @brief Returns the name of an instruction set, as accepted by STRIX_FORCE_ISA
+ *
+ * @param isa Instruction set
+ * @return const char* "scalar", "sse4.2", "avx2" or "avx512", "unknown" for anything else
+ */
+const char *strix_cpu_isa_name(strix_isa_t isa);
+
+#endif /* E0C4A7D2_3B91_4F6E_A8D5_72C1F9B06E34 */
@@ -28,6 +28,7 @@ typedef enum
     STRIX_ERR_INT_OVERFLOW,         ///< Integer in the strix string overflows 8 bytes
     STRIX_ERR_INVALID_STRIDE,       ///< Invalid stride given
     STRIX_ERR_STDIO,                ///< Error from the stdio library while doing operations on the given file\nSee thread local errno for more information on the error
+    STRIX_ERR_ARENA_SCOPE,          ///< Arena scope entered twice or left out of order
 } strix_error_t;
 
 /* _Thread_local has been supported since C11 */
@@ -39,32 +40,7 @@ typedef enum
  * It is automatically initialized to STRIX_SUCCESS and updated by strix functions when errors occur.
  * Each thread maintains its own independent error state.
  */
-static _Thread_local strix_error_t strix_errno = STRIX_SUCCESS;
-
-/**
- * @brief Array of human-readable error messages
- *
- * Contains descriptive messages corresponding to each error code in strix_error_t.
- * The index of each message matches its corresponding error code value.
- * Used by strix_perror to provide human-readable error descriptions.
- */
-static const char *strix_error_messages[] = {
-    "Success",
-    "Null pointer argument",
-    "Memory allocation failed",
-    "Memory copy operation failed",
-    "Memory move operation failed",
-    "Invalid string length",
-    "Empty string where not allowed",
-    "Null string in the strix structure provided",
-    "Invalid strix string position provided",
-    "Out of bounds element access",
-    "Invalid bounds given for slicing",
-    "Invalid double value in the strix string",
-    "Invalid int value in the strix string",
-    "Integer in the strix string overflows 8 bytes",
-    "Invalid stride given",
-    "Error from the stdio library while doing operations on the given file\nSee thread local errno for more information on the error"};
+extern _Thread_local strix_error_t strix_errno;
 
 /**
  * @brief Prints a formatted error message to stderr
@@ -0,0 +1,137 @@
+#ifndef C83B3A46_0E89_44EA_9738_ACAD2272700B
+#define C83B3A46_0E89_44EA_9738_ACAD2272700B
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "strix.h"
+
+/**
+ * @brief Non-cryptographic hashing of strings, for hash tables, deduplication and checksums
+ *
+ * The hashes are XXH3 as specified by xxHash 0.8: strix_hash64 and strix_hash128 return the same
+ * values as XXH3_64bits_withSeed and XXH3_128bits_withSeed, on every machine and instruction set.
+ * The inner loop over inputs longer than 240 bytes is one of the kernels bound by strix_cpu.h.
+ *
+ * Data that is not one contiguous strix_t, such as a string made of several pieces, is hashed with
+ * a strix_hash_state_t. Feeding it the pieces in order gives the hash of their concatenation.
+ *
+ * Example usage:
+ * @code
+ * strix_hash_state_t state;
+ * strix_hash_init(&state, 0);
+ * strix_hash_update(&state, "key=", 4);
+ * strix_hash_update_strix(&state, value);
+ * uint64_t hash = strix_hash_digest64(&state); // equal to strix_hash64_bytes("key=<value>", ...)
+ * @endcode
+ */
+typedef struct
+{
+    uint64_t low;
+    uint64_t high;
+} strix_hash128_t;
+
+#define STRIX_HASH_SECRET_SIZE (192)
+#define STRIX_HASH_BUFFER_SIZE (256)
+
+/**
+ * @brief State of a hash that is fed in pieces
+ *
+ * Its fields are internal. It holds no pointers, so copying it forks the hash.
+ */
+typedef struct
+{
+    uint64_t acc[8];
+    uint8_t secret[STRIX_HASH_SECRET_SIZE]; // derived from the seed
+    uint8_t buffer[STRIX_HASH_BUFFER_SIZE]; // input not hashed yet, the last 64 bytes hashed are kept after it
+    size_t buffered;
+    size_t stripes; // 64 byte stripes hashed since the last scramble
+    uint64_t total_len;
+    uint64_t seed;
+} strix_hash_state_t;
+
+/**
+ * @brief Hashes the bytes of a strix string into 64 bits
+ *
+ * @param strix Strix string to hash
+ * @param seed Changes every hash, 0 for the plain XXH3 values
+ * @return uint64_t Hash of strix, or 0 if strix is NULL (strix_errno is set)
+ */
+uint64_t strix_hash64(const strix_t *strix, uint64_t seed);
+
+/**
+ * @brief Hashes the bytes of a strix string into 128 bits
+ *
+ * @param strix Strix string to hash
+ * @param seed Changes every hash, 0 for the plain XXH3 values
+ * @return strix_hash128_t Hash of strix, or zero if strix is NULL (strix_errno is set)
+ */
+strix_hash128_t strix_hash128(const strix_t *strix, uint64_t seed);
+
+/**
+ * @brief Hashes a byte range into 64 bits, e.g. part of a strix string
+ *
+ * @param data Bytes to hash (may be NULL if len is 0)
+ * @param len Number of bytes
+ * @param seed Changes every hash
+ * @return uint64_t Hash of the bytes, or 0 if data is NULL and len is not (strix_errno is set)
+ */
+uint64_t strix_hash64_bytes(const void *data, size_t len, uint64_t seed);
+
+/**
+ * @brief Hashes a byte range into 128 bits
+ *
+ * @param data Bytes to hash (may be NULL if len is 0)
+ * @param len Number of bytes
+ * @param seed Changes every hash
+ * @return strix_hash128_t Hash of the bytes, or zero if data is NULL and len is not (strix_errno is set)
+ */
+strix_hash128_t strix_hash128_bytes(const void *data, size_t len, uint64_t seed);
+
+/**
+ * @brief Starts a hash that is fed in pieces
+ *
+ * @param state State to initialize
+ * @param seed Seed, as for strix_hash64
+ * @return bool true on success, false if state is NULL (strix_errno is set)
+ */
+bool strix_hash_init(strix_hash_state_t *state, uint64_t seed);
+
+/**
+ * @brief Feeds the next bytes to a hash
+ *
+ * @param state State from strix_hash_init
+ * @param data Bytes to add (may be NULL if len is 0)
+ * @param len Number of bytes
+ * @return bool true on success, false if state is NULL or data is NULL and len is not (strix_errno is set)
+ */
+bool strix_hash_update(strix_hash_state_t *state, const void *data, size_t len);
+
+/**
+ * @brief Feeds the bytes of a strix string to a hash
+ *
+ * @param state State from strix_hash_init
+ * @param strix Strix string to add
+ * @return bool true on success, false if an argument is NULL (strix_errno is set)
+ */
+bool strix_hash_update_strix(strix_hash_state_t *state, const strix_t *strix);
+
+/**
+ * @brief Returns the 64 bit hash of everything fed so far
+ *
+ * The state is left unchanged and can be fed more.
+ *
+ * @param state State from strix_hash_init
+ * @return uint64_t Same value strix_hash64_bytes gives for the concatenated bytes, 0 if state is NULL
+ */
+uint64_t strix_hash_digest64(const strix_hash_state_t *state);
+
+/**
+ * @brief Returns the 128 bit hash of everything fed so far
+ *
+ * @param state State from strix_hash_init
+ * @return strix_hash128_t Same value strix_hash128_bytes gives for the concatenated bytes, zero if state is NULL
+ */
+strix_hash128_t strix_hash_digest128(const strix_hash_state_t *state);
+
+#endif /* C83B3A46_0E89_44EA_9738_ACAD2272700B */
@@ -0,0 +1,126 @@
+#ifndef AB591D0D_E405_4B6C_A4C0_6A73C419E8C1
+#define AB591D0D_E405_4B6C_A4C0_6A73C419E8C1
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "strix.h"
+
+/**
+ * @brief Pool of canonical strings, one per distinct content
+ *
+ * Interning a string returns the copy the pool holds of its content, creating it the first time.
+ * Strings interned into the same pool are equal exactly when their pointers are, so repeated field
+ * names and values cost one copy each and compare in O(1).
+ *
+ * Canonical strings are immutable and owned by the pool: they are stored in an arena of the pool
+ * and live until strix_intern_pool_destroy. They must not be changed or passed to strix_free.
+ *
+ * A pool can be shared between threads. Finding a string that is already interned takes no lock;
+ * only adding a new one does.
+ *
+ * Example usage:
+ * @code
+ * strix_intern_pool_t *pool = strix_intern_pool_create();
+ * strix_arr_t *fields = strix_split_by_delim(line, ',');
+ * const strix_t *level = strix_intern(pool, fields->strix_arr[0]);
+ * if (level == strix_intern_cstr(pool, "ERROR")) // pointer comparison
+ *     errors++;
+ * strix_free_strix_arr(fields); // level stays valid
+ * @endcode
+ */
+typedef struct strix_intern_pool strix_intern_pool_t;
+
+/**
+ * @brief Creates an empty pool
+ *
+ * The pool takes its memory from the allocator of the calling thread (see strix_allocator.h),
+ * whichever thread adds strings to it or destroys it later.
+ *
+ * @return strix_intern_pool_t* New pool, or NULL if memory allocation fails
+ */
+strix_intern_pool_t *strix_intern_pool_create(void);
+
+/**
+ * @brief Frees the pool and every canonical string in it
+ *
+ * No thread may use the pool or its strings any more.
+ *
+ * @param pool Pool to destroy (may be NULL)
+ */
+void strix_intern_pool_destroy(strix_intern_pool_t *pool);
+
+/**
+ * @brief Returns the number of distinct strings in the pool
+ *
+ * @param pool Pool to query
+ * @return size_t Number of canonical strings, 0 if pool is NULL
+ */
+size_t strix_intern_pool_size(const strix_intern_pool_t *pool);
+
+/**
+ * @brief Returns the canonical string with the content of strix, adding it if it is new
+ *
+ * @param pool Pool to intern into
+ * @param strix String to intern, it is copied and not kept
+ * @return const strix_t* Canonical string, or NULL on failure
+ *
+ * Edge cases:
+ * - Returns NULL if pool or strix is NULL
+ * - Returns NULL if memory allocation fails
+ */
+const strix_t *strix_intern(strix_intern_pool_t *pool, const strix_t *strix);
+
+/**
+ * @brief Same as strix_intern for a byte range
+ *
+ * @param pool Pool to intern into
+ * @param str Bytes to intern (may be NULL if len is 0)
+ * @param len Number of bytes
+ * @return const strix_t* Canonical string, or NULL on failure
+ */
+const strix_t *strix_intern_bytes(strix_intern_pool_t *pool, const char *str, size_t len);
+
+/**
+ * @brief Same as strix_intern for a null-terminated string
+ *
+ * @param pool Pool to intern into
+ * @param str String to intern
+ * @return const strix_t* Canonical string, or NULL on failure
+ */
+const strix_t *strix_intern_cstr(strix_intern_pool_t *pool, const char *str);
+
+/**
+ * @brief Returns the canonical string with the content of strix without adding it
+ *
+ * Never takes the lock of the pool.
+ *
+ * @param pool Pool to search
+ * @param strix Content to look for
+ * @return const strix_t* Canonical string, or NULL if the content was never interned or an argument is NULL
+ */
+const strix_t *strix_intern_find(const strix_intern_pool_t *pool, const strix_t *strix);
+
+/**
+ * @brief Replaces every string of an array by its canonical string
+ *
+ * The array no longer owns its strings afterwards: release it with strix_free_interned_arr, which
+ * frees only the array, not with strix_free_strix_arr.
+ *
+ * @param pool Pool to intern into
+ * @param strix_arr Array whose strings are interned and freed
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if pool or strix_arr is NULL
+ * - Returns false if memory allocation fails, the array is left as it was
+ */
+bool strix_intern_arr(strix_intern_pool_t *pool, strix_arr_t *strix_arr);
+
+/**
+ * @brief Frees an array filled by strix_intern_arr, leaving its canonical strings in the pool
+ *
+ * @param strix_arr Array to free (may be NULL)
+ */
+void strix_free_interned_arr(strix_arr_t *strix_arr);
+
+#endif /* AB591D0D_E405_4B6C_A4C0_6A73C419E8C1 */
@@ -0,0 +1,193 @@
+#ifndef C6984324_CF21_42FD_8D41_0AF4F49FB435
+#define C6984324_CF21_42FD_8D41_0AF4F49FB435
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "strix.h"
+#include "strix_arena.h"
+
+/**
+ * @brief Hash map from strings to 64 bit values
+ *
+ * An open addressing table in the style of Swiss tables: every slot has a control byte holding 7
+ * bits of the hash of its key, and lookups compare the control bytes of 16 slots at once. The full
+ * hash is stored next to each key, so keys are only compared when their hashes are equal and
+ * growing the table never hashes a key again.
+ *
+ * The map does not copy keys unless told to. Without a key arena it keeps pointers to the bytes of
+ * the inserted strings, which must stay alive and unchanged while they are in the map. With a key
+ * arena the bytes are copied into it on first insertion and live until the arena is reset.
+ *
+ * Values are plain integers: counts, indices, or pointers cast to uintptr_t. Iteration order is
+ * unspecified and changes when the table grows.
+ *
+ * Example usage:
+ * @code
+ * strix_arr_t *words = strix_split_by_delim(text, ' ');
+ * strix_map_t *counts = strix_map_from_arr(words, NULL); // borrows the keys from words
+ * size_t cursor = 0;
+ * strix_t word;
+ * uint64_t count;
+ * while (strix_map_next(counts, &cursor, &word, &count))
+ *     printf(STRIX_FORMAT " %lu\n", STRIX_PRINT(&word), count);
+ * strix_map_destroy(counts);
+ * strix_free_strix_arr(words);
+ * @endcode
+ */
+typedef struct strix_map strix_map_t;
+
+/**
+ * @brief Creates an empty map
+ *
+ * @param capacity Number of keys the map takes before it first grows, may be 0
+ * @param key_arena Arena receiving copies of the keys, or NULL to borrow the bytes of the inserted strings
+ * @return strix_map_t* New map, or NULL if memory allocation fails
+ */
+strix_map_t *strix_map_create(size_t capacity, strix_arena_t *key_arena);
+
+/**
+ * @brief Frees the map and its table
+ *
+ * Borrowed keys and the key arena are left alone.
+ *
+ * @param map Map to destroy (may be NULL)
+ */
+void strix_map_destroy(strix_map_t *map);
+
+/**
+ * @brief Removes every key, keeping the table allocated
+ *
+ * @param map Map to clear (may be NULL)
+ */
+void strix_map_clear(strix_map_t *map);
+
+/**
+ * @brief Returns the number of keys in the map
+ *
+ * @param map Map to query
+ * @return size_t Number of keys, 0 if map is NULL
+ */
+size_t strix_map_size(const strix_map_t *map);
+
+/**
+ * @brief Grows the table so count keys fit without growing again
+ *
+ * @param map Map to grow
+ * @param count Number of keys to make room for
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if map is NULL
+ * - Returns false if memory allocation fails, the map is left as it was
+ */
+bool strix_map_reserve(strix_map_t *map, size_t count);
+
+/**
+ * @brief Finds a key, inserting it with the value 0 if it is missing
+ *
+ * The returned pointer is valid until the next insertion or removal.
+ *
+ * @param map Map to insert into
+ * @param key Key to look up or insert
+ * @param inserted Set to whether the key was inserted (may be NULL)
+ * @return uint64_t* Value of the key, or NULL on failure
+ *
+ * Edge cases:
+ * - Returns NULL if map or key is NULL
+ * - Returns NULL if memory allocation fails
+ */
+uint64_t *strix_map_upsert(strix_map_t *map, const strix_t *key, bool *inserted);
+
+/**
+ * @brief Same as strix_map_upsert with a key given as a byte range
+ *
+ * @param map Map to insert into
+ * @param key Bytes of the key (may be NULL if len is 0)
+ * @param len Length of the key
+ * @param inserted Set to whether the key was inserted (may be NULL)
+ * @return uint64_t* Value of the key, or NULL on failure
+ */
+uint64_t *strix_map_upsert_bytes(strix_map_t *map, const char *key, size_t len, bool *inserted);
+
+/**
+ * @brief Sets the value of a key, inserting the key if it is missing
+ *
+ * @param map Map to insert into
+ * @param key Key to set
+ * @param value New value
+ * @return bool true on success, false on failure (see strix_map_upsert)
+ */
+bool strix_map_put(strix_map_t *map, const strix_t *key, uint64_t value);
+
+/**
+ * @brief Finds the value of a key
+ *
+ * The returned pointer is valid until the next insertion or removal.
+ *
+ * @param map Map to search
+ * @param key Key to look up
+ * @return uint64_t* Value of the key, or NULL if the key is missing or an argument is NULL
+ */
+uint64_t *strix_map_find(const strix_map_t *map, const strix_t *key);
+
+/**
+ * @brief Same as strix_map_find with a key given as a byte range
+ *
+ * @param map Map to search
+ * @param key Bytes of the key (may be NULL if len is 0)
+ * @param len Length of the key
+ * @return uint64_t* Value of the key, or NULL if the key is missing or an argument is NULL
+ */
+uint64_t *strix_map_find_bytes(const strix_map_t *map, const char *key, size_t len);
+
+/**
+ * @brief Removes a key
+ *
+ * @param map Map to remove from
+ * @param key Key to remove
+ * @return bool true if the key was in the map, false if it was not or an argument is NULL
+ */
+bool strix_map_remove(strix_map_t *map, const strix_t *key);
+
+/**
+ * @brief Steps through the keys and values of the map
+ *
+ * Start with *cursor set to 0. The key points at the stored bytes and must not be freed or changed.
+ * Removing the key just returned is allowed, an insertion may grow the table and make the walk skip
+ * or repeat keys.
+ *
+ * @param map Map to walk
+ * @param cursor Position of the walk, advanced by each call
+ * @param key Set to the next key (may be NULL)
+ * @param value Set to its value (may be NULL)
+ * @return bool true if a key was returned, false once all keys have been seen or if map or cursor is NULL
+ */
+bool strix_map_next(const strix_map_t *map, size_t *cursor, strix_t *key, uint64_t *value);
+
+/**
+ * @brief Adds 1 to the value of every string of an array, inserting the missing ones
+ *
+ * Counting the tokens of strix_split_by_delim is one call. Without a key arena the map borrows the
+ * strings of the array, which must outlive their use in the map.
+ *
+ * @param map Map to count into
+ * @param strix_arr Strings to count
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if map or strix_arr is NULL
+ * - Returns false if memory allocation fails, the strings before the failing one are counted
+ */
+bool strix_map_add_arr(strix_map_t *map, const strix_arr_t *strix_arr);
+
+/**
+ * @brief Builds a map holding the number of occurrences of every string of an array
+ *
+ * @param strix_arr Strings to count
+ * @param key_arena Arena receiving copies of the keys, or NULL to borrow the strings of the array
+ * @return strix_map_t* New map, or NULL on failure (see strix_map_add_arr)
+ */
+strix_map_t *strix_map_from_arr(const strix_arr_t *strix_arr, strix_arena_t *key_arena);
+
+#endif /* C6984324_CF21_42FD_8D41_0AF4F49FB435 */
@@ -0,0 +1,181 @@
+#ifndef B3AF2C8E_0795_4FD3_8F42_E65D509BD283
+#define B3AF2C8E_0795_4FD3_8F42_E65D509BD283
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "strix.h"
+
+/**
+ * @brief Thread pool and parallel loops over string arrays
+ *
+ * The strix_arr_parallel_* functions split an array into chunks and run a callback on every element
+ * on the threads of a pool and the calling thread. Chunk sizes follow the lengths of the strings:
+ * a chunk holds about 64 KiB of string data, so arrays of short strings get long chunks and arrays
+ * of long strings short ones, and there are always several chunks per thread. Every thread starts
+ * on its own share of the chunks and steals half of the remaining share of another thread once its
+ * own runs out, which keeps all of them busy when some elements cost much more than others. Arrays
+ * too small to be worth waking the pool are processed on the calling thread.
+ *
+ * Callbacks run concurrently on several threads and must be safe to do so. On every thread, the
+ * calling one included, they allocate with the allocator of the caller (see strix_allocator.h) and
+ * outside its arena scope (see strix_arena.h), so strings of the array that live in an arena must
+ * not be grown or freed by them. Their strix_errno is not the caller's, so a failure has to be
+ * reported through the return value or the arg they are given.
+ *
+ * A pool runs one call at a time; concurrent calls wait for each other. A callback that calls the
+ * parallel functions again runs the inner call on its own thread, whichever pool it names, so pools
+ * never wait on each other.
+ *
+ * Example usage:
+ * @code
+ * static bool trim(strix_t *strix, size_t index, void *arg)
+ * {
+ *     return strix_trim_whitespace(strix);
+ * }
+ *
+ * strix_arr_t *lines = strix_split_by_delim(text, '\n');
+ * strix_arr_parallel_map(NULL, lines, trim, NULL); // NULL: the default pool
+ * @endcode
+ */
+typedef struct strix_thread_pool strix_thread_pool_t;
+
+/**
+ * @brief Called on every element by strix_arr_parallel_map
+ *
+ * @param strix Element, may be changed in place
+ * @param index Position of the element in the array
+ * @param arg The arg given to strix_arr_parallel_map
+ * @return bool true to go on, false to report a failure
+ */
+typedef bool (*strix_parallel_map_fn)(strix_t *strix, size_t index, void *arg);
+
+/**
+ * @brief Called on every element by strix_arr_parallel_filter and strix_arr_parallel_count
+ *
+ * @param strix Element
+ * @param arg The arg given to the parallel function
+ * @return bool Whether the element is kept or counted
+ */
+typedef bool (*strix_parallel_predicate_fn)(const strix_t *strix, void *arg);
+
+/**
+ * @brief Called on every element by strix_arr_parallel_reduce
+ *
+ * @param strix Element
+ * @param index Position of the element in the array
+ * @param arg The arg given to strix_arr_parallel_reduce
+ * @return uint64_t Value of the element
+ */
+typedef uint64_t (*strix_parallel_value_fn)(const strix_t *strix, size_t index, void *arg);
+
+/**
+ * @brief Combines two values in strix_arr_parallel_reduce
+ *
+ * @param left Value of elements before those of right
+ * @param right Value of elements after those of left
+ * @param arg The arg given to strix_arr_parallel_reduce
+ * @return uint64_t Combined value
+ */
+typedef uint64_t (*strix_parallel_combine_fn)(uint64_t left, uint64_t right, void *arg);
+
+/**
+ * @brief Starts a pool of worker threads
+ *
+ * The thread calling a parallel function works as well, so a pool of n threads runs a call on
+ * n + 1 of them.
+ *
+ * @param threads Number of worker threads, 0 for one per online CPU minus the caller
+ * @return strix_thread_pool_t* New pool, or NULL if memory allocation or thread creation fails
+ */
+strix_thread_pool_t *strix_thread_pool_create(size_t threads);
+
+/**
+ * @brief Stops the workers of a pool and frees it
+ *
+ * No call may be running on the pool. The default pool cannot be destroyed.
+ *
+ * @param pool Pool to destroy (may be NULL)
+ */
+void strix_thread_pool_destroy(strix_thread_pool_t *pool);
+
+/**
+ * @brief Returns the number of worker threads of a pool
+ *
+ * @param pool Pool to query, NULL for the default pool
+ * @return size_t Number of workers, 0 if the default pool could not be started
+ */
+size_t strix_thread_pool_threads(const strix_thread_pool_t *pool);
+
+/**
+ * @brief Calls fn on every element of an array, in parallel
+ *
+ * Elements are visited in no particular order, each once. After a call of fn returns false the
+ * elements not started yet are skipped.
+ *
+ * @param pool Pool to run on, NULL for the default pool (one worker per online CPU minus the caller)
+ * @param strix_arr Array whose elements are passed to fn
+ * @param fn Callback
+ * @param arg Passed to every call of fn
+ * @return bool true if every call of fn returned true, false otherwise
+ *
+ * Edge cases:
+ * - Returns false if strix_arr or fn is NULL
+ * - Elements are passed as they are, NULL included
+ */
+bool strix_arr_parallel_map(strix_thread_pool_t *pool, strix_arr_t *strix_arr, strix_parallel_map_fn fn, void *arg);
+
+/**
+ * @brief Keeps the elements of an array that keep accepts, in their order, and frees the others
+ *
+ * keep runs in parallel; removing and freeing the rejected strings is done on the calling thread.
+ *
+ * @param pool Pool to run on, NULL for the default pool
+ * @param strix_arr Array to filter
+ * @param keep Predicate
+ * @param arg Passed to every call of keep
+ * @return size_t New length of the array, 0 on failure (strix_errno is set)
+ *
+ * Edge cases:
+ * - Returns 0 if strix_arr or keep is NULL
+ * - Returns 0 if memory allocation fails, the array is left as it was
+ */
+size_t strix_arr_parallel_filter(strix_thread_pool_t *pool, strix_arr_t *strix_arr, strix_parallel_predicate_fn keep, void *arg);
+
+/**
+ * @brief Combines the values of all elements of an array, in parallel
+ *
+ * Every chunk folds the values of its elements in order, starting from identity, and the results of
+ * the chunks are folded in order. The result is the one of a sequential fold whenever combine is
+ * associative and identity is neutral for it, such as a sum, a maximum or an exclusive or.
+ *
+ * @param pool Pool to run on, NULL for the default pool
+ * @param strix_arr Array to reduce
+ * @param value Value of one element
+ * @param combine Combines two values
+ * @param identity Value of an empty range
+ * @param arg Passed to every call of value and combine
+ * @return uint64_t Combined value, identity for an empty array or on failure (strix_errno is set)
+ *
+ * Edge cases:
+ * - Returns identity if strix_arr, value or combine is NULL
+ */
+uint64_t strix_arr_parallel_reduce(strix_thread_pool_t *pool, const strix_arr_t *strix_arr, strix_parallel_value_fn value,
+                                   strix_parallel_combine_fn combine, uint64_t identity, void *arg);
+
+/**
+ * @brief Counts the elements of an array that predicate accepts, in parallel
+ *
+ * @param pool Pool to run on, NULL for the default pool
+ * @param strix_arr Array to search
+ * @param predicate Predicate
+ * @param arg Passed to every call of predicate
+ * @return size_t Number of accepted elements, 0 on failure (strix_errno is set)
+ *
+ * Edge cases:
+ * - Returns 0 if strix_arr or predicate is NULL
+ */
+size_t strix_arr_parallel_count(strix_thread_pool_t *pool, const strix_arr_t *strix_arr, strix_parallel_predicate_fn predicate,
+                                void *arg);
+
+#endif /* B3AF2C8E_0795_4FD3_8F42_E65D509BD283 */
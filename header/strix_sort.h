@@ -0,0 +1,67 @@
+#ifndef B75B315E_E784_4BD9_997D_3C35AED41D01
+#define B75B315E_E784_4BD9_997D_3C35AED41D01
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "strix.h"
+
+/**
+ * @brief Sorting and deduplication of string arrays
+ *
+ * The order is the one of strix_compare: bytes compared as unsigned, a prefix before the longer
+ * string. The next 7 bytes of every string are kept next to its pointer, so the sort reads a small
+ * contiguous array instead of following a pointer per string and byte. Large arrays are split by
+ * one byte at a time (MSD radix sort), small ranges finished by a multikey quicksort; strings
+ * sharing a long prefix are handled 7 bytes per step. It needs a buffer of 48 bytes per string.
+ *
+ * Example usage:
+ * @code
+ * strix_arr_t *words = strix_split_by_delim(text, ' ');
+ * strix_arr_sort(words, STRIX_SORT_UNSTABLE);
+ * strix_arr_unique(words); // one copy of every word, in order
+ * @endcode
+ */
+typedef enum
+{
+    STRIX_SORT_UNSTABLE, // equal strings end up in any order
+    STRIX_SORT_STABLE,   // equal strings keep the order they had
+} strix_sort_mode_t;
+
+/**
+ * @brief Sorts the strings of an array in place
+ *
+ * @param strix_arr Array to sort
+ * @param mode STRIX_SORT_STABLE or STRIX_SORT_UNSTABLE
+ * @return bool true on success, false on failure
+ *
+ * Edge cases:
+ * - Returns false if strix_arr or one of its strings is NULL, the array is left as it was
+ * - Returns false if memory allocation fails, the array is left as it was
+ */
+bool strix_arr_sort(strix_arr_t *strix_arr, strix_sort_mode_t mode);
+
+/**
+ * @brief Sorts the strings of an array in place on several threads
+ *
+ * Gives the same result as strix_arr_sort. Arrays too small to be worth splitting are sorted on the
+ * calling thread.
+ *
+ * @param strix_arr Array to sort
+ * @param mode STRIX_SORT_STABLE or STRIX_SORT_UNSTABLE
+ * @param threads Number of threads to use including the calling one, 0 for one per online CPU
+ * @return bool true on success, false on failure (see strix_arr_sort)
+ */
+bool strix_arr_sort_parallel(strix_arr_t *strix_arr, strix_sort_mode_t mode, size_t threads);
+
+/**
+ * @brief Removes adjacent duplicates from an array, keeping the first string of every run
+ *
+ * Run on a sorted array this leaves every distinct string once. The removed strings are freed,
+ * except those that are the same object as the string kept, as in arrays from strix_intern_arr.
+ *
+ * @param strix_arr Array to deduplicate
+ * @return size_t New length of the array, 0 if strix_arr or one of its strings is NULL (strix_errno is set)
+ */
+size_t strix_arr_unique(strix_arr_t *strix_arr);
+
+#endif /* B75B315E_E784_4BD9_997D_3C35AED41D01 */
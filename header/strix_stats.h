@@ -0,0 +1,173 @@
+#ifndef A3D95E61_0F2C_4B87_9E14_C6B7280D5F93
+#define A3D95E61_0F2C_4B87_9E14_C6B7280D5F93
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Public functions of strix.h, string_search.h and strix_hash.h that are instrumented
+ *
+ * Only calls made from outside the library are recorded. A strix function that calls another one
+ * counts once, with the time of the inner call included.
+ */
+typedef enum
+{
+    STRIX_OP_CREATE_EMPTY,
+    STRIX_OP_TO_CSTR,
+    STRIX_OP_CREATE,
+    STRIX_OP_DUPLICATE,
+    STRIX_OP_MODIFY,
+    STRIX_OP_FREE,
+    STRIX_OP_CLEAR,
+    STRIX_OP_CONCAT,
+    STRIX_OP_APPEND,
+    STRIX_OP_INSERT_STR,
+    STRIX_OP_INSERT,
+    STRIX_OP_ERASE,
+    STRIX_OP_AT,
+    STRIX_OP_EQUAL,
+    STRIX_OP_COMPARE,
+    STRIX_OP_EQUAL_FAST,
+    STRIX_OP_FIND,
+    STRIX_OP_FIND_ALL,
+    STRIX_OP_FIND_SUBTRIX,
+    STRIX_OP_FIND_SUBTRIX_ALL,
+    STRIX_OP_POSITION_FREE,
+    STRIX_OP_FREE_STRIX_ARR,
+    STRIX_OP_SLICE,
+    STRIX_OP_SPLIT_BY_DELIM,
+    STRIX_OP_SPLIT_BY_SUBSTR,
+    STRIX_OP_SPLIT_BY_SUBSTRIX,
+    STRIX_OP_JOIN_VIA_DELIM,
+    STRIX_OP_JOIN_VIA_SUBSTR,
+    STRIX_OP_JOIN_VIA_SUBSTRIX,
+    STRIX_OP_TRIM_WHITESPACE,
+    STRIX_OP_TRIM_CHAR,
+    STRIX_OP_TO_DOUBLE,
+    STRIX_OP_TO_UNSIGNED_INT,
+    STRIX_OP_TO_SIGNED_INT,
+    STRIX_OP_COUNT_CHAR,
+    STRIX_OP_COUNT_SUBSTR,
+    STRIX_OP_COUNT_SUBSTRIX,
+    STRIX_OP_SLICE_BY_STRIDE,
+    STRIX_OP_FIND_UNIQUE_CHAR,
+    STRIX_OP_DELETE_OCCURENCE,
+    STRIX_OP_FREE_CHAR_ARR,
+    STRIX_OP_FIND_ALL_CHAR,
+    STRIX_OP_CONV_FILE_TO_STRIX,
+    STRIX_OP_FREE_POSITION,
+    STRIX_OP_KMP_SEARCH,
+    STRIX_OP_KMP_SEARCH_ALL,
+    STRIX_OP_KMP_SEARCH_ALL_LEN,
+    STRIX_OP_SUBSTR_SEARCH,
+    STRIX_OP_SUBSTR_SEARCH_ALL,
+    STRIX_OP_SUBSTR_SEARCH_ALL_LEN,
+    STRIX_OP_HASH64,
+    STRIX_OP_HASH128,
+    STRIX_OP_MAP_UPSERT,
+    STRIX_OP_MAP_FIND,
+    STRIX_OP_MAP_REMOVE,
+    STRIX_OP_MAP_ADD_ARR,
+    STRIX_OP_INTERN,
+    STRIX_OP_INTERN_FIND,
+    STRIX_OP_ARR_SORT,
+    STRIX_OP_ARR_SORT_PARALLEL,
+    STRIX_OP_ARR_UNIQUE,
+    STRIX_OP_ARR_PARALLEL_MAP,
+    STRIX_OP_ARR_PARALLEL_FILTER,
+    STRIX_OP_ARR_PARALLEL_REDUCE,
+    STRIX_OP_ARR_PARALLEL_COUNT,
+    STRIX_OP_COUNT,
+} strix_op_t;
+
+#define STRIX_STATS_SUB_BUCKET_BITS (3) // 8 buckets per power of two, values within 12.5% share a bucket
+#define STRIX_STATS_MAX_EXPONENT (40)   // latencies from 2^40 ns (about 18 minutes) up share the last bucket
+#define STRIX_STATS_BUCKETS ((STRIX_STATS_MAX_EXPONENT - STRIX_STATS_SUB_BUCKET_BITS + 2) << STRIX_STATS_SUB_BUCKET_BITS)
+
+/**
+ * @brief Counters of one operation, summed over all threads
+ *
+ * calls and bytes count every call. Latencies are measured on one call in every sample rate
+ * calls of each thread (see strix_stats_set_sample_rate), so samples can be lower than calls.
+ */
+typedef struct
+{
+    uint64_t calls;
+    uint64_t bytes;      // bytes of the strings the calls took or produced
+    uint64_t samples;    // calls whose latency was measured
+    uint64_t sampled_ns; // total latency of those calls
+    uint64_t max_ns;
+    uint64_t histogram[STRIX_STATS_BUCKETS]; // log-linear latency buckets, see strix_stats_percentile
+} strix_op_stats_t;
+
+typedef struct
+{
+    strix_op_stats_t ops[STRIX_OP_COUNT];
+} strix_stats_t;
+
+/**
+ * @brief Tells whether the library was built with STRIX_STATS (make STATS=1)
+ *
+ * Without it, no call is instrumented and every snapshot is zero.
+ *
+ * @return bool true if the instrumentation is compiled in
+ */
+bool strix_stats_enabled(void);
+
+/**
+ * @brief Copies the counters of all threads, including those that have exited, since the last reset
+ *
+ * Threads keep running while their counters are read, so the copy is not an atomic cut.
+ * strix_stats_t takes about 120 KiB and is better not placed on the stack.
+ *
+ * @param stats Where to store the counters
+ */
+void strix_stats_snapshot(strix_stats_t *stats);
+
+/**
+ * @brief Starts all counters from zero again
+ */
+void strix_stats_reset(void);
+
+/**
+ * @brief Measures the latency of one call in every `every` calls of a thread, 1 measures all
+ *
+ * The default is STRIX_STATS_DEFAULT_SAMPLE_RATE or the STRIX_STATS_SAMPLE_RATE environment
+ * variable. Counting calls and bytes is cheap, reading the clock is what costs.
+ *
+ * @param every Calls per measured call, 0 is taken as 1
+ */
+void strix_stats_set_sample_rate(uint32_t every);
+
+#define STRIX_STATS_DEFAULT_SAMPLE_RATE (64)
+
+/**
+ * @brief Latency below which a share of the measured calls of an operation fell
+ *
+ * @param op Counters of the operation
+ * @param percentile Share in percent, 0 to 100
+ * @return uint64_t Upper bound of the bucket holding that percentile in ns, 0 without samples
+ */
+uint64_t strix_stats_percentile(const strix_op_stats_t *op, double percentile);
+
+/**
+ * @brief Returns the name of the function an operation stands for
+ *
+ * @param op Operation
+ * @return const char* e.g. "strix_find", "unknown" for anything else
+ */
+const char *strix_stats_op_name(strix_op_t op);
+
+/**
+ * @brief Writes a table of the operations that were called, one per line
+ *
+ * Columns: calls, bytes, mean, p50, p99, p99.9 and max latency. Setting the STRIX_STATS_DUMP
+ * environment variable writes the same table to stderr when the program exits.
+ *
+ * @param stream Where to write
+ */
+void strix_stats_dump(FILE *stream);
+
+#endif /* A3D95E61_0F2C_4B87_9E14_C6B7280D5F93 */
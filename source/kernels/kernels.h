@@ -0,0 +1,54 @@
+#ifndef E4815718_3A14_42A2_8471_B4A82829AF1D
+#define E4815718_3A14_42A2_8471_B4A82829AF1D
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../../header/strix_cpu.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STRIX_KERNELS_X86
+#endif
+
+/*
+ * The hot loops of strix, one table per instruction set. strix_kernels points at the scalar table
+ * until source/strix_cpu.c binds it to the best one the CPU supports, which happens before main.
+ * Whitespace is isspace in the C locale: ' ', '\t', '\n', '\v', '\f' and '\r'.
+ */
+typedef struct
+{
+    const char *(*find_byte)(const char *str, size_t len, char chr); // first chr, NULL if there is none
+    size_t (*count_byte)(const char *str, size_t len, char chr);
+    const char *(*find_substr)(const char *str, size_t len, const char *pattern, size_t pattern_len); // first match, NULL if there is none
+    size_t (*span_byte)(const char *str, size_t len, char chr);  // length of the run of chr at the start of str
+    size_t (*rspan_byte)(const char *str, size_t len, char chr); // length of the run of chr at the end of str
+    size_t (*span_space)(const char *str, size_t len);
+    size_t (*rspan_space)(const char *str, size_t len);
+    size_t (*mismatch)(const char *one, const char *two, size_t len); // index of the first differing byte, len if there is none
+    // XXH3 (source/strix_hash.c): folds 64 byte stripes into acc, the secret moves 8 bytes per stripe
+    void (*hash_stripes)(uint64_t acc[8], const uint8_t *input, const uint8_t *secret, size_t stripes);
+    void (*hash_scramble)(uint64_t acc[8], const uint8_t *secret);
+} strix_kernels_t;
+
+extern const strix_kernels_t *strix_kernels;
+
+/*
+ * Knuth-Morris-Pratt, linear in the length of the text plus the pattern whatever they hold. The
+ * vector find_substr kernels go on with it once their candidates keep failing late, and the
+ * searches for every match in string_search.c make one pass with it. strix_kmp_table fills lps with
+ * pattern_len entries. strix_kmp_next resumes a scan of str at *at with *matched bytes of the
+ * pattern matched before it and returns the position of the next match, len if there is none;
+ * where no byte is matched it skips to the next first byte of the pattern with find_byte.
+ */
+void strix_kmp_table(const char *pattern, size_t pattern_len, size_t *lps);
+size_t strix_kmp_next(const char *str, size_t len, const char *pattern, size_t pattern_len, const size_t *lps, size_t *at, size_t *matched);
+const char *strix_kmp_find(const char *str, size_t len, const char *pattern, size_t pattern_len); // first match, NULL if there is none
+
+extern const strix_kernels_t strix_kernels_scalar;
+#ifdef STRIX_KERNELS_X86
+extern const strix_kernels_t strix_kernels_sse42;
+extern const strix_kernels_t strix_kernels_avx2;
+extern const strix_kernels_t strix_kernels_avx512;
+#endif
+
+#endif /* E4815718_3A14_42A2_8471_B4A82829AF1D */
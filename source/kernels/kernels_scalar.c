@@ -0,0 +1,233 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "kernels.h"
+
+#define KERNEL_KMP_STACK_ENTRIES (256) // longer patterns get their table from the heap
+
+static inline bool scalar_is_space(unsigned char chr)
+{
+    return chr == ' ' || (unsigned char)(chr - '\t') <= '\r' - '\t';
+}
+
+static const char *scalar_find_byte(const char *str, size_t len, char chr)
+{
+    return (const char *)memchr(str, chr, len);
+}
+
+static size_t scalar_count_byte(const char *str, size_t len, char chr)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        count += str[i] == chr;
+    }
+    return count;
+}
+
+void strix_kmp_table(const char *pattern, size_t pattern_len, size_t *lps)
+{
+    lps[0] = 0;
+    for (size_t i = 1, j = 0; i < pattern_len;)
+    {
+        if (pattern[i] == pattern[j])
+        {
+            lps[i++] = ++j;
+        }
+        else if (j != 0)
+        {
+            j = lps[j - 1];
+        }
+        else
+        {
+            lps[i++] = 0;
+        }
+    }
+}
+
+size_t strix_kmp_next(const char *str, size_t len, const char *pattern, size_t pattern_len, const size_t *lps, size_t *at, size_t *matched)
+{
+    size_t i = *at, j = *matched;
+    while (i < len)
+    {
+        if (j == 0)
+        {
+            const char *next = strix_kernels->find_byte(str + i, len - i, pattern[0]);
+            if (!next)
+            {
+                i = len;
+                break;
+            }
+            i = (size_t)(next - str);
+        }
+
+        if (str[i] == pattern[j])
+        {
+            i++;
+            if (++j == pattern_len)
+            {
+                *at = i;
+                *matched = lps[j - 1];
+                return i - pattern_len;
+            }
+        }
+        else if (j != 0)
+        {
+            j = lps[j - 1];
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    *at = i;
+    *matched = j;
+    return len;
+}
+
+const char *strix_kmp_find(const char *str, size_t len, const char *pattern, size_t pattern_len)
+{
+    if (pattern_len == 0)
+    {
+        return str;
+    }
+    if (pattern_len > len)
+    {
+        return NULL;
+    }
+
+    size_t stack[KERNEL_KMP_STACK_ENTRIES];
+    size_t *lps = pattern_len <= KERNEL_KMP_STACK_ENTRIES ? stack : (size_t *)malloc(sizeof(size_t) * pattern_len);
+    if (!lps)
+    {
+        // no memory for the table, compare at every position instead
+        for (size_t i = 0; i + pattern_len <= len; i++)
+        {
+            if (memcmp(str + i, pattern, pattern_len) == 0)
+            {
+                return str + i;
+            }
+        }
+        return NULL;
+    }
+
+    strix_kmp_table(pattern, pattern_len, lps);
+    size_t at = 0, matched = 0;
+    size_t match = strix_kmp_next(str, len, pattern, pattern_len, lps, &at, &matched);
+    if (lps != stack)
+    {
+        free(lps);
+    }
+    return match < len ? str + match : NULL;
+}
+
+static const char *scalar_find_substr(const char *str, size_t len, const char *pattern, size_t pattern_len)
+{
+    return strix_kmp_find(str, len, pattern, pattern_len);
+}
+
+static size_t scalar_span_byte(const char *str, size_t len, char chr)
+{
+    size_t span = 0;
+    while (span < len && str[span] == chr)
+    {
+        span++;
+    }
+    return span;
+}
+
+static size_t scalar_rspan_byte(const char *str, size_t len, char chr)
+{
+    size_t span = 0;
+    while (span < len && str[len - span - 1] == chr)
+    {
+        span++;
+    }
+    return span;
+}
+
+static size_t scalar_span_space(const char *str, size_t len)
+{
+    size_t span = 0;
+    while (span < len && scalar_is_space((unsigned char)str[span]))
+    {
+        span++;
+    }
+    return span;
+}
+
+static size_t scalar_rspan_space(const char *str, size_t len)
+{
+    size_t span = 0;
+    while (span < len && scalar_is_space((unsigned char)str[len - span - 1]))
+    {
+        span++;
+    }
+    return span;
+}
+
+static inline uint64_t scalar_read64(const uint8_t *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+// whole words are compared first, only the word that differs is searched byte by byte
+static size_t scalar_mismatch(const char *one, const char *two, size_t len)
+{
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8)
+    {
+        if (scalar_read64((const uint8_t *)one + i) != scalar_read64((const uint8_t *)two + i))
+        {
+            break;
+        }
+    }
+
+    while (i < len && one[i] == two[i])
+    {
+        i++;
+    }
+    return i;
+}
+
+static void scalar_hash_stripes(uint64_t acc[8], const uint8_t *input, const uint8_t *secret, size_t stripes)
+{
+    for (size_t stripe = 0; stripe < stripes; stripe++, input += 64, secret += 8)
+    {
+        for (size_t lane = 0; lane < 8; lane++)
+        {
+            uint64_t data = scalar_read64(input + lane * 8);
+            uint64_t key = data ^ scalar_read64(secret + lane * 8);
+            acc[lane ^ 1] += data;
+            acc[lane] += (key & 0xFFFFFFFF) * (key >> 32);
+        }
+    }
+}
+
+static void scalar_hash_scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    for (size_t lane = 0; lane < 8; lane++)
+    {
+        uint64_t value = acc[lane] ^ (acc[lane] >> 47) ^ scalar_read64(secret + lane * 8);
+        acc[lane] = value * 0x9E3779B1u;
+    }
+}
+
+const strix_kernels_t strix_kernels_scalar = {
+    .find_byte = scalar_find_byte,
+    .count_byte = scalar_count_byte,
+    .find_substr = scalar_find_substr,
+    .span_byte = scalar_span_byte,
+    .rspan_byte = scalar_rspan_byte,
+    .span_space = scalar_span_space,
+    .rspan_space = scalar_rspan_space,
+    .mismatch = scalar_mismatch,
+    .hash_stripes = scalar_hash_stripes,
+    .hash_scramble = scalar_hash_scramble,
+};
+
+#undef KERNEL_KMP_STACK_ENTRIES
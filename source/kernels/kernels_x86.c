@@ -0,0 +1,203 @@
+#include "kernels.h"
+
+#ifdef STRIX_KERNELS_X86
+
+#include <string.h>
+#include <immintrin.h>
+
+// whitespace is ' ' or a byte in '\t'..'\r', the range test is min(b - '\t', 4) == b - '\t'
+
+/* SSE4.2 */
+
+#define KERNEL_ISA sse42
+#define KERNEL_TARGET __attribute__((target("sse4.2,popcnt")))
+#define KERNEL_WIDTH 16
+
+KERNEL_TARGET static inline uint64_t sse42_eq_mask(const char *ptr, char chr)
+{
+    __m128i bytes = _mm_loadu_si128((const __m128i *)ptr);
+    return (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(chr)));
+}
+
+KERNEL_TARGET static inline uint64_t sse42_space_mask(const char *ptr)
+{
+    __m128i bytes = _mm_loadu_si128((const __m128i *)ptr);
+    __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+    __m128i space = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    return (uint16_t)_mm_movemask_epi8(_mm_or_si128(control, space));
+}
+
+KERNEL_TARGET static inline uint64_t sse42_diff_mask(const char *one, const char *two)
+{
+    __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)one), _mm_loadu_si128((const __m128i *)two));
+    return (uint16_t)~_mm_movemask_epi8(equal);
+}
+
+// XXH3 on four 2-lane vectors: acc[lane ^ 1] += data, acc[lane] += lo32(key) * hi32(key)
+KERNEL_TARGET static void sse42_hash_stripes(uint64_t acc[8], const uint8_t *input, const uint8_t *secret, size_t stripes)
+{
+    __m128i lanes[4];
+    for (size_t i = 0; i < 4; i++)
+    {
+        lanes[i] = _mm_loadu_si128((const __m128i *)acc + i);
+    }
+
+    for (; stripes; stripes--, input += 64, secret += 8)
+    {
+        for (size_t i = 0; i < 4; i++)
+        {
+            __m128i data = _mm_loadu_si128((const __m128i *)input + i);
+            __m128i key = _mm_xor_si128(data, _mm_loadu_si128((const __m128i *)secret + i));
+            __m128i product = _mm_mul_epu32(key, _mm_srli_epi64(key, 32));
+            lanes[i] = _mm_add_epi64(lanes[i], _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        _mm_storeu_si128((__m128i *)acc + i, lanes[i]);
+    }
+}
+
+KERNEL_TARGET static void sse42_hash_scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    const __m128i prime = _mm_set1_epi32((int)0x9E3779B1u);
+    for (size_t i = 0; i < 4; i++)
+    {
+        __m128i lane = _mm_loadu_si128((const __m128i *)acc + i);
+        lane = _mm_xor_si128(_mm_xor_si128(lane, _mm_srli_epi64(lane, 47)), _mm_loadu_si128((const __m128i *)secret + i));
+        __m128i high = _mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(lane, 32), prime), 32);
+        _mm_storeu_si128((__m128i *)acc + i, _mm_add_epi64(_mm_mul_epu32(lane, prime), high));
+    }
+}
+
+#include "kernels_x86.h"
+
+#undef KERNEL_ISA
+#undef KERNEL_TARGET
+#undef KERNEL_WIDTH
+
+/* AVX2 */
+
+#define KERNEL_ISA avx2
+#define KERNEL_TARGET __attribute__((target("avx2,popcnt")))
+#define KERNEL_WIDTH 32
+
+KERNEL_TARGET static inline uint64_t avx2_eq_mask(const char *ptr, char chr)
+{
+    __m256i bytes = _mm256_loadu_si256((const __m256i *)ptr);
+    return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(chr)));
+}
+
+KERNEL_TARGET static inline uint64_t avx2_space_mask(const char *ptr)
+{
+    __m256i bytes = _mm256_loadu_si256((const __m256i *)ptr);
+    __m256i offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t'));
+    __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+    __m256i space = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(control, space));
+}
+
+KERNEL_TARGET static inline uint64_t avx2_diff_mask(const char *one, const char *two)
+{
+    __m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)one), _mm256_loadu_si256((const __m256i *)two));
+    return (uint32_t)~_mm256_movemask_epi8(equal);
+}
+
+KERNEL_TARGET static void avx2_hash_stripes(uint64_t acc[8], const uint8_t *input, const uint8_t *secret, size_t stripes)
+{
+    __m256i lanes[2];
+    for (size_t i = 0; i < 2; i++)
+    {
+        lanes[i] = _mm256_loadu_si256((const __m256i *)acc + i);
+    }
+
+    for (; stripes; stripes--, input += 64, secret += 8)
+    {
+        for (size_t i = 0; i < 2; i++)
+        {
+            __m256i data = _mm256_loadu_si256((const __m256i *)input + i);
+            __m256i key = _mm256_xor_si256(data, _mm256_loadu_si256((const __m256i *)secret + i));
+            __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+            lanes[i] = _mm256_add_epi64(lanes[i], _mm256_add_epi64(product, _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+    }
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        _mm256_storeu_si256((__m256i *)acc + i, lanes[i]);
+    }
+}
+
+KERNEL_TARGET static void avx2_hash_scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    const __m256i prime = _mm256_set1_epi32((int)0x9E3779B1u);
+    for (size_t i = 0; i < 2; i++)
+    {
+        __m256i lane = _mm256_loadu_si256((const __m256i *)acc + i);
+        lane = _mm256_xor_si256(_mm256_xor_si256(lane, _mm256_srli_epi64(lane, 47)), _mm256_loadu_si256((const __m256i *)secret + i));
+        __m256i high = _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(lane, 32), prime), 32);
+        _mm256_storeu_si256((__m256i *)acc + i, _mm256_add_epi64(_mm256_mul_epu32(lane, prime), high));
+    }
+}
+
+#include "kernels_x86.h"
+
+#undef KERNEL_ISA
+#undef KERNEL_TARGET
+#undef KERNEL_WIDTH
+
+/* AVX-512 */
+
+#define KERNEL_ISA avx512
+#define KERNEL_TARGET __attribute__((target("avx512f,avx512bw,popcnt")))
+#define KERNEL_WIDTH 64
+
+KERNEL_TARGET static inline uint64_t avx512_eq_mask(const char *ptr, char chr)
+{
+    __m512i bytes = _mm512_loadu_si512((const void *)ptr);
+    return _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8(chr));
+}
+
+KERNEL_TARGET static inline uint64_t avx512_space_mask(const char *ptr)
+{
+    __m512i bytes = _mm512_loadu_si512((const void *)ptr);
+    __mmask64 control = _mm512_cmple_epu8_mask(_mm512_sub_epi8(bytes, _mm512_set1_epi8('\t')), _mm512_set1_epi8('\r' - '\t'));
+    return control | _mm512_cmpeq_epi8_mask(bytes, _mm512_set1_epi8(' '));
+}
+
+KERNEL_TARGET static inline uint64_t avx512_diff_mask(const char *one, const char *two)
+{
+    return _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)one), _mm512_loadu_si512((const void *)two));
+}
+
+KERNEL_TARGET static void avx512_hash_stripes(uint64_t acc[8], const uint8_t *input, const uint8_t *secret, size_t stripes)
+{
+    __m512i lanes = _mm512_loadu_si512((const void *)acc);
+    for (; stripes; stripes--, input += 64, secret += 8)
+    {
+        __m512i data = _mm512_loadu_si512((const void *)input);
+        __m512i key = _mm512_xor_si512(data, _mm512_loadu_si512((const void *)secret));
+        __m512i product = _mm512_mul_epu32(key, _mm512_srli_epi64(key, 32));
+        lanes = _mm512_add_epi64(lanes, _mm512_add_epi64(product, _mm512_shuffle_epi32(data, (_MM_PERM_ENUM)_MM_SHUFFLE(1, 0, 3, 2))));
+    }
+    _mm512_storeu_si512((void *)acc, lanes);
+}
+
+KERNEL_TARGET static void avx512_hash_scramble(uint64_t acc[8], const uint8_t *secret)
+{
+    const __m512i prime = _mm512_set1_epi32((int)0x9E3779B1u);
+    __m512i lane = _mm512_loadu_si512((const void *)acc);
+    lane = _mm512_xor_si512(_mm512_xor_si512(lane, _mm512_srli_epi64(lane, 47)), _mm512_loadu_si512((const void *)secret));
+    __m512i high = _mm512_slli_epi64(_mm512_mul_epu32(_mm512_srli_epi64(lane, 32), prime), 32);
+    _mm512_storeu_si512((void *)acc, _mm512_add_epi64(_mm512_mul_epu32(lane, prime), high));
+}
+
+#include "kernels_x86.h"
+
+#undef KERNEL_ISA
+#undef KERNEL_TARGET
+#undef KERNEL_WIDTH
+
+#endif // STRIX_KERNELS_X86
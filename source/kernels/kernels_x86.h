@@ -0,0 +1,248 @@
+/*
+ * Kernels shared by every x86 instruction set, included once per set by kernels_x86.c with no
+ * include guard. Each inclusion defines:
+ *   KERNEL_ISA     prefix of the generated names, e.g. avx2 gives avx2_find_byte
+ *   KERNEL_TARGET  the target attribute of the set
+ *   KERNEL_WIDTH   bytes per vector, 16, 32 or 64
+ * helpers that read KERNEL_WIDTH bytes from unaligned pointers and return one bit per byte:
+ *   <isa>_eq_mask(ptr, chr)     bytes equal to chr
+ *   <isa>_space_mask(ptr)       whitespace bytes
+ *   <isa>_diff_mask(one, two)   bytes that differ between one and two
+ * and <isa>_hash_stripes and <isa>_hash_scramble, which work on whole vectors of lanes.
+ */
+
+#define KERNEL_CONCAT_(isa, name) isa##_##name
+#define KERNEL_CONCAT(isa, name) KERNEL_CONCAT_(isa, name)
+#define KERNEL_FN(name) KERNEL_CONCAT(KERNEL_ISA, name)
+#define KERNEL_FULL_MASK (~(uint64_t)0 >> (64 - KERNEL_WIDTH))
+#define KERNEL_VERIFY_SLACK (4096) // bytes find_substr may compare at failed candidates beyond the text it scanned
+
+KERNEL_TARGET static const char *KERNEL_FN(find_byte)(const char *str, size_t len, char chr)
+{
+    size_t i = 0;
+    for (; i + KERNEL_WIDTH <= len; i += KERNEL_WIDTH)
+    {
+        uint64_t mask = KERNEL_FN(eq_mask)(str + i, chr);
+        if (mask)
+        {
+            return str + i + __builtin_ctzll(mask);
+        }
+    }
+
+    for (; i < len; i++)
+    {
+        if (str[i] == chr)
+        {
+            return str + i;
+        }
+    }
+    return NULL;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(count_byte)(const char *str, size_t len, char chr)
+{
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + KERNEL_WIDTH <= len; i += KERNEL_WIDTH)
+    {
+        count += __builtin_popcountll(KERNEL_FN(eq_mask)(str + i, chr));
+    }
+
+    for (; i < len; i++)
+    {
+        count += str[i] == chr;
+    }
+    return count;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(mismatch)(const char *one, const char *two, size_t len);
+
+// candidates are the positions where both the first and the last byte of the pattern match, only
+// those are compared in full. Once the bytes compared at failed candidates outgrow the text scanned,
+// as with long patterns on repetitive text, the search goes on with the linear strix_kmp_find
+KERNEL_TARGET static const char *KERNEL_FN(find_substr)(const char *str, size_t len, const char *pattern, size_t pattern_len)
+{
+    if (pattern_len == 0)
+    {
+        return str;
+    }
+    if (pattern_len > len)
+    {
+        return NULL;
+    }
+    if (pattern_len == 1)
+    {
+        return KERNEL_FN(find_byte)(str, len, pattern[0]);
+    }
+
+    const size_t last = pattern_len - 1;
+    size_t wasted = 0;
+    size_t i = 0;
+    for (; i + last + KERNEL_WIDTH <= len; i += KERNEL_WIDTH)
+    {
+        uint64_t mask = KERNEL_FN(eq_mask)(str + i, pattern[0]) & KERNEL_FN(eq_mask)(str + i + last, pattern[last]);
+        while (mask)
+        {
+            size_t at = i + __builtin_ctzll(mask);
+            size_t same = KERNEL_FN(mismatch)(str + at + 1, pattern + 1, last - 1);
+            if (same == last - 1)
+            {
+                return str + at;
+            }
+            wasted += same + 1;
+            mask &= mask - 1;
+        }
+
+        if (wasted > i + KERNEL_VERIFY_SLACK)
+        {
+            return strix_kmp_find(str + i + KERNEL_WIDTH, len - i - KERNEL_WIDTH, pattern, pattern_len);
+        }
+    }
+
+    for (; i + last < len; i++)
+    {
+        if (str[i] == pattern[0] && memcmp(str + i + 1, pattern + 1, last) == 0)
+        {
+            return str + i;
+        }
+    }
+    return NULL;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(span_byte)(const char *str, size_t len, char chr)
+{
+    size_t span = 0;
+    for (; span + KERNEL_WIDTH <= len; span += KERNEL_WIDTH)
+    {
+        uint64_t other = ~KERNEL_FN(eq_mask)(str + span, chr) & KERNEL_FULL_MASK;
+        if (other)
+        {
+            return span + __builtin_ctzll(other);
+        }
+    }
+
+    while (span < len && str[span] == chr)
+    {
+        span++;
+    }
+    return span;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(rspan_byte)(const char *str, size_t len, char chr)
+{
+    size_t span = 0;
+    for (; span + KERNEL_WIDTH <= len; span += KERNEL_WIDTH)
+    {
+        uint64_t other = ~KERNEL_FN(eq_mask)(str + len - span - KERNEL_WIDTH, chr) & KERNEL_FULL_MASK;
+        if (other)
+        {
+            return span + KERNEL_WIDTH - 64 + __builtin_clzll(other);
+        }
+    }
+
+    while (span < len && str[len - span - 1] == chr)
+    {
+        span++;
+    }
+    return span;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(span_space)(const char *str, size_t len)
+{
+    size_t span = 0;
+    for (; span + KERNEL_WIDTH <= len; span += KERNEL_WIDTH)
+    {
+        uint64_t other = ~KERNEL_FN(space_mask)(str + span) & KERNEL_FULL_MASK;
+        if (other)
+        {
+            return span + __builtin_ctzll(other);
+        }
+    }
+
+    while (span < len && (str[span] == ' ' || (unsigned char)(str[span] - '\t') <= '\r' - '\t'))
+    {
+        span++;
+    }
+    return span;
+}
+
+KERNEL_TARGET static size_t KERNEL_FN(rspan_space)(const char *str, size_t len)
+{
+    size_t span = 0;
+    for (; span + KERNEL_WIDTH <= len; span += KERNEL_WIDTH)
+    {
+        uint64_t other = ~KERNEL_FN(space_mask)(str + len - span - KERNEL_WIDTH) & KERNEL_FULL_MASK;
+        if (other)
+        {
+            return span + KERNEL_WIDTH - 64 + __builtin_clzll(other);
+        }
+    }
+
+    while (span < len && (str[len - span - 1] == ' ' || (unsigned char)(str[len - span - 1] - '\t') <= '\r' - '\t'))
+    {
+        span++;
+    }
+    return span;
+}
+
+// strings shorter than a vector go word by word, longer ones end with a vector overlapping the
+// one before it, whose bytes are known to be equal
+KERNEL_TARGET static size_t KERNEL_FN(mismatch)(const char *one, const char *two, size_t len)
+{
+    size_t i = 0;
+    if (len < KERNEL_WIDTH)
+    {
+        for (; i + 8 <= len; i += 8)
+        {
+            uint64_t word_one, word_two;
+            memcpy(&word_one, one + i, 8);
+            memcpy(&word_two, two + i, 8);
+            if (word_one != word_two)
+            {
+                break;
+            }
+        }
+
+        while (i < len && one[i] == two[i])
+        {
+            i++;
+        }
+        return i;
+    }
+
+    for (; i + KERNEL_WIDTH <= len; i += KERNEL_WIDTH)
+    {
+        uint64_t mask = KERNEL_FN(diff_mask)(one + i, two + i);
+        if (mask)
+        {
+            return i + __builtin_ctzll(mask);
+        }
+    }
+
+    if (i == len)
+    {
+        return len;
+    }
+
+    uint64_t mask = KERNEL_FN(diff_mask)(one + len - KERNEL_WIDTH, two + len - KERNEL_WIDTH);
+    return mask ? len - KERNEL_WIDTH + __builtin_ctzll(mask) : len;
+}
+
+const strix_kernels_t KERNEL_CONCAT(strix_kernels, KERNEL_ISA) = {
+    .find_byte = KERNEL_FN(find_byte),
+    .count_byte = KERNEL_FN(count_byte),
+    .find_substr = KERNEL_FN(find_substr),
+    .span_byte = KERNEL_FN(span_byte),
+    .rspan_byte = KERNEL_FN(rspan_byte),
+    .span_space = KERNEL_FN(span_space),
+    .rspan_space = KERNEL_FN(rspan_space),
+    .mismatch = KERNEL_FN(mismatch),
+    .hash_stripes = KERNEL_FN(hash_stripes),
+    .hash_scramble = KERNEL_FN(hash_scramble),
+};
+
+#undef KERNEL_CONCAT_
+#undef KERNEL_CONCAT
+#undef KERNEL_FN
+#undef KERNEL_FULL_MASK
+#undef KERNEL_VERIFY_SLACK
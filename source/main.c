@@ -1,3 +1,14 @@
 #include "string_search.c"
+#include "strix_allocator.c"
 #include "strix.c"
-#include "strix_errno.c"
\ No newline at end of file
+#include "strix_errno.c"
+#include "strix_arena.c"
+#include "strix_cpu.c"
+#include "strix_stats.c"
+#include "strix_hash.c"
+#include "strix_map.c"
+#include "strix_intern.c"
+#include "strix_sort.c"
+#include "strix_parallel.c"
+#include "kernels/kernels_scalar.c"
+#include "kernels/kernels_x86.c"
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef DA90CD1C_68DB_46AF_B46D_B243F4CFFD1A
+#define DA90CD1C_68DB_46AF_B46D_B243F4CFFD1A
+
+#include "../../header/strix_stats.h"
+
+/*
+ * STRIX_STATS_OP(op, bytes) opens every instrumented public function. Without STRIX_STATS it is an
+ * empty statement and bytes is never evaluated. With it, it declares a scope whose cleanup runs on
+ * every return and records the call in the counters of the calling thread. STRIX_STATS_BYTES(n)
+ * adds bytes only known further down, such as the length of a string read from a file.
+ */
+#ifdef STRIX_STATS
+
+#include <time.h>
+
+typedef struct strix_thread_stats
+{
+    strix_op_stats_t ops[STRIX_OP_COUNT];
+    uint32_t depth;      // strix calls on the stack of the thread, only the outermost one is recorded
+    uint32_t countdown;  // calls until the next measured one
+    uint32_t generation; // counters are stale until the thread catches up with strix_stats_reset
+    struct strix_thread_stats *next;
+    struct strix_thread_stats *prev;
+} strix_thread_stats_t;
+
+typedef struct
+{
+    strix_thread_stats_t *thread; // NULL when the counters could not be allocated
+    strix_op_t op;                // STRIX_OP_COUNT for nested calls
+    uint64_t start_ns;            // 0 unless the call is measured
+} strix_stats_scope_t;
+
+extern _Thread_local strix_thread_stats_t *strix_stats_thread __attribute__((tls_model("initial-exec")));
+extern uint32_t strix_stats_generation;
+
+strix_thread_stats_t *strix_stats_register(void);
+void strix_stats_restart(strix_thread_stats_t *thread);
+void strix_stats_record(strix_stats_scope_t *scope);
+
+// only the owning thread writes its counters, relaxed stores keep the readers of snapshots race-free
+static inline void strix_stats_add(uint64_t *counter, uint64_t value)
+{
+    __atomic_store_n(counter, *counter + value, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t strix_stats_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+static inline strix_stats_scope_t strix_stats_enter(strix_op_t op, size_t bytes)
+{
+    strix_stats_scope_t scope = {strix_stats_thread, STRIX_OP_COUNT, 0};
+    if (!scope.thread)
+    {
+        scope.thread = strix_stats_register();
+        if (!scope.thread)
+        {
+            return scope;
+        }
+    }
+
+    if (scope.thread->depth++)
+    {
+        return scope;
+    }
+
+    if (scope.thread->generation != __atomic_load_n(&strix_stats_generation, __ATOMIC_RELAXED))
+    {
+        strix_stats_restart(scope.thread);
+    }
+
+    scope.op = op;
+    strix_stats_add(&scope.thread->ops[op].calls, 1);
+    strix_stats_add(&scope.thread->ops[op].bytes, bytes);
+    if (--scope.thread->countdown == 0)
+    {
+        scope.start_ns = strix_stats_now_ns();
+    }
+    return scope;
+}
+
+static inline void strix_stats_leave(strix_stats_scope_t *scope)
+{
+    if (!scope->thread)
+    {
+        return;
+    }
+
+    scope->thread->depth--;
+    if (scope->start_ns)
+    {
+        strix_stats_record(scope);
+    }
+}
+
+static inline void strix_stats_add_bytes(strix_stats_scope_t *scope, size_t bytes)
+{
+    if (scope->thread && scope->op != STRIX_OP_COUNT)
+    {
+        strix_stats_add(&scope->thread->ops[scope->op].bytes, bytes);
+    }
+}
+
+#define STRIX_STATS_OP(op, bytes) \
+    __attribute__((cleanup(strix_stats_leave))) strix_stats_scope_t strix_stats_scope_ = strix_stats_enter(op, bytes)
+#define STRIX_STATS_BYTES(bytes) strix_stats_add_bytes(&strix_stats_scope_, bytes)
+
+#else
+
+#define STRIX_STATS_OP(op, bytes) ((void)0)
+#define STRIX_STATS_BYTES(bytes) ((void)0)
+
+#endif // STRIX_STATS
+
+#define STRIX_STATS_LEN(strix) ((strix) ? (strix)->len : 0)
+
+#endif /* DA90CD1C_68DB_46AF_B46D_B243F4CFFD1A */
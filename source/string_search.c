@@ -1,7 +1,11 @@
 #include "../header/string_search.h"
+#include "kernels/kernels.h"
+#include "stats/stats.h"
 
 int64_t kmp_search(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
 {
+    STRIX_STATS_OP(STRIX_OP_KMP_SEARCH, string_len);
+
     size_t lps[pattern_len];
 
     size_t i = 1, j = 0;
@@ -41,8 +45,7 @@ int64_t kmp_search(const char *pattern, const char *string, size_t pattern_len,
 
             if (j == pattern_len)
             {
-                j = lps[j - 1]; // the search can be continued using this, but i return after finding the first match
-                return (i - j - 1);
+                return (int64_t)(i - pattern_len);
             }
         }
         else
@@ -63,6 +66,8 @@ int64_t kmp_search(const char *pattern, const char *string, size_t pattern_len,
 
 int64_t kmp_search_all_len(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
 {
+    STRIX_STATS_OP(STRIX_OP_KMP_SEARCH_ALL_LEN, string_len);
+
     size_t lps[pattern_len];
     int64_t counter = 0;
 
@@ -125,6 +130,8 @@ int64_t kmp_search_all_len(const char *pattern, const char *string, size_t patte
 
 position_t *kmp_search_all(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
 {
+    STRIX_STATS_OP(STRIX_OP_KMP_SEARCH_ALL, string_len);
+
     if (!pattern || !string || pattern_len == 0 || pattern_len > string_len)
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -259,4 +266,124 @@ position_t *kmp_search_all(const char *pattern, const char *string, size_t patte
     position->len = counter;
     position->pos = pos_arr;
     return position;
-}
\ No newline at end of file
+}
+
+int64_t substr_search(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
+{
+    STRIX_STATS_OP(STRIX_OP_SUBSTR_SEARCH, string_len);
+
+    const char *match = strix_kernels->find_substr(string, string_len, pattern, pattern_len);
+    return match ? match - string : -2;
+}
+
+int64_t substr_search_all_len(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
+{
+    STRIX_STATS_OP(STRIX_OP_SUBSTR_SEARCH_ALL_LEN, string_len);
+
+    if (pattern_len == 0 || pattern_len > string_len)
+    {
+        return 0;
+    }
+
+    size_t *lps = (size_t *)malloc(sizeof(size_t) * pattern_len);
+    if (!lps)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return -1;
+    }
+    strix_kmp_table(pattern, pattern_len, lps);
+
+    // one pass, overlapping matches included
+    int64_t counter = 0;
+    size_t at = 0, matched = 0;
+    while (strix_kmp_next(string, string_len, pattern, pattern_len, lps, &at, &matched) < string_len)
+    {
+        counter++;
+    }
+
+    free(lps);
+    return counter;
+}
+
+position_t *substr_search_all(const char *pattern, const char *string, size_t pattern_len, size_t string_len)
+{
+    STRIX_STATS_OP(STRIX_OP_SUBSTR_SEARCH_ALL, string_len);
+
+    if (!pattern || !string || pattern_len == 0 || pattern_len > string_len)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    position_t *position = (position_t *)malloc(sizeof(position_t));
+    if (!position)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    size_t current_max_positions = (string_len / pattern_len) + 1;
+    if (current_max_positions > MAX_POSITIONS)
+    {
+        current_max_positions = MAX_POSITIONS;
+    }
+
+    size_t *lps = (size_t *)malloc(sizeof(size_t) * pattern_len);
+    size_t *pos_arr = (size_t *)malloc(sizeof(size_t) * current_max_positions);
+    if (!lps || !pos_arr)
+    {
+        free(pos_arr);
+        free(lps);
+        free(position);
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+    strix_kmp_table(pattern, pattern_len, lps);
+
+    size_t counter = 0;
+    size_t at = 0, matched = 0;
+    size_t match;
+    while ((match = strix_kmp_next(string, string_len, pattern, pattern_len, lps, &at, &matched)) < string_len)
+    {
+        if (counter >= current_max_positions)
+        {
+            size_t new_size = current_max_positions * 2;
+            size_t *new_pos_arr = (size_t *)realloc(pos_arr, sizeof(size_t) * new_size);
+            if (!new_pos_arr)
+            {
+                free(pos_arr);
+                free(lps);
+                free(position);
+                strix_errno = STRIX_ERR_MALLOC_FAILED;
+                return NULL;
+            }
+            pos_arr = new_pos_arr;
+            current_max_positions = new_size;
+        }
+
+        pos_arr[counter++] = match;
+    }
+
+    free(lps);
+
+    if (counter == 0)
+    {
+        free(pos_arr);
+        position->len = -2;
+        position->pos = NULL;
+        return position;
+    }
+
+    if (counter < current_max_positions)
+    {
+        size_t *new_pos_arr = (size_t *)realloc(pos_arr, sizeof(size_t) * counter);
+        if (new_pos_arr)
+        {
+            pos_arr = new_pos_arr;
+        }
+    }
+
+    position->len = counter;
+    position->pos = pos_arr;
+    return position;
+}
@@ -3,6 +3,8 @@
 
 #include "../header/strix.h"
 #include "../allocator/allocator.h"
+#include "kernels/kernels.h"
+#include "stats/stats.h"
 
 static inline bool is_strix_null(const strix_t *strix)
 {
@@ -49,27 +51,101 @@ static inline bool is_strix_empty_or_null(const strix_t *strix)
     return is_strix_null(strix) || is_strix_empty(strix);
 }
 
-strix_t *strix_create_empty()
+/*
+ * Strings made here keep their bytes in the same block as their strix_t, right behind it, unless
+ * built with STRIX_SEPARATE_DATA: one allocation per string instead of two, and a strix_arr_t walk
+ * touches one block per element. The block always has room for at least one byte past the header,
+ * so a buffer allocated on its own can never sit at strix + 1 and pass for the inline bytes. A
+ * string that outgrows its inline bytes moves to a buffer of its own and leaves them unused.
+ */
+static inline bool strix_str_is_inline(const strix_t *strix)
 {
-    char *str = allocate(0);
-    if (!str)
+#ifndef STRIX_SEPARATE_DATA
+    return strix->str == (char *)(strix + 1);
+#else
+    (void)strix;
+    return false;
+#endif
+}
+
+// strix_t with room for len bytes, str and len set, or NULL if allocation fails
+static strix_t *strix_new(size_t len)
+{
+#ifndef STRIX_SEPARATE_DATA
+    if (len > SIZE_MAX - sizeof(strix_t) - 1)
     {
         return NULL;
     }
 
+    strix_t *strix = (strix_t *)allocate(sizeof(strix_t) + (len ? len : 1));
+    if (!strix)
+    {
+        return NULL;
+    }
+    strix->str = (char *)(strix + 1);
+#else
     strix_t *strix = (strix_t *)allocate(sizeof(strix_t));
     if (!strix)
     {
         return NULL;
     }
 
-    strix->str = str;
-    strix->len = 0;
+    strix->str = (char *)allocate(sizeof(char) * (len ? len : 1));
+    if (!strix->str)
+    {
+        deallocate(strix);
+        return NULL;
+    }
+#endif
+    strix->len = len;
     return strix;
 }
 
+// releases the bytes of strix, the caller points str somewhere else afterwards
+static inline void strix_release_str(strix_t *strix)
+{
+    if (!strix_str_is_inline(strix))
+    {
+        deallocate(strix->str);
+    }
+}
+
+/*
+ * A new buffer for the bytes of strix comes from wherever strix itself lives, so a string made
+ * before an arena scope never ends up pointing into the arena.
+ */
+static inline char *strix_allocate_str(const strix_t *strix, size_t len)
+{
+    return (char *)allocate_beside(strix, sizeof(char) * len);
+}
+
+// reallocate for the bytes of strix, which moves inline bytes out to a buffer of their own
+static char *strix_resize_str(strix_t *strix, size_t new_len)
+{
+    if (strix->str && !strix_str_is_inline(strix))
+    {
+        return (char *)reallocate(strix->str, sizeof(char) * new_len);
+    }
+
+    char *new_str = strix_allocate_str(strix, new_len);
+    if (new_str && strix->len)
+    {
+        memcpy(new_str, strix->str, strix->len < new_len ? strix->len : new_len);
+    }
+    return new_str;
+}
+
+strix_t *strix_create_empty()
+{
+    STRIX_STATS_OP(STRIX_OP_CREATE_EMPTY, 0);
+
+    return strix_new(0);
+}
+
 char *strix_to_cstr(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_TO_CSTR, STRIX_STATS_LEN(strix));
+
     if (!strix)
     {
         return NULL;
@@ -89,6 +165,8 @@ char *strix_to_cstr(strix_t *strix)
 
 strix_t *strix_create(const char *str)
 {
+    STRIX_STATS_OP(STRIX_OP_CREATE, 0);
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_str_null(str))
@@ -96,34 +174,25 @@ strix_t *strix_create(const char *str)
         return NULL;
     }
 
-    strix_t *strix = (strix_t *)allocate(sizeof(strix_t));
-    if (!strix)
-    {
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
-
-    strix->len = strlen(str);
-    if (!strix->len)
+    size_t len = strlen(str);
+    STRIX_STATS_BYTES(len);
+    if (!len)
     {
         strix_errno = STRIX_ERR_EMPTY_STRING;
-        deallocate(strix);
         return NULL;
     }
 
-    strix->str = (char *)allocate(strix->len);
-    if (!strix->str)
+    strix_t *strix = strix_new(len);
+    if (!strix)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
-        deallocate(strix);
         return NULL;
     }
 
     if (!memmove(strix->str, str, strix->len))
     {
         strix_errno = STRIX_ERR_MEMMOVE_FAILED;
-        deallocate(strix->str);
-        deallocate(strix);
+        strix_free(strix);
         return NULL;
     }
 
@@ -132,6 +201,8 @@ strix_t *strix_create(const char *str)
 
 strix_t *strix_duplicate(const strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_DUPLICATE, STRIX_STATS_LEN(strix));
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_strix_empty_or_null(strix))
@@ -139,27 +210,17 @@ strix_t *strix_duplicate(const strix_t *strix)
         return NULL;
     }
 
-    strix_t *duplicate = (strix_t *)allocate(sizeof(strix_t));
+    strix_t *duplicate = strix_new(strix->len);
     if (!duplicate)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
 
-    duplicate->len = strix->len;
-    duplicate->str = (char *)allocate(sizeof(char) * duplicate->len);
-    if (!duplicate->str)
-    {
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        deallocate(duplicate);
-        return NULL;
-    }
-
     if (!memcpy(duplicate->str, strix->str, strix->len))
     {
         strix_errno = STRIX_ERR_MEMCPY_FAILED;
-        deallocate(duplicate->str);
-        deallocate(duplicate);
+        strix_free(duplicate);
         return NULL;
     }
 
@@ -168,6 +229,8 @@ strix_t *strix_duplicate(const strix_t *strix)
 
 bool strix_modify(strix_t *strix, const char *str)
 {
+    STRIX_STATS_OP(STRIX_OP_MODIFY, 0);
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_strix_null(strix) || is_str_null(str))
@@ -175,6 +238,7 @@ bool strix_modify(strix_t *strix, const char *str)
         return false;
     }
 
+    STRIX_STATS_BYTES(strlen(str));
     strix_free(strix);
     strix = strix_create(str);
     if (!strix)
@@ -186,15 +250,19 @@ bool strix_modify(strix_t *strix, const char *str)
 
 void strix_free(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_FREE, STRIX_STATS_LEN(strix));
+
     if (!strix)
         return;
     if (strix->str)
-        deallocate(strix->str);
+        strix_release_str(strix);
     deallocate(strix);
 }
 
 bool strix_clear(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_CLEAR, STRIX_STATS_LEN(strix));
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_strix_null(strix))
@@ -203,13 +271,15 @@ bool strix_clear(strix_t *strix)
     }
 
     strix->len = 0;
-    deallocate(strix->str);
+    strix_release_str(strix);
     strix->str = NULL;
     return true;
 }
 
 bool strix_concat(strix_t *dest, const strix_t *src)
 {
+    STRIX_STATS_OP(STRIX_OP_CONCAT, STRIX_STATS_LEN(src));
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_strix_null(dest))
@@ -222,30 +292,24 @@ bool strix_concat(strix_t *dest, const strix_t *src)
         return true; // nothing to concatenate, not an error
     }
 
-    size_t new_len = dest->len + src->len;
-    char *new_str = (char *)allocate(sizeof(char) * new_len);
+    size_t src_len = src->len; // src may be dest itself
+    size_t new_len = dest->len + src_len;
+
+    // grows in place when the allocator can, otherwise moves the old contents for us
+    char *new_str = strix_resize_str(dest, sizeof(char) * new_len);
     if (!new_str)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return false;
     }
+    dest->str = new_str;
 
-    if (!memcpy(new_str, dest->str, dest->len))
-    {
-        strix_errno = STRIX_ERR_MEMCPY_FAILED;
-        deallocate(new_str);
-        return false;
-    }
-
-    if (!memcpy(new_str + dest->len, src->str, src->len))
+    if (!memcpy(new_str + dest->len, src->str, src_len))
     {
         strix_errno = STRIX_ERR_MEMCPY_FAILED;
-        deallocate(new_str);
         return false;
     }
 
-    deallocate(dest->str);
-    dest->str = new_str;
     dest->len = new_len;
 
     return true;
@@ -253,6 +317,8 @@ bool strix_concat(strix_t *dest, const strix_t *src)
 
 bool strix_append(strix_t *strix, const char *str)
 {
+    STRIX_STATS_OP(STRIX_OP_APPEND, 0);
+
     strix_errno = STRIX_SUCCESS;
 
     if (is_strix_null(strix) || is_str_null(str))
@@ -261,35 +327,36 @@ bool strix_append(strix_t *strix, const char *str)
     }
 
     size_t str_len = strlen(str);
+    STRIX_STATS_BYTES(str_len);
     if (!str_len)
     {
         return true; // nothing to append, not an error
     }
 
+    // str may point into the buffer that is about to move
+    bool str_is_inside = strix->str && str >= strix->str && str < strix->str + strix->len;
+    size_t str_offset = str_is_inside ? (size_t)(str - strix->str) : 0;
+
     size_t new_len = strix->len + str_len;
-    char *new_str = (char *)allocate(sizeof(char) * new_len);
+    char *new_str = strix_resize_str(strix, sizeof(char) * new_len);
     if (!new_str)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return false;
     }
+    strix->str = new_str;
 
-    if (!memcpy(new_str, strix->str, strix->len))
+    if (str_is_inside)
     {
-        strix_errno = STRIX_ERR_MEMCPY_FAILED;
-        deallocate(new_str);
-        return false;
+        str = new_str + str_offset;
     }
 
     if (!memcpy(new_str + strix->len, str, str_len))
     {
         strix_errno = STRIX_ERR_MEMCPY_FAILED;
-        deallocate(new_str);
         return false;
     }
 
-    deallocate(strix->str);
-    strix->str = new_str;
     strix->len = new_len;
 
     return true;
@@ -297,6 +364,8 @@ bool strix_append(strix_t *strix, const char *str)
 
 bool strix_insert_str(strix_t *strix, size_t pos, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_INSERT_STR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -315,7 +384,7 @@ bool strix_insert_str(strix_t *strix, size_t pos, const char *substr)
         return false;
     }
 
-    char *new_str = (char *)allocate(sizeof(char) * (strlen(substr) + strix->len));
+    char *new_str = strix_allocate_str(strix, strlen(substr) + strix->len);
     if (is_str_null(new_str))
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
@@ -340,7 +409,7 @@ bool strix_insert_str(strix_t *strix, size_t pos, const char *substr)
         return false;
     }
 
-    deallocate(strix->str);
+    strix_release_str(strix);
     strix->str = new_str;
     strix->len = strix->len + strlen(substr);
 
@@ -350,6 +419,8 @@ bool strix_insert_str(strix_t *strix, size_t pos, const char *substr)
 
 bool strix_insert(strix_t *strix_dest, strix_t *strix_src, size_t pos)
 {
+    STRIX_STATS_OP(STRIX_OP_INSERT, STRIX_STATS_LEN(strix_dest));
+
     if (is_strix_null(strix_dest) || is_strix_null(strix_src))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -371,7 +442,7 @@ bool strix_insert(strix_t *strix_dest, strix_t *strix_src, size_t pos)
     char *substr = strix_src->str;
     size_t len = strix_src->len;
 
-    char *new_str = (char *)allocate(sizeof(char) * (len + strix_dest->len));
+    char *new_str = strix_allocate_str(strix_dest, len + strix_dest->len);
     if (is_str_null(new_str))
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
@@ -396,7 +467,7 @@ bool strix_insert(strix_t *strix_dest, strix_t *strix_src, size_t pos)
         return false;
     }
 
-    deallocate(strix_dest->str);
+    strix_release_str(strix_dest);
     strix_dest->str = new_str;
     strix_dest->len = strix_dest->len + len;
 
@@ -406,6 +477,8 @@ bool strix_insert(strix_t *strix_dest, strix_t *strix_src, size_t pos)
 
 bool strix_erase(strix_t *strix, size_t len, size_t pos)
 {
+    STRIX_STATS_OP(STRIX_OP_ERASE, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -429,7 +502,7 @@ bool strix_erase(strix_t *strix, size_t len, size_t pos)
         len = strix->len - pos - 1;
     }
 
-    char *new_str = (char *)allocate(sizeof(char) * (strix->len - len));
+    char *new_str = strix_allocate_str(strix, strix->len - len);
     if (is_str_null(new_str))
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
@@ -448,7 +521,7 @@ bool strix_erase(strix_t *strix, size_t len, size_t pos)
         return false;
     }
 
-    deallocate(strix->str);
+    strix_release_str(strix);
     strix->str = new_str;
     strix->len -= len;
 
@@ -458,6 +531,8 @@ bool strix_erase(strix_t *strix, size_t len, size_t pos)
 
 char strix_at(const strix_t *strix, size_t index)
 {
+    STRIX_STATS_OP(STRIX_OP_AT, 0);
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -476,6 +551,8 @@ char strix_at(const strix_t *strix, size_t index)
 
 int strix_equal(const strix_t *strix_one, const strix_t *strix_two)
 {
+    STRIX_STATS_OP(STRIX_OP_EQUAL, STRIX_STATS_LEN(strix_one));
+
     if (is_strix_null(strix_one) || is_strix_null(strix_two))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -496,7 +573,7 @@ int strix_equal(const strix_t *strix_one, const strix_t *strix_two)
     strix_errno = STRIX_SUCCESS;
 
     size_t len = strix_one->len;
-    if (!strncmp(strix_one->str, strix_two->str, len))
+    if (strix_kernels->mismatch(strix_one->str, strix_two->str, len) == len)
     {
         return 0;
     }
@@ -504,8 +581,90 @@ int strix_equal(const strix_t *strix_one, const strix_t *strix_two)
     return 1;
 }
 
+int strix_compare(const strix_t *strix_one, const strix_t *strix_two)
+{
+    STRIX_STATS_OP(STRIX_OP_COMPARE, STRIX_STATS_LEN(strix_one));
+
+    if (is_strix_null(strix_one) || is_strix_null(strix_two))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+
+    if ((!strix_one->str && strix_one->len) || (!strix_two->str && strix_two->len))
+    {
+        strix_errno = STRIX_ERR_STRIX_STR_NULL;
+        return 0;
+    }
+
+    strix_errno = STRIX_SUCCESS;
+
+    size_t len = strix_one->len < strix_two->len ? strix_one->len : strix_two->len;
+    size_t diff = len ? strix_kernels->mismatch(strix_one->str, strix_two->str, len) : 0;
+    if (diff < len)
+    {
+        return (unsigned char)strix_one->str[diff] < (unsigned char)strix_two->str[diff] ? -1 : 1;
+    }
+
+    return (strix_one->len > strix_two->len) - (strix_one->len < strix_two->len);
+}
+
+static inline uint64_t strix_read_word(const char *ptr)
+{
+    uint64_t word;
+    memcpy(&word, ptr, sizeof(word));
+    return word;
+}
+
+bool strix_equal_fast(const strix_t *strix_one, const strix_t *strix_two)
+{
+    STRIX_STATS_OP(STRIX_OP_EQUAL_FAST, STRIX_STATS_LEN(strix_one));
+
+    if (is_strix_null(strix_one) || is_strix_null(strix_two))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    if ((!strix_one->str && strix_one->len) || (!strix_two->str && strix_two->len))
+    {
+        strix_errno = STRIX_ERR_STRIX_STR_NULL;
+        return false;
+    }
+
+    strix_errno = STRIX_SUCCESS;
+
+    const size_t len = strix_one->len;
+    if (len != strix_two->len)
+    {
+        return false;
+    }
+    if (strix_one->str == strix_two->str || len == 0)
+    {
+        return true;
+    }
+
+    const char *one = strix_one->str;
+    const char *two = strix_two->str;
+    if (len < 8)
+    {
+        return memcmp(one, two, len) == 0;
+    }
+
+    // the two words overlap for fewer than 16 bytes and cover the whole string up to 16
+    if (strix_read_word(one) != strix_read_word(two) ||
+        strix_read_word(one + len - 8) != strix_read_word(two + len - 8))
+    {
+        return false;
+    }
+    // starting over at 0 keeps the vector loads as aligned as the strings are
+    return len <= 16 || strix_kernels->mismatch(one, two, len) == len;
+}
+
 int64_t strix_find(const strix_t *strix, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -519,11 +678,13 @@ int64_t strix_find(const strix_t *strix, const char *substr)
     }
 
     strix_errno = STRIX_SUCCESS;
-    return kmp_search(substr, strix->str, strlen(substr), strix->len);
+    return substr_search(substr, strix->str, strlen(substr), strix->len);
 }
 
 position_t *strix_find_all(const strix_t *strix, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND_ALL, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -537,11 +698,13 @@ position_t *strix_find_all(const strix_t *strix, const char *substr)
     }
 
     strix_errno = STRIX_SUCCESS;
-    return kmp_search_all(substr, strix->str, strlen(substr), strix->len);
+    return substr_search_all(substr, strix->str, strlen(substr), strix->len);
 }
 
 int64_t strix_find_subtrix(const strix_t *strix_one, const strix_t *strix_two)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND_SUBTRIX, STRIX_STATS_LEN(strix_one));
+
     if (is_strix_null(strix_one) || is_strix_null(strix_two))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -555,11 +718,13 @@ int64_t strix_find_subtrix(const strix_t *strix_one, const strix_t *strix_two)
     }
 
     strix_errno = STRIX_SUCCESS;
-    return kmp_search(strix_two->str, strix_one->str, strix_two->len, strix_one->len);
+    return substr_search(strix_two->str, strix_one->str, strix_two->len, strix_one->len);
 }
 
 position_t *strix_find_subtrix_all(const strix_t *strix_one, const strix_t *strix_two)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND_SUBTRIX_ALL, STRIX_STATS_LEN(strix_one));
+
     if (is_strix_null(strix_one) || is_strix_null(strix_two))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -573,11 +738,13 @@ position_t *strix_find_subtrix_all(const strix_t *strix_one, const strix_t *stri
     }
 
     strix_errno = STRIX_SUCCESS;
-    return kmp_search_all(strix_two->str, strix_one->str, strix_two->len, strix_one->len);
+    return substr_search_all(strix_two->str, strix_one->str, strix_two->len, strix_one->len);
 }
 
 void strix_position_free(position_t *position)
 {
+    STRIX_STATS_OP(STRIX_OP_POSITION_FREE, 0);
+
     free(position->pos);
     free(position);
     strix_errno = STRIX_SUCCESS;
@@ -585,6 +752,8 @@ void strix_position_free(position_t *position)
 
 void strix_free_strix_arr(strix_arr_t *strix_arr)
 {
+    STRIX_STATS_OP(STRIX_OP_FREE_STRIX_ARR, 0);
+
     if (!strix_arr)
         return;
 
@@ -599,33 +768,26 @@ void strix_free_strix_arr(strix_arr_t *strix_arr)
 
 strix_t *strix_slice(const strix_t *strix, size_t start, size_t end)
 {
+    STRIX_STATS_OP(STRIX_OP_SLICE, 0);
+
     if (start > end || end >= strix->len || is_strix_null(strix))
     {
         strix_errno = start > end || end >= strix->len ? STRIX_ERR_INVALID_BOUNDS : STRIX_ERR_NULL_PTR;
         return NULL;
     }
 
-    strix_t *slice = (strix_t *)allocate(sizeof(strix_t));
+    strix_t *slice = strix_new(end - start + 1);
     if (is_strix_null(slice))
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
-
-    slice->len = end - start + 1;
-    slice->str = (char *)allocate(sizeof(char) * slice->len);
-    if (!slice->str)
-    {
-        deallocate(slice);
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
+    STRIX_STATS_BYTES(slice->len);
 
     void *result = memcpy(slice->str, strix->str + start, slice->len);
     if (!result)
     {
-        deallocate(slice->str);
-        deallocate(slice);
+        strix_free(slice);
         strix_errno = STRIX_ERR_MEMCPY_FAILED;
         return NULL;
     }
@@ -636,6 +798,8 @@ strix_t *strix_slice(const strix_t *strix, size_t start, size_t end)
 
 strix_arr_t *strix_split_by_delim(const strix_t *strix, const char delim)
 {
+    STRIX_STATS_OP(STRIX_OP_SPLIT_BY_DELIM, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_strix_str_null(strix))
     {
         strix_errno = is_strix_null(strix) ? STRIX_ERR_NULL_PTR : STRIX_ERR_STRIX_STR_NULL;
@@ -661,55 +825,52 @@ strix_arr_t *strix_split_by_delim(const strix_t *strix, const char delim)
     size_t len = 0;
     size_t j = 0;
 
-    for (size_t i = 0; i <= strix->len; i++)
+    while (j <= strix->len)
     {
-        if (i == strix->len || strix->str[i] == delim)
+        const char *found = strix_kernels->find_byte(strix->str + j, strix->len - j, delim);
+        size_t i = found ? (size_t)(found - strix->str) : strix->len;
+        if (i != j)
         {
-            if (i != j)
+            if (len >= current_max_size)
             {
-                if (len >= current_max_size)
+                size_t new_size = current_max_size * 2;
+                strix_t **new_arr = (strix_t **)allocate(sizeof(strix_t *) * new_size);
+                if (!new_arr)
                 {
-                    size_t new_size = current_max_size * 2;
-                    strix_t **new_arr = (strix_t **)allocate(sizeof(strix_t *) * new_size);
-                    if (!new_arr)
-                    {
-                        for (size_t k = 0; k < len; k++)
-                        {
-                            deallocate(strix_arr[k]->str);
-                            deallocate(strix_arr[k]);
-                        }
-                        deallocate(strix_arr);
-                        deallocate(strix_arr_struct);
-                        strix_errno = STRIX_ERR_MALLOC_FAILED;
-                        return NULL;
-                    }
-
                     for (size_t k = 0; k < len; k++)
                     {
-                        new_arr[k] = strix_arr[k];
+                        strix_free(strix_arr[k]);
                     }
-
                     deallocate(strix_arr);
-                    strix_arr = new_arr;
-                    current_max_size = new_size;
+                    deallocate(strix_arr_struct);
+                    strix_errno = STRIX_ERR_MALLOC_FAILED;
+                    return NULL;
                 }
 
-                strix_t *substrix = strix_slice(strix, j, i - 1);
-                if (is_strix_null(substrix))
+                for (size_t k = 0; k < len; k++)
                 {
-                    for (size_t k = 0; k < len; k++)
-                    {
-                        deallocate(strix_arr[k]->str);
-                        deallocate(strix_arr[k]);
-                    }
-                    deallocate(strix_arr);
-                    deallocate(strix_arr_struct);
-                    return NULL;
+                    new_arr[k] = strix_arr[k];
+                }
+
+                deallocate(strix_arr);
+                strix_arr = new_arr;
+                current_max_size = new_size;
+            }
+
+            strix_t *substrix = strix_slice(strix, j, i - 1);
+            if (is_strix_null(substrix))
+            {
+                for (size_t k = 0; k < len; k++)
+                {
+                    strix_free(strix_arr[k]);
                 }
-                strix_arr[len++] = substrix;
+                deallocate(strix_arr);
+                deallocate(strix_arr_struct);
+                return NULL;
             }
-            j = i + 1;
+            strix_arr[len++] = substrix;
         }
+        j = i + 1;
     }
 
     if (len < current_max_size / 2)
@@ -734,6 +895,8 @@ strix_arr_t *strix_split_by_delim(const strix_t *strix, const char delim)
 
 strix_arr_t *strix_split_by_substr(const strix_t *strix, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_SPLIT_BY_SUBSTR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -752,14 +915,14 @@ strix_arr_t *strix_split_by_substr(const strix_t *strix, const char *substr)
     }
     if (position->len == -1)
     {
-        deallocate(position);
+        strix_free_position(position);
         return NULL;
     }
 
     strix_arr_t *strix_arr_struct = (strix_arr_t *)allocate(sizeof(strix_arr_t));
     if (!strix_arr_struct)
     {
-        deallocate(position);
+        strix_free_position(position);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
@@ -769,7 +932,7 @@ strix_arr_t *strix_split_by_substr(const strix_t *strix, const char *substr)
         strix_t *copy = strix_duplicate(strix);
         if (!copy)
         {
-            deallocate(position);
+            strix_free_position(position);
             deallocate(strix_arr_struct);
             return NULL;
         }
@@ -777,21 +940,21 @@ strix_arr_t *strix_split_by_substr(const strix_t *strix, const char *substr)
         strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *));
         if (!strix_arr_struct->strix_arr)
         {
-            deallocate(position);
-            deallocate(copy);
+            strix_free_position(position);
+            strix_free(copy);
             deallocate(strix_arr_struct);
             strix_errno = STRIX_ERR_MALLOC_FAILED;
             return NULL;
         }
         strix_arr_struct->strix_arr[0] = copy;
-        deallocate(position);
+        strix_free_position(position);
         return strix_arr_struct;
     }
 
-    strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *) * MAX_SUBSTRIX_NUM);
+    strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *) * (position->len + 1)); // one more part than matches at most
     if (!strix_arr_struct->strix_arr)
     {
-        deallocate(position);
+        strix_free_position(position);
         deallocate(strix_arr_struct);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
@@ -845,25 +1008,26 @@ strix_arr_t *strix_split_by_substr(const strix_t *strix, const char *substr)
         {
             for (size_t i = 0; i < len; i++)
             {
-                deallocate(strix_arr_struct->strix_arr[i]->str);
-                deallocate(strix_arr_struct->strix_arr[i]);
+                strix_free(strix_arr_struct->strix_arr[i]);
             }
             deallocate(strix_arr_struct->strix_arr);
             deallocate(strix_arr_struct);
-            deallocate(position);
+            strix_free_position(position);
             return NULL;
         }
         strix_arr_struct->strix_arr[len++] = substrix;
     }
 
     strix_arr_struct->len = len;
-    deallocate(position);
+    strix_free_position(position);
     strix_errno = STRIX_SUCCESS;
     return strix_arr_struct;
 }
 
 strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substrix)
 {
+    STRIX_STATS_OP(STRIX_OP_SPLIT_BY_SUBSTRIX, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_strix_null(substrix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -882,14 +1046,14 @@ strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substr
     }
     if (position->len == -1)
     {
-        deallocate(position);
+        strix_free_position(position);
         return NULL;
     }
 
     strix_arr_t *strix_arr_struct = (strix_arr_t *)allocate(sizeof(strix_arr_t));
     if (!strix_arr_struct)
     {
-        deallocate(position);
+        strix_free_position(position);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
@@ -899,7 +1063,7 @@ strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substr
         strix_t *copy = strix_duplicate(strix);
         if (!copy)
         {
-            deallocate(position);
+            strix_free_position(position);
             deallocate(strix_arr_struct);
             return NULL;
         }
@@ -907,21 +1071,21 @@ strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substr
         strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *));
         if (!strix_arr_struct->strix_arr)
         {
-            deallocate(position);
-            deallocate(copy);
+            strix_free_position(position);
+            strix_free(copy);
             deallocate(strix_arr_struct);
             strix_errno = STRIX_ERR_MALLOC_FAILED;
             return NULL;
         }
         strix_arr_struct->strix_arr[0] = copy;
-        deallocate(position);
+        strix_free_position(position);
         return strix_arr_struct;
     }
 
-    strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *) * MAX_SUBSTRIX_NUM);
+    strix_arr_struct->strix_arr = (strix_t **)allocate(sizeof(strix_t *) * (position->len + 1)); // one more part than matches at most
     if (!strix_arr_struct->strix_arr)
     {
-        deallocate(position);
+        strix_free_position(position);
         deallocate(strix_arr_struct);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
@@ -975,19 +1139,18 @@ strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substr
         {
             for (size_t i = 0; i < len; i++)
             {
-                deallocate(strix_arr_struct->strix_arr[i]->str);
-                deallocate(strix_arr_struct->strix_arr[i]);
+                strix_free(strix_arr_struct->strix_arr[i]);
             }
             deallocate(strix_arr_struct->strix_arr);
             deallocate(strix_arr_struct);
-            deallocate(position);
+            strix_free_position(position);
             return NULL;
         }
         strix_arr_struct->strix_arr[len++] = substrix;
     }
 
     strix_arr_struct->len = len;
-    deallocate(position);
+    strix_free_position(position);
     strix_errno = STRIX_SUCCESS;
     return strix_arr_struct;
 }
@@ -997,6 +1160,8 @@ strix_arr_t *strix_split_by_substrix(const strix_t *strix, const strix_t *substr
 
 strix_t *strix_join_via_delim(const strix_t **strix_arr, size_t len, const char delim)
 {
+    STRIX_STATS_OP(STRIX_OP_JOIN_VIA_DELIM, 0);
+
     if (!strix_arr || !len)
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1015,22 +1180,14 @@ strix_t *strix_join_via_delim(const strix_t **strix_arr, size_t len, const char
     }
     total_len += len - 1; // add space for delimiters
 
-    strix_t *result = (strix_t *)allocate(sizeof(strix_t));
+    STRIX_STATS_BYTES(total_len);
+    strix_t *result = strix_new(total_len);
     if (!result)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
 
-    result->str = (char *)allocate(sizeof(char) * total_len);
-    if (!result->str)
-    {
-        deallocate(result);
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
-    result->len = total_len;
-
     char *ptr = result->str;
     for (size_t i = 0; i < len; i++)
     {
@@ -1054,6 +1211,8 @@ strix_t *strix_join_via_delim(const strix_t **strix_arr, size_t len, const char
 
 strix_t *strix_join_via_substr(const strix_t **strix_arr, size_t len, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_JOIN_VIA_SUBSTR, 0);
+
     if (!strix_arr || !len || !substr)
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1073,22 +1232,14 @@ strix_t *strix_join_via_substr(const strix_t **strix_arr, size_t len, const char
     }
     total_len += (len - 1) * substr_len;
 
-    strix_t *result = (strix_t *)allocate(sizeof(strix_t));
+    STRIX_STATS_BYTES(total_len);
+    strix_t *result = strix_new(total_len);
     if (!result)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
 
-    result->str = (char *)allocate(sizeof(char) * total_len);
-    if (!result->str)
-    {
-        deallocate(result);
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
-    result->len = total_len;
-
     char *ptr = result->str;
     for (size_t i = 0; i < len; i++)
     {
@@ -1115,6 +1266,8 @@ strix_t *strix_join_via_substr(const strix_t **strix_arr, size_t len, const char
 
 strix_t *strix_join_via_substrix(const strix_t **strix_arr, size_t len, const strix_t *substrix)
 {
+    STRIX_STATS_OP(STRIX_OP_JOIN_VIA_SUBSTRIX, 0);
+
     if (!strix_arr || !len || is_strix_null(substrix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1133,22 +1286,14 @@ strix_t *strix_join_via_substrix(const strix_t **strix_arr, size_t len, const st
     }
     total_len += (len - 1) * substrix->len;
 
-    strix_t *result = (strix_t *)allocate(sizeof(strix_t));
+    STRIX_STATS_BYTES(total_len);
+    strix_t *result = strix_new(total_len);
     if (!result)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
 
-    result->str = (char *)allocate(sizeof(char) * total_len);
-    if (!result->str)
-    {
-        deallocate(result);
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
-    result->len = total_len;
-
     char *ptr = result->str;
     for (size_t i = 0; i < len; i++)
     {
@@ -1175,6 +1320,8 @@ strix_t *strix_join_via_substrix(const strix_t **strix_arr, size_t len, const st
 
 bool strix_trim_whitespace(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_TRIM_WHITESPACE, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1190,28 +1337,20 @@ bool strix_trim_whitespace(strix_t *strix)
         return true;
     }
 
-    size_t start = 0;
-    while (start < strix->len && isspace((unsigned char)strix->str[start]))
-    {
-        start++;
-    }
+    size_t start = strix_kernels->span_space(strix->str, strix->len);
 
     if (start == strix->len)
     {
-        deallocate(strix->str);
+        strix_release_str(strix);
         strix->str = NULL;
         strix->len = 0;
         return true;
     }
 
-    size_t end = strix->len - 1;
-    while (end > start && isspace((unsigned char)strix->str[end]))
-    {
-        end--;
-    }
+    size_t end = strix->len - 1 - strix_kernels->rspan_space(strix->str, strix->len);
 
     size_t new_len = end - start + 1;
-    char *new_str = allocate(new_len);
+    char *new_str = strix_allocate_str(strix, new_len);
     if (!new_str)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
@@ -1225,7 +1364,7 @@ bool strix_trim_whitespace(strix_t *strix)
         return false;
     }
 
-    deallocate(strix->str);
+    strix_release_str(strix);
     strix->str = new_str;
     strix->len = new_len;
     return true;
@@ -1233,6 +1372,8 @@ bool strix_trim_whitespace(strix_t *strix)
 
 bool strix_trim_char(strix_t *strix, const char trim)
 {
+    STRIX_STATS_OP(STRIX_OP_TRIM_CHAR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1248,28 +1389,20 @@ bool strix_trim_char(strix_t *strix, const char trim)
         return true;
     }
 
-    size_t start = 0;
-    while (start < strix->len && strix->str[start] == trim)
-    {
-        start++;
-    }
+    size_t start = strix_kernels->span_byte(strix->str, strix->len, trim);
 
     if (start == strix->len)
     {
-        deallocate(strix->str);
+        strix_release_str(strix);
         strix->str = NULL;
         strix->len = 0;
         return true;
     }
 
-    size_t end = strix->len - 1;
-    while (end > start && strix->str[end] == trim)
-    {
-        end--;
-    }
+    size_t end = strix->len - 1 - strix_kernels->rspan_byte(strix->str, strix->len, trim);
 
     size_t new_len = end - start + 1;
-    char *new_str = allocate(new_len);
+    char *new_str = strix_allocate_str(strix, new_len);
     if (!new_str)
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
@@ -1283,7 +1416,7 @@ bool strix_trim_char(strix_t *strix, const char trim)
         return false;
     }
 
-    deallocate(strix->str);
+    strix_release_str(strix);
     strix->str = new_str;
     strix->len = new_len;
     return true;
@@ -1291,6 +1424,8 @@ bool strix_trim_char(strix_t *strix, const char trim)
 
 double strix_to_double(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_TO_DOUBLE, STRIX_STATS_LEN(strix));
+
     double num = 0;
     double fraction_part = 0;
     bool is_neg = false;
@@ -1358,6 +1493,8 @@ double strix_to_double(strix_t *strix)
 
 uint64_t strix_to_unsigned_int(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_TO_UNSIGNED_INT, STRIX_STATS_LEN(strix));
+
     strix_errno = STRIX_SUCCESS;
     uint64_t num = 0;
 
@@ -1396,6 +1533,8 @@ uint64_t strix_to_unsigned_int(strix_t *strix)
 
 int64_t strix_to_signed_int(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_TO_SIGNED_INT, STRIX_STATS_LEN(strix));
+
     strix_errno = STRIX_SUCCESS;
     bool is_neg = false;
     int64_t num = 0;
@@ -1446,6 +1585,8 @@ int64_t strix_to_signed_int(strix_t *strix)
 
 int64_t strix_count_char(const strix_t *strix, const char chr)
 {
+    STRIX_STATS_OP(STRIX_OP_COUNT_CHAR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1458,20 +1599,13 @@ int64_t strix_count_char(const strix_t *strix, const char chr)
         return -1;
     }
 
-    int64_t count = 0;
-    for (size_t counter = 0; counter < strix->len; counter++)
-    {
-        if (strix->str[counter] == chr)
-        {
-            count++;
-        }
-    }
-
-    return count;
+    return (int64_t)strix_kernels->count_byte(strix->str, strix->len, chr);
 }
 
 int64_t strix_count_substr(const strix_t *strix, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_COUNT_SUBSTR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1483,11 +1617,13 @@ int64_t strix_count_substr(const strix_t *strix, const char *substr)
         return -1;
     }
 
-    return kmp_search_all_len(substr, strix->str, strlen(substr), strix->len);
+    return substr_search_all_len(substr, strix->str, strlen(substr), strix->len);
 }
 
 int64_t strix_count_substrix(const strix_t *strix, const strix_t *substrix)
 {
+    STRIX_STATS_OP(STRIX_OP_COUNT_SUBSTRIX, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_strix_null(substrix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1499,11 +1635,13 @@ int64_t strix_count_substrix(const strix_t *strix, const strix_t *substrix)
         return -1;
     }
 
-    return kmp_search_all_len(substrix->str, strix->str, substrix->len, strix->len);
+    return substr_search_all_len(substrix->str, strix->str, substrix->len, strix->len);
 }
 
 strix_t *strix_slice_by_stride(const strix_t *strix, size_t start, size_t end, size_t stride)
 {
+    STRIX_STATS_OP(STRIX_OP_SLICE_BY_STRIDE, STRIX_STATS_LEN(strix));
+
     if (start > end || end >= strix->len || is_strix_null(strix))
     {
         strix_errno = start > end || end >= strix->len ? STRIX_ERR_INVALID_BOUNDS : STRIX_ERR_NULL_PTR;
@@ -1519,22 +1657,13 @@ strix_t *strix_slice_by_stride(const strix_t *strix, size_t start, size_t end, s
     size_t range = end - start + 1;
     size_t slice_len = (range + stride - 1) / stride; // Ceiling division
 
-    strix_t *slice = (strix_t *)allocate(sizeof(strix_t));
+    strix_t *slice = strix_new(slice_len);
     if (is_strix_null(slice))
     {
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
 
-    slice->len = slice_len;
-    slice->str = (char *)allocate(sizeof(char) * slice_len);
-    if (!slice->str)
-    {
-        deallocate(slice);
-        strix_errno = STRIX_ERR_MALLOC_FAILED;
-        return NULL;
-    }
-
     for (size_t i = 0, src_idx = start; i < slice_len; i++, src_idx += stride)
     {
         slice->str[i] = strix->str[src_idx];
@@ -1546,6 +1675,8 @@ strix_t *strix_slice_by_stride(const strix_t *strix, size_t start, size_t end, s
 
 char_arr_t *strix_find_unique_char(strix_t *strix)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND_UNIQUE_CHAR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1595,6 +1726,8 @@ char_arr_t *strix_find_unique_char(strix_t *strix)
 
 bool strix_delete_occurence(strix_t *strix, const char *substr)
 {
+    STRIX_STATS_OP(STRIX_OP_DELETE_OCCURENCE, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix) || is_str_null(substr))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1608,18 +1741,32 @@ bool strix_delete_occurence(strix_t *strix, const char *substr)
     }
 
     position_t *positions = strix_find_all(strix, substr);
-    if (positions == NULL)
+    if (positions == NULL || positions->len < 0) // -2 when substr does not occur
     {
+        strix_free_position(positions);
         strix_errno = STRIX_SUCCESS;
         return true;
     }
 
     size_t substr_len = strlen(substr);
+
+    // matches may overlap, a match starting inside the one deleted before it is kept
+    int64_t deleted = 0;
+    for (int64_t i = 0; i < positions->len; i++)
+    {
+        if (deleted == 0 || positions->pos[i] >= positions->pos[deleted - 1] + substr_len)
+        {
+            positions->pos[deleted++] = positions->pos[i];
+        }
+    }
+    positions->len = deleted;
+
     size_t new_len = strix->len - (substr_len * positions->len);
 
-    char *new_str = (char *)allocate((new_len) * sizeof(char));
+    char *new_str = strix_allocate_str(strix, new_len);
     if (new_str == NULL)
     {
+        strix_free_position(positions);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return false;
     }
@@ -1635,6 +1782,7 @@ bool strix_delete_occurence(strix_t *strix, const char *substr)
         if (memcpy(new_str + copy_pos, strix->str + current_pos, copy_len) == NULL)
         {
             deallocate(new_str);
+            strix_free_position(positions);
             strix_errno = STRIX_ERR_MEMCPY_FAILED;
             return false;
         }
@@ -1648,12 +1796,14 @@ bool strix_delete_occurence(strix_t *strix, const char *substr)
         if (memcpy(new_str + copy_pos, strix->str + current_pos, strix->len - current_pos) == NULL)
         {
             deallocate(new_str);
+            strix_free_position(positions);
             strix_errno = STRIX_ERR_MEMCPY_FAILED;
             return false;
         }
     }
 
-    deallocate(strix->str);
+    strix_free_position(positions);
+    strix_release_str(strix);
     strix->str = new_str;
     strix->len = new_len;
 
@@ -1663,6 +1813,8 @@ bool strix_delete_occurence(strix_t *strix, const char *substr)
 
 void strix_free_char_arr(char_arr_t *char_arr)
 {
+    STRIX_STATS_OP(STRIX_OP_FREE_CHAR_ARR, 0);
+
     if (!char_arr || !char_arr->unique_char_arr)
     {
         return;
@@ -1674,6 +1826,8 @@ void strix_free_char_arr(char_arr_t *char_arr)
 
 position_t *strix_find_all_char(const strix_t *strix, const char chr)
 {
+    STRIX_STATS_OP(STRIX_OP_FIND_ALL_CHAR, STRIX_STATS_LEN(strix));
+
     if (is_strix_null(strix))
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1693,23 +1847,23 @@ position_t *strix_find_all_char(const strix_t *strix, const char chr)
         return false;
     }
 
-#define MAX_POSITIONS 1024
-    size_t *pos_arr = (size_t *)malloc(sizeof(size_t) * MAX_POSITIONS);
+    size_t len = strix_kernels->count_byte(strix->str, strix->len, chr);
+
+    // one slot per match
+    size_t *pos_arr = (size_t *)malloc(sizeof(size_t) * (len ? len : 1));
     if (!pos_arr)
     {
+        free(posn);
         strix_errno = STRIX_ERR_MALLOC_FAILED;
         return NULL;
     }
-#undef MAX_POSITIONS
 
-    size_t len = 0;
-
-    for (size_t counter = 0; counter < strix->len; counter++)
+    len = 0;
+    const char *end = strix->str + strix->len;
+    for (const char *found = strix_kernels->find_byte(strix->str, strix->len, chr); found;
+         found = strix_kernels->find_byte(found + 1, end - found - 1, chr))
     {
-        if (strix->str[counter] == chr)
-        {
-            pos_arr[len++] = counter;
-        }
+        pos_arr[len++] = found - strix->str;
     }
 
     posn->pos = pos_arr;
@@ -1720,6 +1874,8 @@ position_t *strix_find_all_char(const strix_t *strix, const char chr)
 
 strix_t *conv_file_to_strix(const char *file_path)
 {
+    STRIX_STATS_OP(STRIX_OP_CONV_FILE_TO_STRIX, 0);
+
     if (!file_path)
     {
         strix_errno = STRIX_ERR_NULL_PTR;
@@ -1764,6 +1920,7 @@ strix_t *conv_file_to_strix(const char *file_path)
     input_file_array[input_file_len] = '\0';
 
     size_t bytes_read = fread(input_file_array, 1, input_file_len, input_file);
+    STRIX_STATS_BYTES(bytes_read);
     if (bytes_read != (size_t)input_file_len)
     {
         strix_errno = STRIX_ERR_STDIO;
@@ -1785,6 +1942,8 @@ strix_t *conv_file_to_strix(const char *file_path)
 
 void strix_free_position(position_t *pos)
 {
+    STRIX_STATS_OP(STRIX_OP_FREE_POSITION, 0);
+
     if (!pos)
     {
         return;
@@ -0,0 +1,77 @@
+#define MEM_IMPLEMENTATION // the allocator in allocator/ is compiled into this translation unit
+
+#include "../header/strix_allocator.h"
+#include "../allocator/allocator.h"
+
+_Thread_local allocator_scope_t *allocator_scope = NULL;
+_Thread_local const strix_allocator_t *allocator_installed = NULL;
+
+static void *libc_alloc(void *user_data, size_t size)
+{
+    (void)user_data;
+    return malloc(size);
+}
+
+static void *libc_realloc(void *user_data, void *ptr, size_t size)
+{
+    (void)user_data;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void *user_data, void *ptr)
+{
+    (void)user_data;
+    free(ptr);
+}
+
+static void *heap_allocator_alloc(void *user_data, size_t size)
+{
+    (void)user_data;
+    return heap_alloc(size, ALIGN_DEFAULT);
+}
+
+static void *heap_allocator_realloc(void *user_data, void *ptr, size_t size)
+{
+    (void)user_data;
+    return heap_realloc(ptr, size, ALIGN_DEFAULT);
+}
+
+static void heap_allocator_free(void *user_data, void *ptr)
+{
+    (void)user_data;
+    heap_free(ptr);
+}
+
+const strix_allocator_t strix_allocator_libc = {libc_alloc, libc_realloc, libc_free, NULL};
+const strix_allocator_t strix_allocator_heap = {heap_allocator_alloc, heap_allocator_realloc, heap_allocator_free, NULL};
+
+const strix_allocator_t *strix_allocator_get(void)
+{
+    if (allocator_installed)
+    {
+        return allocator_installed;
+    }
+#ifdef CUSTOM_ALLOCATOR
+    return &strix_allocator_heap;
+#else
+    return &strix_allocator_libc;
+#endif
+}
+
+const strix_allocator_t *strix_allocator_set(const strix_allocator_t *allocator)
+{
+    const strix_allocator_t *previous = strix_allocator_get();
+    allocator_installed = allocator;
+    return previous;
+}
+
+void allocator_scope_push(allocator_scope_t *scope)
+{
+    scope->outer = allocator_scope;
+    allocator_scope = scope;
+}
+
+void allocator_scope_pop(allocator_scope_t *scope)
+{
+    allocator_scope = scope->outer;
+}
@@ -0,0 +1,339 @@
+#include <stdint.h>
+
+#include "../header/strix_arena.h"
+#include "../allocator/allocator.h"
+
+#define STRIX_ARENA_ALIGNMENT (16)                 // enough for anything strix stores
+#define STRIX_ARENA_MAX_BLOCK_SIZE (16 * 1024 * 1024) // blocks stop doubling here
+
+typedef struct strix_arena_block
+{
+    struct strix_arena_block *next;
+    uint8_t *end;
+} strix_arena_block_t;
+
+struct strix_arena
+{
+    allocator_scope_t scope; // first member, the scope callbacks cast it back to the arena
+    strix_arena_block_t *first;
+    strix_arena_block_t *current; // blocks up to this one are in use, the ones after it are spare
+    uint8_t *top;
+    uint8_t *end;
+    uint8_t *last; // start of the latest allocation, which can be resized in place
+    size_t block_size; // size of the next block taken from the heap
+    const strix_allocator_t *allocator; // installed on the creating thread, serves the arena and its blocks
+    bool in_scope;
+};
+
+static inline size_t arena_align(size_t size)
+{
+    size = (size + STRIX_ARENA_ALIGNMENT - 1) & ~(size_t)(STRIX_ARENA_ALIGNMENT - 1);
+    return size ? size : STRIX_ARENA_ALIGNMENT; // zero sized requests still get a pointer of their own
+}
+
+static inline uint8_t *block_data(strix_arena_block_t *block)
+{
+    return (uint8_t *)(((uintptr_t)(block + 1) + STRIX_ARENA_ALIGNMENT - 1) & ~(uintptr_t)(STRIX_ARENA_ALIGNMENT - 1));
+}
+
+static strix_arena_block_t *arena_block_of(const strix_arena_t *arena, const void *ptr)
+{
+    if (!arena->current)
+    {
+        return NULL;
+    }
+
+    for (strix_arena_block_t *block = arena->first;; block = block->next)
+    {
+        if ((const uint8_t *)ptr >= block_data(block) && (const uint8_t *)ptr < block->end)
+        {
+            return block;
+        }
+        if (block == arena->current)
+        {
+            return NULL;
+        }
+    }
+}
+
+// moves on to the next spare block, or takes a new one from the heap, and allocates size bytes from it
+static void *arena_grow(strix_arena_t *arena, size_t size)
+{
+    strix_arena_block_t *block = arena->current ? arena->current->next : arena->first;
+    if (!block || (size_t)(block->end - block_data(block)) < size)
+    {
+        size_t block_size = arena->block_size;
+        while (block_size - sizeof(strix_arena_block_t) - STRIX_ARENA_ALIGNMENT < size)
+        {
+            if (block_size > SIZE_MAX / 2)
+            {
+                return NULL;
+            }
+            block_size *= 2;
+        }
+
+        block = (strix_arena_block_t *)allocate_with(arena->allocator, block_size);
+        if (!block)
+        {
+            return NULL;
+        }
+        block->end = (uint8_t *)block + block_size;
+
+        // the new block goes right after the current one, spare blocks too small for it stay behind it
+        if (arena->current)
+        {
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            block->next = arena->first;
+            arena->first = block;
+        }
+
+        if (arena->block_size < STRIX_ARENA_MAX_BLOCK_SIZE)
+        {
+            arena->block_size *= 2;
+        }
+    }
+
+    arena->current = block;
+    arena->top = block_data(block) + size;
+    arena->end = block->end;
+    arena->last = block_data(block);
+    return arena->last;
+}
+
+static inline void *arena_bump(strix_arena_t *arena, size_t size)
+{
+    if (size > SIZE_MAX - STRIX_ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+
+    size = arena_align(size);
+    if ((size_t)(arena->end - arena->top) < size)
+    {
+        return arena_grow(arena, size);
+    }
+
+    arena->last = arena->top;
+    arena->top += size;
+    return arena->last;
+}
+
+static void *arena_allocate(allocator_scope_t *scope, size_t size)
+{
+    return arena_bump((strix_arena_t *)scope, size);
+}
+
+static void *arena_reallocate(allocator_scope_t *scope, void *ptr, size_t size)
+{
+    strix_arena_t *arena = (strix_arena_t *)scope;
+
+    // the latest allocation grows and shrinks in place, which keeps repeated appends cheap
+    if ((uint8_t *)ptr == arena->last && size <= SIZE_MAX - STRIX_ARENA_ALIGNMENT &&
+        arena_align(size) <= (size_t)(arena->end - arena->last))
+    {
+        arena->top = arena->last + arena_align(size);
+        return ptr;
+    }
+
+    strix_arena_block_t *block = arena_block_of(arena, ptr);
+    void *new_ptr = arena_bump(arena, size);
+    if (new_ptr && block)
+    {
+        // the old size is not recorded, copying up to the end of its block is always in bounds
+        size_t available = (size_t)(block->end - (uint8_t *)ptr);
+        memmove(new_ptr, ptr, size < available ? size : available);
+    }
+    return new_ptr;
+}
+
+static bool arena_owns(const allocator_scope_t *scope, const void *ptr)
+{
+    return arena_block_of((const strix_arena_t *)scope, ptr) != NULL;
+}
+
+strix_arena_t *strix_arena_create(size_t block_size)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    strix_arena_t *arena = (strix_arena_t *)allocate_with(allocator_installed, sizeof(strix_arena_t));
+    if (!arena)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    arena->scope.allocate = arena_allocate;
+    arena->scope.reallocate = arena_reallocate;
+    arena->scope.owns = arena_owns;
+    arena->scope.outer = NULL;
+    arena->first = arena->current = NULL;
+    arena->top = arena->end = arena->last = NULL;
+    arena->block_size = block_size > sizeof(strix_arena_block_t) + STRIX_ARENA_ALIGNMENT ? block_size : STRIX_ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocator = allocator_installed;
+    arena->in_scope = false;
+    return arena;
+}
+
+void strix_arena_destroy(strix_arena_t *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+
+    // the scope leaves the chain of the thread wherever it sits, the scopes inside it then end into its outer one
+    for (allocator_scope_t **link = &allocator_scope; arena->in_scope && *link; link = &(*link)->outer)
+    {
+        if (*link == &arena->scope)
+        {
+            *link = arena->scope.outer;
+            break;
+        }
+    }
+
+    strix_arena_block_t *block = arena->first;
+    while (block)
+    {
+        strix_arena_block_t *next = block->next;
+        deallocate_with(arena->allocator, block);
+        block = next;
+    }
+    deallocate_with(arena->allocator, arena);
+}
+
+void strix_arena_reset(strix_arena_t *arena)
+{
+    if (!arena)
+    {
+        return;
+    }
+
+    arena->current = arena->first;
+    arena->top = arena->first ? block_data(arena->first) : NULL;
+    arena->end = arena->first ? arena->first->end : NULL;
+    arena->last = NULL;
+}
+
+bool strix_arena_scope_begin(strix_arena_t *arena)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!arena)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    if (arena->in_scope)
+    {
+        strix_errno = STRIX_ERR_ARENA_SCOPE;
+        return false;
+    }
+
+    arena->in_scope = true;
+    allocator_scope_push(&arena->scope);
+    return true;
+}
+
+bool strix_arena_scope_end(strix_arena_t *arena)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!arena)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    if (allocator_scope != &arena->scope)
+    {
+        strix_errno = STRIX_ERR_ARENA_SCOPE;
+        return false;
+    }
+
+    allocator_scope_pop(&arena->scope);
+    arena->in_scope = false;
+    return true;
+}
+
+void *strix_arena_alloc(strix_arena_t *arena, size_t size)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!arena)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    void *ptr = arena_bump(arena, size);
+    if (!ptr)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+    }
+    return ptr;
+}
+
+strix_t *strix_arena_promote(const strix_t *strix)
+{
+    allocator_scope_t *scope = allocator_scope;
+    allocator_scope = NULL;
+    strix_t *promoted = strix_duplicate(strix);
+    allocator_scope = scope;
+    return promoted;
+}
+
+strix_arr_t *strix_arena_promote_arr(const strix_arr_t *strix_arr)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    allocator_scope_t *scope = allocator_scope;
+    allocator_scope = NULL;
+
+    strix_arr_t *promoted = (strix_arr_t *)allocate(sizeof(strix_arr_t));
+    if (!promoted)
+    {
+        allocator_scope = scope;
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    promoted->len = 0;
+    promoted->strix_arr = (strix_t **)allocate(sizeof(strix_t *) * (strix_arr->len ? strix_arr->len : 1));
+    if (!promoted->strix_arr)
+    {
+        deallocate(promoted);
+        allocator_scope = scope;
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    for (; promoted->len < strix_arr->len; promoted->len++)
+    {
+        promoted->strix_arr[promoted->len] = strix_duplicate(strix_arr->strix_arr[promoted->len]);
+        if (!promoted->strix_arr[promoted->len])
+        {
+            strix_error_t error = strix_errno;
+            strix_free_strix_arr(promoted);
+            allocator_scope = scope;
+            strix_errno = error;
+            return NULL;
+        }
+    }
+
+    allocator_scope = scope;
+    return promoted;
+}
+
+#undef STRIX_ARENA_ALIGNMENT
+#undef STRIX_ARENA_MAX_BLOCK_SIZE
@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../header/strix_cpu.h"
+#include "kernels/kernels.h"
+
+const strix_kernels_t *strix_kernels = &strix_kernels_scalar; // until strix_cpu_bind runs
+
+static strix_isa_t bound_isa = STRIX_ISA_SCALAR;
+
+static const char *const isa_names[STRIX_ISA_COUNT] = {"scalar", "sse4.2", "avx2", "avx512"};
+
+static const strix_kernels_t *isa_kernels(strix_isa_t isa)
+{
+    switch (isa)
+    {
+#ifdef STRIX_KERNELS_X86
+    case STRIX_ISA_SSE42:
+        return &strix_kernels_sse42;
+    case STRIX_ISA_AVX2:
+        return &strix_kernels_avx2;
+    case STRIX_ISA_AVX512:
+        return &strix_kernels_avx512;
+#endif
+    default:
+        return &strix_kernels_scalar;
+    }
+}
+
+static strix_isa_t isa_from_name(const char *name)
+{
+    for (strix_isa_t isa = STRIX_ISA_SCALAR; isa < STRIX_ISA_COUNT; isa++)
+    {
+        if (strcmp(name, isa_names[isa]) == 0)
+        {
+            return isa;
+        }
+    }
+    return strcmp(name, "sse42") == 0 ? STRIX_ISA_SSE42 : STRIX_ISA_COUNT;
+}
+
+bool strix_cpu_supports(strix_isa_t isa)
+{
+    switch (isa)
+    {
+    case STRIX_ISA_SCALAR:
+        return true;
+#ifdef STRIX_KERNELS_X86
+    case STRIX_ISA_SSE42:
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    case STRIX_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case STRIX_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("popcnt");
+#endif
+    default:
+        return false;
+    }
+}
+
+strix_isa_t strix_cpu_isa(void)
+{
+    return bound_isa;
+}
+
+const char *strix_cpu_isa_name(strix_isa_t isa)
+{
+    return (unsigned)isa < STRIX_ISA_COUNT ? isa_names[isa] : "unknown";
+}
+
+// runs before main, strix functions called from other constructors before it run the scalar kernels
+__attribute__((constructor)) static void strix_cpu_bind(void)
+{
+#ifdef STRIX_KERNELS_X86
+    __builtin_cpu_init();
+#endif
+
+    strix_isa_t isa = STRIX_ISA_COUNT - 1;
+    const char *forced = getenv("STRIX_FORCE_ISA");
+    if (forced && isa_from_name(forced) < STRIX_ISA_COUNT)
+    {
+        isa = isa_from_name(forced);
+    }
+
+    while (isa > STRIX_ISA_SCALAR && !strix_cpu_supports(isa))
+    {
+        isa--;
+    }
+
+    bound_isa = isa;
+    strix_kernels = isa_kernels(isa);
+}
@@ -1,5 +1,27 @@
 #include "../header/strix_errno.h"
 
+_Thread_local strix_error_t strix_errno = STRIX_SUCCESS;
+
+// indexed by strix_error_t
+static const char *strix_error_messages[] = {
+    "Success",
+    "Null pointer argument",
+    "Memory allocation failed",
+    "Memory copy operation failed",
+    "Memory move operation failed",
+    "Invalid string length",
+    "Empty string where not allowed",
+    "Null string in the strix structure provided",
+    "Invalid strix string position provided",
+    "Out of bounds element access",
+    "Invalid bounds given for slicing",
+    "Invalid double value in the strix string",
+    "Invalid int value in the strix string",
+    "Integer in the strix string overflows 8 bytes",
+    "Invalid stride given",
+    "Error from the stdio library while doing operations on the given file\nSee thread local errno for more information on the error",
+    "Arena scope entered twice or left out of order"};
+
 void strix_perror(const char *prefix)
 {
     if (prefix && *prefix)
@@ -0,0 +1,593 @@
+#include <string.h>
+
+#include "../header/strix_hash.h"
+#include "kernels/kernels.h"
+#include "stats/stats.h"
+
+/*
+ * XXH3 of xxHash 0.8. Inputs up to 240 bytes take one of five short paths that read the default
+ * secret with the seed mixed in. Longer ones run 64 byte stripes through eight accumulators with a
+ * secret derived from the seed, scrambling them every 1 KiB, which is what the kernels vectorize.
+ */
+
+#define HASH_PRIME32_1 0x9E3779B1u
+#define HASH_PRIME32_2 0x85EBCA77u
+#define HASH_PRIME32_3 0xC2B2AE3Du
+#define HASH_PRIME64_1 0x9E3779B185EBCA87ull
+#define HASH_PRIME64_2 0xC2B2AE3D27D4EB4Full
+#define HASH_PRIME64_3 0x165667B19E3779F9ull
+#define HASH_PRIME64_4 0x85EBCA77C2B2AE63ull
+#define HASH_PRIME64_5 0x27D4EB2F165667C5ull
+#define HASH_PRIME_MX1 0x165667919E3779F9ull
+#define HASH_PRIME_MX2 0x9FB21C651E98DF25ull
+
+#define HASH_STRIPE_LEN (64)
+#define HASH_SECRET_CONSUME_RATE (8) // secret bytes skipped per stripe
+#define HASH_STRIPES_PER_BLOCK ((STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN) / HASH_SECRET_CONSUME_RATE)
+#define HASH_BLOCK_LEN (HASH_STRIPE_LEN * HASH_STRIPES_PER_BLOCK)
+#define HASH_SECRET_LASTACC_START (7)
+#define HASH_SECRET_MERGEACCS_START (11)
+#define HASH_SECRET_SIZE_MIN (136)
+#define HASH_MIDSIZE_MAX (240)
+#define HASH_MIDSIZE_STARTOFFSET (3)
+#define HASH_MIDSIZE_LASTOFFSET (17)
+
+static const uint8_t default_secret[STRIX_HASH_SECRET_SIZE] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+static const uint64_t initial_acc[8] = {HASH_PRIME32_3, HASH_PRIME64_1, HASH_PRIME64_2, HASH_PRIME64_3,
+                                        HASH_PRIME64_4, HASH_PRIME32_2, HASH_PRIME64_5, HASH_PRIME32_1};
+
+/* primitives */
+
+static inline uint32_t read32(const uint8_t *ptr)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline uint64_t read64(const uint8_t *ptr)
+{
+    uint64_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static inline void write64(uint8_t *ptr, uint64_t value)
+{
+    memcpy(ptr, &value, sizeof(value));
+}
+
+static inline uint64_t rotl64(uint64_t value, unsigned bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+static inline strix_hash128_t mul128(uint64_t lhs, uint64_t rhs)
+{
+    __uint128_t product = (__uint128_t)lhs * rhs;
+    return (strix_hash128_t){(uint64_t)product, (uint64_t)(product >> 64)};
+}
+
+static inline uint64_t mul128_fold64(uint64_t lhs, uint64_t rhs)
+{
+    strix_hash128_t product = mul128(lhs, rhs);
+    return product.low ^ product.high;
+}
+
+static inline uint64_t xxh64_avalanche(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= HASH_PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= HASH_PRIME64_3;
+    return hash ^ (hash >> 32);
+}
+
+static inline uint64_t avalanche(uint64_t hash)
+{
+    hash ^= hash >> 37;
+    hash *= HASH_PRIME_MX1;
+    return hash ^ (hash >> 32);
+}
+
+static inline uint64_t rrmxmx(uint64_t hash, uint64_t len)
+{
+    hash ^= rotl64(hash, 49) ^ rotl64(hash, 24);
+    hash *= HASH_PRIME_MX2;
+    hash ^= (hash >> 35) + len;
+    hash *= HASH_PRIME_MX2;
+    return hash ^ (hash >> 28);
+}
+
+static inline uint64_t mix16(const uint8_t *input, const uint8_t *secret, uint64_t seed)
+{
+    return mul128_fold64(read64(input) ^ (read64(secret) + seed), read64(input + 8) ^ (read64(secret + 8) - seed));
+}
+
+static inline strix_hash128_t mix32(strix_hash128_t acc, const uint8_t *input_one, const uint8_t *input_two,
+                                    const uint8_t *secret, uint64_t seed)
+{
+    acc.low += mix16(input_one, secret, seed);
+    acc.low ^= read64(input_two) + read64(input_two + 8);
+    acc.high += mix16(input_two, secret + 16, seed);
+    acc.high ^= read64(input_one) + read64(input_one + 8);
+    return acc;
+}
+
+/* inputs longer than HASH_MIDSIZE_MAX */
+
+static void derive_secret(uint8_t secret[STRIX_HASH_SECRET_SIZE], uint64_t seed)
+{
+    for (size_t i = 0; i < STRIX_HASH_SECRET_SIZE; i += 16)
+    {
+        write64(secret + i, read64(default_secret + i) + seed);
+        write64(secret + i + 8, read64(default_secret + i + 8) - seed);
+    }
+}
+
+static uint64_t merge_accs(const uint64_t acc[8], const uint8_t *secret, uint64_t start)
+{
+    uint64_t result = start;
+    for (size_t i = 0; i < 4; i++)
+    {
+        result += mul128_fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+    }
+    return avalanche(result);
+}
+
+static void hash_long(uint64_t acc[8], const uint8_t *input, size_t len, const uint8_t *secret)
+{
+    const strix_kernels_t *kernels = strix_kernels;
+    memcpy(acc, initial_acc, sizeof(initial_acc));
+
+    size_t blocks = (len - 1) / HASH_BLOCK_LEN;
+    for (size_t block = 0; block < blocks; block++)
+    {
+        kernels->hash_stripes(acc, input + block * HASH_BLOCK_LEN, secret, HASH_STRIPES_PER_BLOCK);
+        kernels->hash_scramble(acc, secret + STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN);
+    }
+
+    size_t stripes = ((len - 1) - blocks * HASH_BLOCK_LEN) / HASH_STRIPE_LEN;
+    kernels->hash_stripes(acc, input + blocks * HASH_BLOCK_LEN, secret, stripes);
+    kernels->hash_stripes(acc, input + len - HASH_STRIPE_LEN,
+                          secret + STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN - HASH_SECRET_LASTACC_START, 1);
+}
+
+static const uint8_t *long_secret(uint8_t custom[STRIX_HASH_SECRET_SIZE], uint64_t seed)
+{
+    if (!seed)
+    {
+        return default_secret;
+    }
+    derive_secret(custom, seed);
+    return custom;
+}
+
+static uint64_t finish_long64(const uint64_t acc[8], const uint8_t *secret, uint64_t len)
+{
+    return merge_accs(acc, secret + HASH_SECRET_MERGEACCS_START, len * HASH_PRIME64_1);
+}
+
+static strix_hash128_t finish_long128(const uint64_t acc[8], const uint8_t *secret, uint64_t len)
+{
+    return (strix_hash128_t){
+        merge_accs(acc, secret + HASH_SECRET_MERGEACCS_START, len * HASH_PRIME64_1),
+        merge_accs(acc, secret + STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN - HASH_SECRET_MERGEACCS_START,
+                   ~(len * HASH_PRIME64_2)),
+    };
+}
+
+/* 64 bit */
+
+static uint64_t hash64_short(const uint8_t *input, size_t len, uint64_t seed)
+{
+    const uint8_t *secret = default_secret;
+
+    if (len > 16)
+    {
+        uint64_t acc = len * HASH_PRIME64_1;
+        if (len > 128)
+        {
+            size_t rounds = len / 16;
+            for (size_t i = 0; i < 8; i++)
+            {
+                acc += mix16(input + 16 * i, secret + 16 * i, seed);
+            }
+            acc = avalanche(acc);
+
+            uint64_t acc_end = mix16(input + len - 16, secret + HASH_SECRET_SIZE_MIN - HASH_MIDSIZE_LASTOFFSET, seed);
+            for (size_t i = 8; i < rounds; i++)
+            {
+                acc_end += mix16(input + 16 * i, secret + 16 * (i - 8) + HASH_MIDSIZE_STARTOFFSET, seed);
+            }
+            return avalanche(acc + acc_end);
+        }
+
+        if (len > 32)
+        {
+            if (len > 64)
+            {
+                if (len > 96)
+                {
+                    acc += mix16(input + 48, secret + 96, seed);
+                    acc += mix16(input + len - 64, secret + 112, seed);
+                }
+                acc += mix16(input + 32, secret + 64, seed);
+                acc += mix16(input + len - 48, secret + 80, seed);
+            }
+            acc += mix16(input + 16, secret + 32, seed);
+            acc += mix16(input + len - 32, secret + 48, seed);
+        }
+        acc += mix16(input, secret, seed);
+        acc += mix16(input + len - 16, secret + 16, seed);
+        return avalanche(acc);
+    }
+
+    if (len > 8)
+    {
+        uint64_t low = read64(input) ^ ((read64(secret + 24) ^ read64(secret + 32)) + seed);
+        uint64_t high = read64(input + len - 8) ^ ((read64(secret + 40) ^ read64(secret + 48)) - seed);
+        return avalanche(len + __builtin_bswap64(low) + high + mul128_fold64(low, high));
+    }
+
+    if (len >= 4)
+    {
+        seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+        uint64_t value = read32(input + len - 4) + ((uint64_t)read32(input) << 32);
+        return rrmxmx(value ^ ((read64(secret + 8) ^ read64(secret + 16)) - seed), len);
+    }
+
+    if (len)
+    {
+        uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | input[len - 1] | ((uint32_t)len << 8);
+        return xxh64_avalanche(combined ^ ((uint64_t)(read32(secret) ^ read32(secret + 4)) + seed));
+    }
+
+    return xxh64_avalanche(seed ^ read64(secret + 56) ^ read64(secret + 64));
+}
+
+static uint64_t hash64(const uint8_t *input, size_t len, uint64_t seed)
+{
+    if (len <= HASH_MIDSIZE_MAX)
+    {
+        return hash64_short(input, len, seed);
+    }
+
+    uint8_t custom[STRIX_HASH_SECRET_SIZE];
+    const uint8_t *secret = long_secret(custom, seed);
+    uint64_t acc[8];
+    hash_long(acc, input, len, secret);
+    return finish_long64(acc, secret, len);
+}
+
+/* 128 bit */
+
+static strix_hash128_t hash128_short(const uint8_t *input, size_t len, uint64_t seed)
+{
+    const uint8_t *secret = default_secret;
+
+    if (len > 128)
+    {
+        strix_hash128_t acc = {len * HASH_PRIME64_1, 0};
+        for (size_t i = 0; i < 4; i++)
+        {
+            acc = mix32(acc, input + 32 * i, input + 32 * i + 16, secret + 32 * i, seed);
+        }
+        acc.low = avalanche(acc.low);
+        acc.high = avalanche(acc.high);
+
+        for (size_t i = 4; i < len / 32; i++)
+        {
+            acc = mix32(acc, input + 32 * i, input + 32 * i + 16, secret + HASH_MIDSIZE_STARTOFFSET + 32 * (i - 4), seed);
+        }
+        acc = mix32(acc, input + len - 16, input + len - 32,
+                    secret + HASH_SECRET_SIZE_MIN - HASH_MIDSIZE_LASTOFFSET - 16, 0 - seed);
+
+        uint64_t low = acc.low + acc.high;
+        uint64_t high = acc.low * HASH_PRIME64_1 + acc.high * HASH_PRIME64_4 + (len - seed) * HASH_PRIME64_2;
+        return (strix_hash128_t){avalanche(low), 0 - avalanche(high)};
+    }
+
+    if (len > 16)
+    {
+        strix_hash128_t acc = {len * HASH_PRIME64_1, 0};
+        if (len > 32)
+        {
+            if (len > 64)
+            {
+                if (len > 96)
+                {
+                    acc = mix32(acc, input + 48, input + len - 64, secret + 96, seed);
+                }
+                acc = mix32(acc, input + 32, input + len - 48, secret + 64, seed);
+            }
+            acc = mix32(acc, input + 16, input + len - 32, secret + 32, seed);
+        }
+        acc = mix32(acc, input, input + len - 16, secret, seed);
+
+        uint64_t low = acc.low + acc.high;
+        uint64_t high = acc.low * HASH_PRIME64_1 + acc.high * HASH_PRIME64_4 + (len - seed) * HASH_PRIME64_2;
+        return (strix_hash128_t){avalanche(low), 0 - avalanche(high)};
+    }
+
+    if (len > 8)
+    {
+        uint64_t flip_low = (read64(secret + 32) ^ read64(secret + 40)) - seed;
+        uint64_t flip_high = (read64(secret + 48) ^ read64(secret + 56)) + seed;
+        uint64_t input_low = read64(input);
+        uint64_t input_high = read64(input + len - 8) ^ flip_high;
+
+        strix_hash128_t mixed = mul128(input_low ^ read64(input + len - 8) ^ flip_low, HASH_PRIME64_1);
+        mixed.low += (uint64_t)(len - 1) << 54;
+        mixed.high += input_high + (uint64_t)(uint32_t)input_high * (HASH_PRIME32_2 - 1);
+        mixed.low ^= __builtin_bswap64(mixed.high);
+
+        strix_hash128_t hash = mul128(mixed.low, HASH_PRIME64_2);
+        hash.high += mixed.high * HASH_PRIME64_2;
+        return (strix_hash128_t){avalanche(hash.low), avalanche(hash.high)};
+    }
+
+    if (len >= 4)
+    {
+        seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+        uint64_t value = read32(input) + ((uint64_t)read32(input + len - 4) << 32);
+        uint64_t keyed = value ^ ((read64(secret + 16) ^ read64(secret + 24)) + seed);
+
+        strix_hash128_t mixed = mul128(keyed, HASH_PRIME64_1 + (len << 2));
+        mixed.high += mixed.low << 1;
+        mixed.low ^= mixed.high >> 3;
+        mixed.low ^= mixed.low >> 35;
+        mixed.low *= HASH_PRIME_MX2;
+        mixed.low ^= mixed.low >> 28;
+        return (strix_hash128_t){mixed.low, avalanche(mixed.high)};
+    }
+
+    if (len)
+    {
+        uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | input[len - 1] | ((uint32_t)len << 8);
+        uint32_t swapped = __builtin_bswap32(combined);
+        uint32_t combined_high = (swapped << 13) | (swapped >> 19);
+        uint64_t flip_low = (uint64_t)(read32(secret) ^ read32(secret + 4)) + seed;
+        uint64_t flip_high = (uint64_t)(read32(secret + 8) ^ read32(secret + 12)) - seed;
+        return (strix_hash128_t){xxh64_avalanche(combined ^ flip_low), xxh64_avalanche(combined_high ^ flip_high)};
+    }
+
+    return (strix_hash128_t){xxh64_avalanche(seed ^ read64(secret + 64) ^ read64(secret + 72)),
+                             xxh64_avalanche(seed ^ read64(secret + 80) ^ read64(secret + 88))};
+}
+
+static strix_hash128_t hash128(const uint8_t *input, size_t len, uint64_t seed)
+{
+    if (len <= HASH_MIDSIZE_MAX)
+    {
+        return hash128_short(input, len, seed);
+    }
+
+    uint8_t custom[STRIX_HASH_SECRET_SIZE];
+    const uint8_t *secret = long_secret(custom, seed);
+    uint64_t acc[8];
+    hash_long(acc, input, len, secret);
+    return finish_long128(acc, secret, len);
+}
+
+/* one shot */
+
+uint64_t strix_hash64(const strix_t *strix, uint64_t seed)
+{
+    STRIX_STATS_OP(STRIX_OP_HASH64, STRIX_STATS_LEN(strix));
+
+    if (!strix)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+    return hash64((const uint8_t *)strix->str, strix->len, seed);
+}
+
+strix_hash128_t strix_hash128(const strix_t *strix, uint64_t seed)
+{
+    STRIX_STATS_OP(STRIX_OP_HASH128, STRIX_STATS_LEN(strix));
+
+    if (!strix)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return (strix_hash128_t){0, 0};
+    }
+    return hash128((const uint8_t *)strix->str, strix->len, seed);
+}
+
+uint64_t strix_hash64_bytes(const void *data, size_t len, uint64_t seed)
+{
+    if (!data && len)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+    return hash64((const uint8_t *)data, len, seed);
+}
+
+strix_hash128_t strix_hash128_bytes(const void *data, size_t len, uint64_t seed)
+{
+    if (!data && len)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return (strix_hash128_t){0, 0};
+    }
+    return hash128((const uint8_t *)data, len, seed);
+}
+
+/* streaming */
+
+bool strix_hash_init(strix_hash_state_t *state, uint64_t seed)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!state)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    memcpy(state->acc, initial_acc, sizeof(initial_acc));
+    derive_secret(state->secret, seed);
+    state->buffered = 0;
+    state->stripes = 0;
+    state->total_len = 0;
+    state->seed = seed;
+    return true;
+}
+
+// hashes whole stripes, scrambling whenever a block of them is complete
+static const uint8_t *consume_stripes(uint64_t acc[8], size_t *stripes_so_far, const uint8_t *input, size_t stripes,
+                                      const uint8_t *secret)
+{
+    const strix_kernels_t *kernels = strix_kernels;
+    while (stripes)
+    {
+        size_t count = HASH_STRIPES_PER_BLOCK - *stripes_so_far;
+        count = stripes < count ? stripes : count;
+
+        kernels->hash_stripes(acc, input, secret + *stripes_so_far * HASH_SECRET_CONSUME_RATE, count);
+        input += count * HASH_STRIPE_LEN;
+        stripes -= count;
+        *stripes_so_far += count;
+
+        if (*stripes_so_far == HASH_STRIPES_PER_BLOCK)
+        {
+            kernels->hash_scramble(acc, secret + STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN);
+            *stripes_so_far = 0;
+        }
+    }
+    return input;
+}
+
+bool strix_hash_update(strix_hash_state_t *state, const void *data, size_t len)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!state || (!data && len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    const uint8_t *input = (const uint8_t *)data;
+    const uint8_t *end = input + len;
+    state->total_len += len;
+
+    // the buffer is only hashed once more input arrives, so the digest always has a last stripe
+    if (len <= STRIX_HASH_BUFFER_SIZE - state->buffered)
+    {
+        if (len)
+        {
+            memcpy(state->buffer + state->buffered, input, len);
+        }
+        state->buffered += len;
+        return true;
+    }
+
+    if (state->buffered)
+    {
+        size_t fill = STRIX_HASH_BUFFER_SIZE - state->buffered;
+        memcpy(state->buffer + state->buffered, input, fill);
+        input += fill;
+        consume_stripes(state->acc, &state->stripes, state->buffer, STRIX_HASH_BUFFER_SIZE / HASH_STRIPE_LEN,
+                        state->secret);
+        state->buffered = 0;
+    }
+
+    if ((size_t)(end - input) > STRIX_HASH_BUFFER_SIZE)
+    {
+        input = consume_stripes(state->acc, &state->stripes, input, (size_t)(end - 1 - input) / HASH_STRIPE_LEN,
+                                state->secret);
+        // the digest of a short tail reaches back into the last stripe hashed
+        memcpy(state->buffer + STRIX_HASH_BUFFER_SIZE - HASH_STRIPE_LEN, input - HASH_STRIPE_LEN, HASH_STRIPE_LEN);
+    }
+
+    memcpy(state->buffer, input, (size_t)(end - input));
+    state->buffered = (size_t)(end - input);
+    return true;
+}
+
+bool strix_hash_update_strix(strix_hash_state_t *state, const strix_t *strix)
+{
+    if (!strix)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+    return strix_hash_update(state, strix->str, strix->len);
+}
+
+// accumulators of everything fed to a state of more than HASH_MIDSIZE_MAX bytes
+static void digest_long(const strix_hash_state_t *state, uint64_t acc[8])
+{
+    memcpy(acc, state->acc, sizeof(state->acc));
+
+    uint8_t last_stripe[HASH_STRIPE_LEN];
+    const uint8_t *last = last_stripe;
+    if (state->buffered >= HASH_STRIPE_LEN)
+    {
+        size_t stripes_so_far = state->stripes;
+        consume_stripes(acc, &stripes_so_far, state->buffer, (state->buffered - 1) / HASH_STRIPE_LEN, state->secret);
+        last = state->buffer + state->buffered - HASH_STRIPE_LEN;
+    }
+    else
+    {
+        size_t catchup = HASH_STRIPE_LEN - state->buffered;
+        memcpy(last_stripe, state->buffer + STRIX_HASH_BUFFER_SIZE - catchup, catchup);
+        memcpy(last_stripe + catchup, state->buffer, state->buffered);
+    }
+
+    strix_kernels->hash_stripes(acc, last, state->secret + STRIX_HASH_SECRET_SIZE - HASH_STRIPE_LEN - HASH_SECRET_LASTACC_START, 1);
+}
+
+uint64_t strix_hash_digest64(const strix_hash_state_t *state)
+{
+    if (!state)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+
+    if (state->total_len <= HASH_MIDSIZE_MAX)
+    {
+        return hash64_short(state->buffer, (size_t)state->total_len, state->seed);
+    }
+
+    uint64_t acc[8];
+    digest_long(state, acc);
+    return finish_long64(acc, state->secret, state->total_len);
+}
+
+strix_hash128_t strix_hash_digest128(const strix_hash_state_t *state)
+{
+    if (!state)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return (strix_hash128_t){0, 0};
+    }
+
+    if (state->total_len <= HASH_MIDSIZE_MAX)
+    {
+        return hash128_short(state->buffer, (size_t)state->total_len, state->seed);
+    }
+
+    uint64_t acc[8];
+    digest_long(state, acc);
+    return finish_long128(acc, state->secret, state->total_len);
+}
@@ -0,0 +1,303 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "../header/strix_intern.h"
+#include "../header/strix_arena.h"
+#include "../header/strix_hash.h"
+#include "../allocator/allocator.h"
+#include "stats/stats.h"
+
+/*
+ * The pool is a linear probing table of pointers to entries, kept at most half full. Slots go from
+ * NULL to an entry exactly once and entries never move, so readers probe without the lock: a
+ * release store publishes each entry after its bytes are written. Growing builds a new table and
+ * publishes it the same way, the old one stays readable in the arena until the pool is destroyed.
+ * A reader that misses on a table being replaced takes the lock and looks again.
+ */
+
+#define STRIX_INTERN_MIN_SLOTS (64)
+
+typedef struct
+{
+    uint64_t hash;
+    strix_t strix; // the canonical string, its bytes follow the entry
+} intern_entry_t;
+
+typedef struct
+{
+    size_t mask;
+    intern_entry_t *slots[];
+} intern_table_t;
+
+struct strix_intern_pool
+{
+    intern_table_t *table; // the newest table, read without the lock
+    size_t size;
+    uint64_t seed;
+    strix_arena_t *arena;  // entries and every table the pool has had
+    const strix_allocator_t *allocator; // installed on the creating thread, the arena records it too
+    pthread_mutex_t lock;  // held while adding strings
+};
+
+static intern_entry_t *intern_probe(const intern_table_t *table, const char *str, size_t len, uint64_t hash)
+{
+    for (size_t i = (size_t)hash & table->mask;; i = (i + 1) & table->mask)
+    {
+        intern_entry_t *entry = __atomic_load_n(&table->slots[i], __ATOMIC_ACQUIRE);
+        if (!entry)
+        {
+            return NULL;
+        }
+        if (entry->hash == hash && entry->strix.len == len && (len == 0 || memcmp(entry->strix.str, str, len) == 0))
+        {
+            return entry;
+        }
+    }
+}
+
+static void intern_place(intern_table_t *table, intern_entry_t *entry)
+{
+    size_t i = (size_t)entry->hash & table->mask;
+    while (table->slots[i])
+    {
+        i = (i + 1) & table->mask;
+    }
+    __atomic_store_n(&table->slots[i], entry, __ATOMIC_RELEASE);
+}
+
+static intern_table_t *intern_table_new(strix_arena_t *arena, size_t slots)
+{
+    if (slots > (SIZE_MAX - sizeof(intern_table_t)) / sizeof(intern_entry_t *))
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    intern_table_t *table = (intern_table_t *)strix_arena_alloc(arena, sizeof(intern_table_t) + slots * sizeof(intern_entry_t *));
+    if (!table)
+    {
+        return NULL;
+    }
+
+    table->mask = slots - 1;
+    memset(table->slots, 0, slots * sizeof(intern_entry_t *));
+    return table;
+}
+
+// called with the lock held
+static intern_table_t *intern_grow(strix_intern_pool_t *pool)
+{
+    intern_table_t *old = pool->table;
+    intern_table_t *table = intern_table_new(pool->arena, (old->mask + 1) * 2);
+    if (!table)
+    {
+        return NULL;
+    }
+
+    for (size_t i = 0; i <= old->mask; i++)
+    {
+        if (old->slots[i])
+        {
+            intern_place(table, old->slots[i]);
+        }
+    }
+
+    __atomic_store_n(&pool->table, table, __ATOMIC_RELEASE);
+    return table;
+}
+
+static const strix_t *intern_add(strix_intern_pool_t *pool, const char *str, size_t len, uint64_t hash)
+{
+    pthread_mutex_lock(&pool->lock);
+
+    intern_table_t *table = pool->table;
+    intern_entry_t *entry = intern_probe(table, str, len, hash);
+    if (entry)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return &entry->strix;
+    }
+
+    if ((pool->size + 1) * 2 > table->mask + 1)
+    {
+        table = intern_grow(pool);
+    }
+
+    entry = table && len <= SIZE_MAX - sizeof(intern_entry_t) ? (intern_entry_t *)strix_arena_alloc(pool->arena, sizeof(intern_entry_t) + len) : NULL;
+    if (!entry)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->strix.str = (char *)(entry + 1);
+    entry->strix.len = len;
+    if (len)
+    {
+        memcpy(entry->strix.str, str, len);
+    }
+
+    intern_place(table, entry);
+    __atomic_store_n(&pool->size, pool->size + 1, __ATOMIC_RELAXED);
+
+    pthread_mutex_unlock(&pool->lock);
+    return &entry->strix;
+}
+
+strix_intern_pool_t *strix_intern_pool_create(void)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    strix_intern_pool_t *pool = (strix_intern_pool_t *)allocate_with(allocator_installed, sizeof(strix_intern_pool_t));
+    if (!pool)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    pool->allocator = allocator_installed;
+    pool->arena = strix_arena_create(0);
+    pool->table = pool->arena ? intern_table_new(pool->arena, STRIX_INTERN_MIN_SLOTS) : NULL;
+    if (!pool->table)
+    {
+        strix_arena_destroy(pool->arena);
+        deallocate_with(pool->allocator, pool);
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    pool->size = 0;
+    pool->seed = (uint64_t)(uintptr_t)pool * 0x9E3779B97F4A7C15ull;
+    pthread_mutex_init(&pool->lock, NULL);
+    return pool;
+}
+
+void strix_intern_pool_destroy(strix_intern_pool_t *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    strix_arena_destroy(pool->arena);
+    deallocate_with(pool->allocator, pool);
+}
+
+size_t strix_intern_pool_size(const strix_intern_pool_t *pool)
+{
+    return pool ? __atomic_load_n(&pool->size, __ATOMIC_RELAXED) : 0;
+}
+
+const strix_t *strix_intern_bytes(strix_intern_pool_t *pool, const char *str, size_t len)
+{
+    STRIX_STATS_OP(STRIX_OP_INTERN, len);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!pool || (!str && len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    uint64_t hash = strix_hash64_bytes(str, len, pool->seed);
+    intern_entry_t *entry = intern_probe(__atomic_load_n(&pool->table, __ATOMIC_ACQUIRE), str, len, hash);
+    return entry ? &entry->strix : intern_add(pool, str, len, hash);
+}
+
+const strix_t *strix_intern(strix_intern_pool_t *pool, const strix_t *strix)
+{
+    if (!strix)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+    return strix_intern_bytes(pool, strix->str, strix->len);
+}
+
+const strix_t *strix_intern_cstr(strix_intern_pool_t *pool, const char *str)
+{
+    if (!str)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+    return strix_intern_bytes(pool, str, strlen(str));
+}
+
+const strix_t *strix_intern_find(const strix_intern_pool_t *pool, const strix_t *strix)
+{
+    STRIX_STATS_OP(STRIX_OP_INTERN_FIND, STRIX_STATS_LEN(strix));
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!pool || !strix || (!strix->str && strix->len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    uint64_t hash = strix_hash64_bytes(strix->str, strix->len, pool->seed);
+    intern_entry_t *entry = intern_probe(__atomic_load_n(&pool->table, __ATOMIC_ACQUIRE), strix->str, strix->len, hash);
+    return entry ? &entry->strix : NULL;
+}
+
+bool strix_intern_arr(strix_intern_pool_t *pool, strix_arr_t *strix_arr)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!pool || !strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    // everything is interned before the first string is freed, so a failure leaves the array whole
+    const strix_t **canonical = (const strix_t **)unscoped_allocate(sizeof(strix_t *) * (strix_arr->len ? strix_arr->len : 1));
+    if (!canonical)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return false;
+    }
+
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        canonical[i] = strix_intern(pool, strix_arr->strix_arr[i]);
+        if (!canonical[i])
+        {
+            strix_error_t error = strix_errno;
+            unscoped_deallocate(canonical);
+            strix_errno = error;
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        if (strix_arr->strix_arr[i] != canonical[i])
+        {
+            strix_free(strix_arr->strix_arr[i]);
+            strix_arr->strix_arr[i] = (strix_t *)canonical[i];
+        }
+    }
+
+    unscoped_deallocate(canonical);
+    return true;
+}
+
+void strix_free_interned_arr(strix_arr_t *strix_arr)
+{
+    if (!strix_arr)
+    {
+        return;
+    }
+
+    deallocate(strix_arr->strix_arr);
+    deallocate(strix_arr);
+}
+
+#undef STRIX_INTERN_MIN_SLOTS
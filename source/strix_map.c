@@ -0,0 +1,572 @@
+#include <stdint.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../header/strix_map.h"
+#include "../header/strix_hash.h"
+#include "../allocator/allocator.h"
+#include "stats/stats.h"
+
+/*
+ * Slots are found through their control bytes: STRIX_MAP_EMPTY, STRIX_MAP_DELETED, or the low 7
+ * bits of the hash of the key when full. The rest of the hash picks the group of 16 control bytes
+ * a lookup starts at, further groups are visited at growing strides until a group with an empty
+ * byte shows the key is missing. The control bytes are followed by a copy of the first group, so a
+ * group starting anywhere in the table is read with one unaligned load.
+ */
+
+#define STRIX_MAP_GROUP (16)               // control bytes matched at once
+#define STRIX_MAP_EMPTY ((uint8_t)0x80)    // never used since the last clear, ends lookups
+#define STRIX_MAP_DELETED ((uint8_t)0xFE)  // removed, lookups go on past it
+#define STRIX_MAP_MIN_CAPACITY (16)
+#define STRIX_MAP_PREFETCH (8)             // strings hashed ahead of their insertion by strix_map_add_arr
+
+typedef struct
+{
+    const char *key;
+    size_t len;
+    uint64_t hash;
+    uint64_t value;
+} strix_map_slot_t;
+
+struct strix_map
+{
+    strix_map_slot_t *slots; // the control bytes are allocated right after the slots
+    uint8_t *ctrl;
+    size_t capacity;    // a power of two, 0 until the first insertion
+    size_t size;
+    size_t growth_left; // insertions into empty slots before the table grows, keeps it at most 7/8 full
+    uint64_t seed;
+    strix_arena_t *key_arena;
+};
+
+/* control bytes */
+
+#ifdef __SSE2__
+
+static inline uint32_t map_match_byte(const uint8_t *group, uint8_t byte)
+{
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+}
+
+// empty and deleted are the only control bytes with the top bit set
+static inline uint32_t map_match_free(const uint8_t *group)
+{
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group));
+}
+
+#else
+
+static inline uint32_t map_match_byte(const uint8_t *group, uint8_t byte)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < STRIX_MAP_GROUP; i++)
+    {
+        mask |= (uint32_t)(group[i] == byte) << i;
+    }
+    return mask;
+}
+
+static inline uint32_t map_match_free(const uint8_t *group)
+{
+    uint32_t mask = 0;
+    for (int i = 0; i < STRIX_MAP_GROUP; i++)
+    {
+        mask |= (uint32_t)(group[i] >> 7) << i;
+    }
+    return mask;
+}
+
+#endif
+
+static inline uint8_t map_h2(uint64_t hash)
+{
+    return (uint8_t)(hash & 0x7F);
+}
+
+static inline size_t map_h1(uint64_t hash, size_t mask)
+{
+    return (size_t)(hash >> 7) & mask;
+}
+
+static inline bool map_is_full(uint8_t ctrl)
+{
+    return ctrl < STRIX_MAP_EMPTY;
+}
+
+static inline void map_set_ctrl(uint8_t *ctrl, size_t capacity, size_t index, uint8_t byte)
+{
+    ctrl[index] = byte;
+    if (index < STRIX_MAP_GROUP)
+    {
+        ctrl[capacity + index] = byte;
+    }
+}
+
+static inline size_t map_max_load(size_t capacity)
+{
+    return capacity - capacity / 8;
+}
+
+/* probing */
+
+// the strides grow by one group each step, which visits every group of a power of two table
+static strix_map_slot_t *map_lookup(const strix_map_t *map, const char *key, size_t len, uint64_t hash)
+{
+    if (!map->capacity)
+    {
+        return NULL;
+    }
+
+    const size_t mask = map->capacity - 1;
+    const uint8_t h2 = map_h2(hash);
+    size_t pos = map_h1(hash, mask);
+    for (size_t stride = STRIX_MAP_GROUP;; stride += STRIX_MAP_GROUP)
+    {
+        const uint8_t *group = map->ctrl + pos;
+        for (uint32_t match = map_match_byte(group, h2); match; match &= match - 1)
+        {
+            strix_map_slot_t *slot = &map->slots[(pos + __builtin_ctz(match)) & mask];
+            if (slot->hash == hash && slot->len == len && (len == 0 || memcmp(slot->key, key, len) == 0))
+            {
+                return slot;
+            }
+        }
+
+        if (map_match_byte(group, STRIX_MAP_EMPTY))
+        {
+            return NULL;
+        }
+        pos = (pos + stride) & mask;
+    }
+}
+
+// the first empty or deleted slot on the probe sequence of hash, there is always an empty one
+static size_t map_find_free(const uint8_t *ctrl, size_t capacity, uint64_t hash)
+{
+    const size_t mask = capacity - 1;
+    size_t pos = map_h1(hash, mask);
+    for (size_t stride = STRIX_MAP_GROUP;; stride += STRIX_MAP_GROUP)
+    {
+        uint32_t match = map_match_free(ctrl + pos);
+        if (match)
+        {
+            return (pos + __builtin_ctz(match)) & mask;
+        }
+        pos = (pos + stride) & mask;
+    }
+}
+
+// moves every key into a new table, the stored hashes make this a pure copy
+static bool map_resize(strix_map_t *map, size_t capacity)
+{
+    if (capacity > (SIZE_MAX - STRIX_MAP_GROUP) / (sizeof(strix_map_slot_t) + 1))
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return false;
+    }
+
+    strix_map_slot_t *slots = (strix_map_slot_t *)unscoped_allocate(capacity * (sizeof(strix_map_slot_t) + 1) + STRIX_MAP_GROUP);
+    if (!slots)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return false;
+    }
+
+    uint8_t *ctrl = (uint8_t *)(slots + capacity);
+    memset(ctrl, STRIX_MAP_EMPTY, capacity + STRIX_MAP_GROUP);
+
+    for (size_t i = 0; i < map->capacity; i++)
+    {
+        if (map_is_full(map->ctrl[i]))
+        {
+            size_t index = map_find_free(ctrl, capacity, map->slots[i].hash);
+            map_set_ctrl(ctrl, capacity, index, map->ctrl[i]);
+            slots[index] = map->slots[i];
+        }
+    }
+
+    unscoped_deallocate(map->slots);
+    map->slots = slots;
+    map->ctrl = ctrl;
+    map->capacity = capacity;
+    map->growth_left = map_max_load(capacity) - map->size;
+    return true;
+}
+
+static size_t map_capacity_for(size_t count)
+{
+    size_t capacity = STRIX_MAP_MIN_CAPACITY;
+    while (map_max_load(capacity) < count && capacity <= SIZE_MAX / 4)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// doubles the table, or rebuilds it at its size when deleted slots rather than keys used it up
+static bool map_grow(strix_map_t *map)
+{
+    if (!map->capacity)
+    {
+        return map_resize(map, STRIX_MAP_MIN_CAPACITY);
+    }
+    if (map->size < map_max_load(map->capacity) / 2)
+    {
+        return map_resize(map, map->capacity);
+    }
+    if (map->capacity > SIZE_MAX / 4)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return false;
+    }
+    return map_resize(map, map->capacity * 2);
+}
+
+static strix_map_slot_t *map_insert(strix_map_t *map, const char *key, size_t len, uint64_t hash, bool *inserted)
+{
+    strix_map_slot_t *slot = map_lookup(map, key, len, hash);
+    if (slot)
+    {
+        *inserted = false;
+        return slot;
+    }
+
+    size_t index = map->capacity ? map_find_free(map->ctrl, map->capacity, hash) : 0;
+    if (!map->capacity || (map->growth_left == 0 && map->ctrl[index] == STRIX_MAP_EMPTY))
+    {
+        if (!map_grow(map))
+        {
+            return NULL;
+        }
+        index = map_find_free(map->ctrl, map->capacity, hash);
+    }
+
+    if (map->key_arena && len)
+    {
+        char *copy = (char *)strix_arena_alloc(map->key_arena, len);
+        if (!copy)
+        {
+            return NULL;
+        }
+        memcpy(copy, key, len);
+        key = copy;
+    }
+
+    map->growth_left -= map->ctrl[index] == STRIX_MAP_EMPTY;
+    map_set_ctrl(map->ctrl, map->capacity, index, map_h2(hash));
+    map->size++;
+
+    slot = &map->slots[index];
+    slot->key = key;
+    slot->len = len;
+    slot->hash = hash;
+    slot->value = 0;
+    *inserted = true;
+    return slot;
+}
+
+/* public API */
+
+strix_map_t *strix_map_create(size_t capacity, strix_arena_t *key_arena)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    strix_map_t *map = (strix_map_t *)unscoped_allocate(sizeof(strix_map_t));
+    if (!map)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    map->slots = NULL;
+    map->ctrl = NULL;
+    map->capacity = 0;
+    map->size = 0;
+    map->growth_left = 0;
+    // iterating one map while inserting into another lays keys down in hash order, which with a
+    // shared seed would pack them into long runs of full groups
+    map->seed = (uint64_t)(uintptr_t)map * 0x9E3779B97F4A7C15ull;
+    map->key_arena = key_arena;
+
+    if (capacity && !map_resize(map, map_capacity_for(capacity)))
+    {
+        unscoped_deallocate(map);
+        return NULL;
+    }
+    return map;
+}
+
+void strix_map_destroy(strix_map_t *map)
+{
+    if (!map)
+    {
+        return;
+    }
+
+    unscoped_deallocate(map->slots);
+    unscoped_deallocate(map);
+}
+
+void strix_map_clear(strix_map_t *map)
+{
+    if (!map || !map->capacity)
+    {
+        return;
+    }
+
+    memset(map->ctrl, STRIX_MAP_EMPTY, map->capacity + STRIX_MAP_GROUP);
+    map->size = 0;
+    map->growth_left = map_max_load(map->capacity);
+}
+
+size_t strix_map_size(const strix_map_t *map)
+{
+    return map ? map->size : 0;
+}
+
+bool strix_map_reserve(strix_map_t *map, size_t count)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!map)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    if (count <= map->size || count - map->size <= map->growth_left)
+    {
+        return true;
+    }
+
+    size_t capacity = map_capacity_for(count);
+    if (map_max_load(capacity) < count)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return false;
+    }
+    return map_resize(map, capacity > map->capacity ? capacity : map->capacity);
+}
+
+uint64_t *strix_map_upsert_bytes(strix_map_t *map, const char *key, size_t len, bool *inserted)
+{
+    STRIX_STATS_OP(STRIX_OP_MAP_UPSERT, len);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!map || (!key && len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    bool was_inserted;
+    strix_map_slot_t *slot = map_insert(map, key, len, strix_hash64_bytes(key, len, map->seed), &was_inserted);
+    if (!slot)
+    {
+        return NULL;
+    }
+
+    if (inserted)
+    {
+        *inserted = was_inserted;
+    }
+    return &slot->value;
+}
+
+uint64_t *strix_map_upsert(strix_map_t *map, const strix_t *key, bool *inserted)
+{
+    if (!key)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+    return strix_map_upsert_bytes(map, key->str, key->len, inserted);
+}
+
+bool strix_map_put(strix_map_t *map, const strix_t *key, uint64_t value)
+{
+    uint64_t *slot = strix_map_upsert(map, key, NULL);
+    if (!slot)
+    {
+        return false;
+    }
+
+    *slot = value;
+    return true;
+}
+
+uint64_t *strix_map_find_bytes(const strix_map_t *map, const char *key, size_t len)
+{
+    STRIX_STATS_OP(STRIX_OP_MAP_FIND, len);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!map || (!key && len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    strix_map_slot_t *slot = map_lookup(map, key, len, strix_hash64_bytes(key, len, map->seed));
+    return slot ? &slot->value : NULL;
+}
+
+uint64_t *strix_map_find(const strix_map_t *map, const strix_t *key)
+{
+    if (!key)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+    return strix_map_find_bytes(map, key->str, key->len);
+}
+
+bool strix_map_remove(strix_map_t *map, const strix_t *key)
+{
+    STRIX_STATS_OP(STRIX_OP_MAP_REMOVE, STRIX_STATS_LEN(key));
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!map || !key || (!key->str && key->len))
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    strix_map_slot_t *slot = map_lookup(map, key->str, key->len, strix_hash64_bytes(key->str, key->len, map->seed));
+    if (!slot)
+    {
+        return false;
+    }
+
+    // a lookup only passes over a slot inside a run of 16 full or deleted ones, if there is no such
+    // run around it the slot can become empty again instead of deleted
+    const size_t mask = map->capacity - 1;
+    const size_t index = (size_t)(slot - map->slots);
+    uint32_t empty_after = map_match_byte(map->ctrl + index, STRIX_MAP_EMPTY);
+    uint32_t empty_before = map_match_byte(map->ctrl + ((index - STRIX_MAP_GROUP) & mask), STRIX_MAP_EMPTY);
+    bool never_passed = empty_after && empty_before &&
+                        (size_t)(__builtin_ctz(empty_after) + __builtin_clz(empty_before << 16)) < STRIX_MAP_GROUP;
+
+    map_set_ctrl(map->ctrl, map->capacity, index, never_passed ? STRIX_MAP_EMPTY : STRIX_MAP_DELETED);
+    map->growth_left += never_passed;
+    map->size--;
+    return true;
+}
+
+bool strix_map_next(const strix_map_t *map, size_t *cursor, strix_t *key, uint64_t *value)
+{
+    if (!map || !cursor)
+    {
+        return false;
+    }
+
+    while (*cursor < map->capacity)
+    {
+        const size_t index = (*cursor)++;
+        if (map_is_full(map->ctrl[index]))
+        {
+            if (key)
+            {
+                key->str = (char *)map->slots[index].key;
+                key->len = map->slots[index].len;
+            }
+            if (value)
+            {
+                *value = map->slots[index].value;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool strix_map_add_arr(strix_map_t *map, const strix_arr_t *strix_arr)
+{
+    STRIX_STATS_OP(STRIX_OP_MAP_ADD_ARR, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!map || !strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    // the strings are hashed a few insertions early and their groups prefetched, so the cache misses
+    // of consecutive insertions overlap instead of queueing up
+    uint64_t hashes[STRIX_MAP_PREFETCH];
+    const size_t len = strix_arr->len;
+    for (size_t i = 0; i < len + STRIX_MAP_PREFETCH; i++)
+    {
+        if (i >= STRIX_MAP_PREFETCH)
+        {
+            const size_t at = i - STRIX_MAP_PREFETCH;
+            const strix_t *strix = strix_arr->strix_arr[at];
+            if (!strix || (!strix->str && strix->len))
+            {
+                strix_errno = STRIX_ERR_NULL_PTR;
+                return false;
+            }
+
+            bool inserted;
+            strix_map_slot_t *slot = map_insert(map, strix->str, strix->len, hashes[at % STRIX_MAP_PREFETCH], &inserted);
+            if (!slot)
+            {
+                return false;
+            }
+            slot->value++;
+        }
+
+        if (i < len)
+        {
+            const strix_t *ahead = strix_arr->strix_arr[i];
+            uint64_t hash = ahead && (ahead->str || !ahead->len) ? strix_hash64_bytes(ahead->str, ahead->len, map->seed) : 0;
+            if (map->capacity)
+            {
+                size_t pos = map_h1(hash, map->capacity - 1);
+                __builtin_prefetch(map->ctrl + pos);
+                __builtin_prefetch(map->slots + pos);
+            }
+            hashes[i % STRIX_MAP_PREFETCH] = hash;
+        }
+    }
+    return true;
+}
+
+strix_map_t *strix_map_from_arr(const strix_arr_t *strix_arr, strix_arena_t *key_arena)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return NULL;
+    }
+
+    strix_map_t *map = strix_map_create(0, key_arena);
+    if (!map)
+    {
+        return NULL;
+    }
+
+    if (!strix_map_add_arr(map, strix_arr))
+    {
+        strix_error_t error = strix_errno;
+        strix_map_destroy(map);
+        strix_errno = error;
+        return NULL;
+    }
+    return map;
+}
+
+#undef STRIX_MAP_GROUP
+#undef STRIX_MAP_EMPTY
+#undef STRIX_MAP_DELETED
+#undef STRIX_MAP_MIN_CAPACITY
+#undef STRIX_MAP_PREFETCH
@@ -0,0 +1,534 @@
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../header/strix_parallel.h"
+#include "../allocator/allocator.h"
+#include "stats/stats.h"
+
+/*
+ * A call cuts the array into chunks of chunk_len elements and gives every thread of the job, the
+ * caller being thread 0, an equal share of the chunks as a range [begin, end) packed in one 64 bit
+ * word. A thread takes chunks from the front of its own range; once it is empty, it cuts the range
+ * of another thread in two and moves the back half to its own. Both are one compare and swap on
+ * the word of the range, so taking and stealing never hand out a chunk twice.
+ *
+ * Workers sleep on a condition variable between jobs. The caller publishes a job, works on it, then
+ * withdraws it and waits for the workers that joined to leave: a worker waking up after that finds
+ * no job, and the chunks of a thread that never joined have been stolen by the others.
+ */
+
+#define STRIX_PARALLEL_CHUNK_BYTES (64 * 1024)    // string data per chunk
+#define STRIX_PARALLEL_ELEMENT_BYTES (32)         // cost of an element besides its bytes
+#define STRIX_PARALLEL_CHUNKS_PER_THREAD (8)      // fewest chunks per thread of a job
+#define STRIX_PARALLEL_SAMPLES (64)               // elements whose length sets the chunk size
+#define STRIX_PARALLEL_MAX_CHUNKS ((size_t)1 << 31)
+#define STRIX_PARALLEL_RANGE_STRIDE (8)           // one range per cache line
+
+typedef struct parallel_job parallel_job_t;
+
+struct parallel_job
+{
+    void (*run)(parallel_job_t *job, size_t begin, size_t end, size_t chunk);
+    strix_arr_t *strix_arr;
+    size_t chunk_len;
+    size_t chunks;
+    uint64_t *ranges;
+    size_t threads;
+    bool failed;
+    void *arg;
+    strix_parallel_map_fn map;
+    strix_parallel_predicate_fn predicate;
+    strix_parallel_value_fn value;
+    strix_parallel_combine_fn combine;
+    uint64_t identity;
+    uint64_t *results; // one per chunk
+    uint8_t *keep;     // one per element
+    size_t count;
+    const strix_allocator_t *allocator; // installed on the caller, workers use it too
+};
+
+typedef struct
+{
+    strix_thread_pool_t *pool;
+    size_t index; // index of the worker in a job, from 1
+    pthread_t thread;
+} parallel_worker_t;
+
+struct strix_thread_pool
+{
+    size_t threads;
+    parallel_worker_t *workers;
+    uint64_t *ranges;       // STRIX_PARALLEL_RANGE_STRIDE words per thread of a job
+    pthread_mutex_t run;    // held by the caller of the current job
+    pthread_mutex_t lock;   // guards the fields below
+    pthread_cond_t wake;    // workers wait for a job
+    pthread_cond_t done;    // the caller waits for the workers to leave
+    parallel_job_t *job;
+    uint64_t generation;    // number of jobs published
+    size_t active;          // workers in the current job
+    bool stop;
+};
+
+static _Thread_local strix_thread_pool_t *parallel_current = NULL; // pool whose job this thread is running, if any
+static strix_thread_pool_t *parallel_default = NULL;
+static pthread_once_t parallel_default_once = PTHREAD_ONCE_INIT;
+
+/* ranges of chunks */
+
+static inline uint64_t parallel_range(size_t begin, size_t end)
+{
+    return (uint64_t)begin << 32 | (uint64_t)end;
+}
+
+static bool parallel_take(uint64_t *range, size_t *chunk)
+{
+    uint64_t current = __atomic_load_n(range, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        size_t begin = (size_t)(current >> 32);
+        size_t end = (size_t)(current & 0xFFFFFFFF);
+        if (begin >= end)
+        {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(range, &current, parallel_range(begin + 1, end), true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            *chunk = begin;
+            return true;
+        }
+    }
+}
+
+static bool parallel_steal(parallel_job_t *job, size_t self, size_t *chunk)
+{
+    for (size_t i = 1; i < job->threads; i++)
+    {
+        uint64_t *victim = &job->ranges[((self + i) % job->threads) * STRIX_PARALLEL_RANGE_STRIDE];
+        uint64_t current = __atomic_load_n(victim, __ATOMIC_RELAXED);
+        for (;;)
+        {
+            size_t begin = (size_t)(current >> 32);
+            size_t end = (size_t)(current & 0xFFFFFFFF);
+            if (begin >= end)
+            {
+                break;
+            }
+
+            size_t middle = begin + (end - begin) / 2;
+            if (__atomic_compare_exchange_n(victim, &current, parallel_range(begin, middle), true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            {
+                __atomic_store_n(&job->ranges[self * STRIX_PARALLEL_RANGE_STRIDE], parallel_range(middle + 1, end), __ATOMIC_RELEASE);
+                *chunk = middle;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void parallel_work(parallel_job_t *job, size_t self)
+{
+    size_t len = job->strix_arr->len;
+    size_t chunk;
+    while (parallel_take(&job->ranges[self * STRIX_PARALLEL_RANGE_STRIDE], &chunk) || parallel_steal(job, self, &chunk))
+    {
+        size_t begin = chunk * job->chunk_len;
+        size_t end = len - begin < job->chunk_len ? len : begin + job->chunk_len;
+        job->run(job, begin, end, chunk);
+    }
+}
+
+/* pool */
+
+static void *parallel_worker(void *arg)
+{
+    parallel_worker_t *worker = (parallel_worker_t *)arg;
+    strix_thread_pool_t *pool = worker->pool;
+    parallel_current = pool;
+
+    uint64_t seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->stop && pool->generation == seen)
+        {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->stop)
+        {
+            break;
+        }
+
+        seen = pool->generation;
+        parallel_job_t *job = pool->job;
+        if (!job)
+        {
+            continue; // woke up after the job was over
+        }
+
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+        // memory handed out to the callbacks is resized and freed by the caller's allocator later
+        allocator_installed = job->allocator;
+        parallel_work(job, worker->index);
+        allocator_installed = NULL;
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+        {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static void parallel_stop(strix_thread_pool_t *pool, size_t started)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < started; i++)
+    {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run);
+    unscoped_deallocate(pool->ranges);
+    unscoped_deallocate(pool->workers);
+    unscoped_deallocate(pool);
+}
+
+strix_thread_pool_t *strix_thread_pool_create(size_t threads)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 1 ? (size_t)online - 1 : 0;
+    }
+    if (threads >= SIZE_MAX / sizeof(uint64_t) / STRIX_PARALLEL_RANGE_STRIDE)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    strix_thread_pool_t *pool = (strix_thread_pool_t *)unscoped_allocate(sizeof(strix_thread_pool_t));
+    if (!pool)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    pool->workers = (parallel_worker_t *)unscoped_allocate(sizeof(parallel_worker_t) * (threads ? threads : 1));
+    pool->ranges = (uint64_t *)unscoped_allocate(sizeof(uint64_t) * STRIX_PARALLEL_RANGE_STRIDE * (threads + 1));
+    if (!pool->workers || !pool->ranges)
+    {
+        unscoped_deallocate(pool->ranges);
+        unscoped_deallocate(pool->workers);
+        unscoped_deallocate(pool);
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    pool->threads = threads;
+    pool->job = NULL;
+    pool->generation = 0;
+    pool->active = 0;
+    pool->stop = false;
+    pthread_mutex_init(&pool->run, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i + 1;
+        if (pthread_create(&pool->workers[i].thread, NULL, parallel_worker, &pool->workers[i]) != 0)
+        {
+            parallel_stop(pool, i);
+            strix_errno = STRIX_ERR_MALLOC_FAILED;
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+void strix_thread_pool_destroy(strix_thread_pool_t *pool)
+{
+    if (!pool || pool == parallel_default)
+    {
+        return;
+    }
+
+    parallel_stop(pool, pool->threads);
+}
+
+static void parallel_default_create(void)
+{
+    parallel_default = strix_thread_pool_create(0);
+}
+
+// the default pool lives until the process exits, NULL if it could not be started
+static strix_thread_pool_t *parallel_pool(strix_thread_pool_t *pool)
+{
+    if (pool)
+    {
+        return pool;
+    }
+
+    strix_error_t error = strix_errno;
+    pthread_once(&parallel_default_once, parallel_default_create);
+    strix_errno = error;
+    return parallel_default;
+}
+
+size_t strix_thread_pool_threads(const strix_thread_pool_t *pool)
+{
+    pool = parallel_pool((strix_thread_pool_t *)pool);
+    return pool ? pool->threads : 0;
+}
+
+/* jobs */
+
+// chunks of about STRIX_PARALLEL_CHUNK_BYTES, judged by the lengths of evenly spread elements
+static size_t parallel_chunk_len(const strix_arr_t *strix_arr, size_t threads)
+{
+    size_t len = strix_arr->len;
+    size_t samples = len < STRIX_PARALLEL_SAMPLES ? len : STRIX_PARALLEL_SAMPLES;
+    size_t bytes = 0;
+    for (size_t i = 0; i < samples; i++)
+    {
+        const strix_t *strix = strix_arr->strix_arr[i * (len / samples)];
+        bytes += (strix ? strix->len : 0) + STRIX_PARALLEL_ELEMENT_BYTES;
+    }
+
+    size_t chunk_len = STRIX_PARALLEL_CHUNK_BYTES / (bytes / samples);
+    size_t most = len / (threads * STRIX_PARALLEL_CHUNKS_PER_THREAD);
+    chunk_len = chunk_len < len && chunk_len > most ? most : chunk_len;
+    chunk_len = chunk_len ? chunk_len : 1;
+    return len / chunk_len >= STRIX_PARALLEL_MAX_CHUNKS ? len / STRIX_PARALLEL_MAX_CHUNKS + 1 : chunk_len;
+}
+
+static void parallel_run(strix_thread_pool_t *pool, parallel_job_t *job)
+{
+    size_t len = job->strix_arr->len;
+    if (len == 0)
+    {
+        return;
+    }
+
+    // a call from inside a job runs on its own thread whichever pool it names: the same pool would wait
+    // for itself, and the workers of another one may be waiting in outer calls on this one
+    bool inline_only = !pool || pool->threads == 0 || parallel_current;
+    job->chunk_len = inline_only ? len : parallel_chunk_len(job->strix_arr, pool->threads + 1);
+    job->chunks = (len - 1) / job->chunk_len + 1;
+
+    // workers have no arena scope, so the callbacks on this thread run without the caller's either
+    allocator_scope_t *scope = allocator_scope;
+    allocator_scope = NULL;
+    if (job->chunks == 1)
+    {
+        job->run(job, 0, len, 0);
+        allocator_scope = scope;
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run);
+    job->allocator = allocator_installed;
+    job->threads = pool->threads + 1;
+    job->ranges = pool->ranges;
+    for (size_t i = 0; i < job->threads; i++)
+    {
+        job->ranges[i * STRIX_PARALLEL_RANGE_STRIDE] = parallel_range(job->chunks * i / job->threads, job->chunks * (i + 1) / job->threads);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = job;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    strix_thread_pool_t *outer = parallel_current;
+    parallel_current = pool;
+    parallel_work(job, 0);
+    parallel_current = outer;
+    allocator_scope = scope;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->job = NULL;
+    while (pool->active)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    pthread_mutex_unlock(&pool->run);
+}
+
+static void parallel_run_map(parallel_job_t *job, size_t begin, size_t end, size_t chunk)
+{
+    (void)chunk;
+    for (size_t i = begin; i < end && !__atomic_load_n(&job->failed, __ATOMIC_RELAXED); i++)
+    {
+        if (!job->map(job->strix_arr->strix_arr[i], i, job->arg))
+        {
+            __atomic_store_n(&job->failed, true, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void parallel_run_filter(parallel_job_t *job, size_t begin, size_t end, size_t chunk)
+{
+    (void)chunk;
+    for (size_t i = begin; i < end; i++)
+    {
+        job->keep[i] = job->predicate(job->strix_arr->strix_arr[i], job->arg);
+    }
+}
+
+static void parallel_run_reduce(parallel_job_t *job, size_t begin, size_t end, size_t chunk)
+{
+    uint64_t result = job->identity;
+    for (size_t i = begin; i < end; i++)
+    {
+        result = job->combine(result, job->value(job->strix_arr->strix_arr[i], i, job->arg), job->arg);
+    }
+    job->results[chunk] = result;
+}
+
+static void parallel_run_count(parallel_job_t *job, size_t begin, size_t end, size_t chunk)
+{
+    (void)chunk;
+    size_t count = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        count += job->predicate(job->strix_arr->strix_arr[i], job->arg);
+    }
+    __atomic_fetch_add(&job->count, count, __ATOMIC_RELAXED);
+}
+
+bool strix_arr_parallel_map(strix_thread_pool_t *pool, strix_arr_t *strix_arr, strix_parallel_map_fn fn, void *arg)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_PARALLEL_MAP, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr || !fn)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    parallel_job_t job = {.run = parallel_run_map, .strix_arr = strix_arr, .map = fn, .arg = arg};
+    parallel_run(parallel_pool(pool), &job);
+    return !job.failed;
+}
+
+size_t strix_arr_parallel_filter(strix_thread_pool_t *pool, strix_arr_t *strix_arr, strix_parallel_predicate_fn keep, void *arg)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_PARALLEL_FILTER, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr || !keep)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+
+    parallel_job_t job = {.run = parallel_run_filter, .strix_arr = strix_arr, .predicate = keep, .arg = arg};
+    job.keep = (uint8_t *)unscoped_allocate(strix_arr->len ? strix_arr->len : 1);
+    if (!job.keep)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return 0;
+    }
+
+    parallel_run(parallel_pool(pool), &job);
+
+    size_t kept = 0;
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        if (job.keep[i])
+        {
+            strix_arr->strix_arr[kept++] = strix_arr->strix_arr[i];
+        }
+        else
+        {
+            strix_free(strix_arr->strix_arr[i]);
+        }
+    }
+
+    unscoped_deallocate(job.keep);
+    strix_arr->len = kept;
+    return kept;
+}
+
+uint64_t strix_arr_parallel_reduce(strix_thread_pool_t *pool, const strix_arr_t *strix_arr, strix_parallel_value_fn value,
+                                   strix_parallel_combine_fn combine, uint64_t identity, void *arg)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_PARALLEL_REDUCE, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr || !value || !combine)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return identity;
+    }
+
+    // a chunk per element at most, so the results fit whatever chunk size the job picks
+    parallel_job_t job = {.run = parallel_run_reduce, .strix_arr = (strix_arr_t *)strix_arr, .value = value,
+                          .combine = combine, .identity = identity, .arg = arg};
+    size_t results = strix_arr->len < STRIX_PARALLEL_MAX_CHUNKS ? strix_arr->len : STRIX_PARALLEL_MAX_CHUNKS;
+    job.results = (uint64_t *)unscoped_allocate(sizeof(uint64_t) * (results ? results : 1));
+    if (!job.results)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return identity;
+    }
+
+    parallel_run(parallel_pool(pool), &job);
+
+    uint64_t result = identity;
+    for (size_t i = 0; i < job.chunks; i++)
+    {
+        result = combine(result, job.results[i], arg);
+    }
+
+    unscoped_deallocate(job.results);
+    return result;
+}
+
+size_t strix_arr_parallel_count(strix_thread_pool_t *pool, const strix_arr_t *strix_arr, strix_parallel_predicate_fn predicate,
+                                void *arg)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_PARALLEL_COUNT, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr || !predicate)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+
+    parallel_job_t job = {.run = parallel_run_count, .strix_arr = (strix_arr_t *)strix_arr, .predicate = predicate, .arg = arg};
+    parallel_run(parallel_pool(pool), &job);
+    return job.count;
+}
+
+#undef STRIX_PARALLEL_CHUNK_BYTES
+#undef STRIX_PARALLEL_ELEMENT_BYTES
+#undef STRIX_PARALLEL_CHUNKS_PER_THREAD
+#undef STRIX_PARALLEL_SAMPLES
+#undef STRIX_PARALLEL_MAX_CHUNKS
+#undef STRIX_PARALLEL_RANGE_STRIDE
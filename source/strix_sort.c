@@ -0,0 +1,465 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../header/strix_sort.h"
+#include "../allocator/allocator.h"
+#include "kernels/kernels.h"
+#include "stats/stats.h"
+
+/*
+ * Every string is represented by an entry holding its key: the next 7 bytes of the string from the
+ * current depth, big-endian and zero padded, then a byte counting how many of them the string has.
+ * Keys order exactly like the strings they start, and equal keys mean either equal strings (a count
+ * under 7) or strings to be told apart 7 bytes further on, where the keys are loaded again.
+ *
+ * Large ranges are split by one byte of the key at a time, MSD radix style: entries are counted
+ * into 257 buckets, strings that end before the byte first, and copied through a buffer, which
+ * keeps equal strings in order. Ranges of at most STRIX_SORT_RADIX_MIN entries go to a multikey
+ * quicksort, whose stable mode breaks the final ties by position. The parallel sort hands large
+ * buckets to new threads as long as some are spare.
+ */
+
+#define STRIX_SORT_KEY_BYTES (7)
+#define STRIX_SORT_BUCKETS (257)
+#define STRIX_SORT_RADIX_MIN (256)         // ranges this small are quicksorted
+#define STRIX_SORT_INSERTION (16)          // and ranges this small insertion sorted
+#define STRIX_SORT_PARALLEL_MIN (1 << 15) // smallest range handed to another thread
+#define STRIX_SORT_TASKS (8)              // ranges a call hands out before it sorts the rest itself
+
+typedef struct
+{
+    uint64_t key;
+    strix_t *strix;
+    size_t index; // position before sorting
+} sort_entry_t;
+
+typedef struct
+{
+    bool stable;
+    size_t spare_threads; // threads that may still be started
+} sort_context_t;
+
+typedef struct
+{
+    sort_context_t *context;
+    sort_entry_t *entries;
+    sort_entry_t *buffer;
+    size_t len;
+    size_t depth;
+    size_t byte;
+    pthread_t thread;
+} sort_task_t;
+
+static inline uint64_t sort_key(const strix_t *strix, size_t depth)
+{
+    size_t rest = strix->len > depth ? strix->len - depth : 0;
+    if (rest > STRIX_SORT_KEY_BYTES)
+    {
+        uint64_t word;
+        memcpy(&word, strix->str + depth, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return (word & ~(uint64_t)0xFF) | STRIX_SORT_KEY_BYTES;
+    }
+
+    uint64_t key = 0;
+    for (size_t i = 0; i < rest; i++)
+    {
+        key |= (uint64_t)(uint8_t)strix->str[depth + i] << (56 - 8 * i);
+    }
+    return key | rest;
+}
+
+// bucket 0 holds the strings that end before the byte, the others the value of the byte plus 1
+static inline size_t sort_bucket(uint64_t key, size_t byte)
+{
+    return (key & 0xFF) > byte ? 1 + (size_t)((key >> (56 - 8 * byte)) & 0xFF) : 0;
+}
+
+/* multikey quicksort */
+
+static inline void sort_swap(sort_entry_t *one, sort_entry_t *two)
+{
+    sort_entry_t swap = *one;
+    *one = *two;
+    *two = swap;
+}
+
+static int sort_compare(const sort_entry_t *one, const sort_entry_t *two, size_t depth, bool stable)
+{
+    if (one->key != two->key)
+    {
+        return one->key < two->key ? -1 : 1;
+    }
+
+    if ((one->key & 0xFF) == STRIX_SORT_KEY_BYTES)
+    {
+        depth += STRIX_SORT_KEY_BYTES;
+        size_t len_one = one->strix->len - depth;
+        size_t len_two = two->strix->len - depth;
+        size_t len = len_one < len_two ? len_one : len_two;
+        size_t diff = len ? strix_kernels->mismatch(one->strix->str + depth, two->strix->str + depth, len) : 0;
+        if (diff < len)
+        {
+            return (unsigned char)one->strix->str[depth + diff] < (unsigned char)two->strix->str[depth + diff] ? -1 : 1;
+        }
+        if (len_one != len_two)
+        {
+            return len_one < len_two ? -1 : 1;
+        }
+    }
+
+    return stable ? (one->index > two->index) - (one->index < two->index) : 0;
+}
+
+static void sort_insertion(sort_entry_t *entries, size_t len, size_t depth, bool stable)
+{
+    for (size_t i = 1; i < len; i++)
+    {
+        sort_entry_t entry = entries[i];
+        size_t j = i;
+        for (; j > 0 && sort_compare(&entry, &entries[j - 1], depth, stable) < 0; j--)
+        {
+            entries[j] = entries[j - 1];
+        }
+        entries[j] = entry;
+    }
+}
+
+static int sort_by_index(const void *one, const void *two)
+{
+    size_t index_one = ((const sort_entry_t *)one)->index;
+    size_t index_two = ((const sort_entry_t *)two)->index;
+    return (index_one > index_two) - (index_one < index_two);
+}
+
+static inline uint64_t sort_median(uint64_t one, uint64_t two, uint64_t three)
+{
+    if (one > two)
+    {
+        uint64_t swap = one;
+        one = two;
+        two = swap;
+    }
+    return three <= one ? one : three >= two ? two : three;
+}
+
+static void sort_quick(sort_entry_t *entries, size_t len, size_t depth, bool stable)
+{
+    while (len > STRIX_SORT_INSERTION)
+    {
+        const uint64_t pivot = sort_median(entries[0].key, entries[len / 2].key, entries[len - 1].key);
+        size_t below = 0;
+        size_t above = len;
+        for (size_t i = 0; i < above;)
+        {
+            if (entries[i].key < pivot)
+            {
+                sort_swap(&entries[below++], &entries[i++]);
+            }
+            else if (entries[i].key > pivot)
+            {
+                sort_swap(&entries[i], &entries[--above]);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        sort_quick(entries, below, depth, stable);
+        sort_quick(entries + above, len - above, depth, stable);
+        entries += below;
+        len = above - below;
+
+        if ((pivot & 0xFF) < STRIX_SORT_KEY_BYTES)
+        {
+            // the strings are equal, only the stable mode still has to order them
+            if (stable && len > 1)
+            {
+                qsort(entries, len, sizeof(sort_entry_t), sort_by_index);
+            }
+            return;
+        }
+
+        depth += STRIX_SORT_KEY_BYTES;
+        for (size_t i = 0; i < len; i++)
+        {
+            entries[i].key = sort_key(entries[i].strix, depth);
+        }
+    }
+
+    sort_insertion(entries, len, depth, stable);
+}
+
+/* MSD radix */
+
+static bool sort_take_thread(sort_context_t *context)
+{
+    size_t spare = __atomic_load_n(&context->spare_threads, __ATOMIC_RELAXED);
+    while (spare)
+    {
+        if (__atomic_compare_exchange_n(&context->spare_threads, &spare, spare - 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sort_radix(sort_context_t *context, sort_entry_t *entries, sort_entry_t *buffer, size_t len, size_t depth, size_t byte);
+
+static void *sort_thread(void *arg)
+{
+    sort_task_t *task = (sort_task_t *)arg;
+    sort_radix(task->context, task->entries, task->buffer, task->len, task->depth, task->byte);
+    __atomic_fetch_add(&task->context->spare_threads, 1, __ATOMIC_RELAXED);
+    return NULL;
+}
+
+// sorts a bucket on another thread if it is large and one is spare, here otherwise
+static void sort_bucket_range(sort_context_t *context, sort_task_t *tasks, size_t *task_count, sort_entry_t *entries,
+                              sort_entry_t *buffer, size_t len, size_t depth, size_t byte)
+{
+    if (len >= STRIX_SORT_PARALLEL_MIN && *task_count < STRIX_SORT_TASKS && sort_take_thread(context))
+    {
+        sort_task_t *task = &tasks[*task_count];
+        task->context = context;
+        task->entries = entries;
+        task->buffer = buffer;
+        task->len = len;
+        task->depth = depth;
+        task->byte = byte;
+        if (pthread_create(&task->thread, NULL, sort_thread, task) == 0)
+        {
+            (*task_count)++;
+            return;
+        }
+        __atomic_fetch_add(&context->spare_threads, 1, __ATOMIC_RELAXED);
+    }
+
+    sort_radix(context, entries, buffer, len, depth, byte);
+}
+
+// the largest bucket is sorted by the loop itself, so the recursion is at most log2(len) deep
+static void sort_radix(sort_context_t *context, sort_entry_t *entries, sort_entry_t *buffer, size_t len, size_t depth, size_t byte)
+{
+    sort_task_t tasks[STRIX_SORT_TASKS];
+    size_t task_count = 0;
+
+    while (len > STRIX_SORT_RADIX_MIN)
+    {
+        if (byte == STRIX_SORT_KEY_BYTES)
+        {
+            depth += STRIX_SORT_KEY_BYTES;
+            byte = 0;
+            for (size_t i = 0; i < len; i++)
+            {
+                entries[i].key = sort_key(entries[i].strix, depth);
+            }
+        }
+
+        size_t counts[STRIX_SORT_BUCKETS] = {0};
+        for (size_t i = 0; i < len; i++)
+        {
+            counts[sort_bucket(entries[i].key, byte)]++;
+        }
+
+        if (counts[0] == len)
+        {
+            // every string ended, they are equal and still in their original order
+            len = 0;
+            break;
+        }
+
+        size_t largest = 1;
+        for (size_t bucket = 2; bucket < STRIX_SORT_BUCKETS; bucket++)
+        {
+            largest = counts[bucket] > counts[largest] ? bucket : largest;
+        }
+        if (counts[largest] == len)
+        {
+            byte++; // a byte shared by all strings, nothing to move
+            continue;
+        }
+
+        size_t offsets[STRIX_SORT_BUCKETS];
+        for (size_t bucket = 0, offset = 0; bucket < STRIX_SORT_BUCKETS; bucket++)
+        {
+            offsets[bucket] = offset;
+            offset += counts[bucket];
+        }
+        for (size_t i = 0; i < len; i++)
+        {
+            buffer[offsets[sort_bucket(entries[i].key, byte)]++] = entries[i];
+        }
+        memcpy(entries, buffer, len * sizeof(sort_entry_t));
+
+        // bucket 0 holds equal strings in their original order, offsets now point at bucket ends
+        for (size_t bucket = 1; bucket < STRIX_SORT_BUCKETS; bucket++)
+        {
+            size_t start = offsets[bucket] - counts[bucket];
+            if (bucket != largest && counts[bucket] > 1)
+            {
+                sort_bucket_range(context, tasks, &task_count, entries + start, buffer + start, counts[bucket], depth, byte + 1);
+            }
+        }
+
+        size_t start = offsets[largest] - counts[largest];
+        entries += start;
+        buffer += start;
+        len = counts[largest];
+        byte++;
+    }
+
+    if (len > 1)
+    {
+        sort_quick(entries, len, depth, context->stable);
+    }
+
+    for (size_t i = 0; i < task_count; i++)
+    {
+        pthread_join(tasks[i].thread, NULL);
+    }
+}
+
+static sort_entry_t *sort_entries_new(const strix_arr_t *strix_arr)
+{
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        const strix_t *strix = strix_arr->strix_arr[i];
+        if (!strix || (!strix->str && strix->len))
+        {
+            strix_errno = STRIX_ERR_NULL_PTR;
+            return NULL;
+        }
+    }
+
+    if (strix_arr->len > SIZE_MAX / 2 / sizeof(sort_entry_t))
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    // the second half is the buffer of the radix passes
+    sort_entry_t *entries = (sort_entry_t *)unscoped_allocate(2 * sizeof(sort_entry_t) * (strix_arr->len ? strix_arr->len : 1));
+    if (!entries)
+    {
+        strix_errno = STRIX_ERR_MALLOC_FAILED;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        entries[i].key = sort_key(strix_arr->strix_arr[i], 0);
+        entries[i].strix = strix_arr->strix_arr[i];
+        entries[i].index = i;
+    }
+    return entries;
+}
+
+static bool sort_arr(strix_arr_t *strix_arr, strix_sort_mode_t mode, size_t threads)
+{
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return false;
+    }
+
+    sort_entry_t *entries = sort_entries_new(strix_arr);
+    if (!entries)
+    {
+        return false;
+    }
+
+    sort_context_t context = {mode == STRIX_SORT_STABLE, threads - 1};
+    sort_radix(&context, entries, entries + strix_arr->len, strix_arr->len, 0, 0);
+
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        strix_arr->strix_arr[i] = entries[i].strix;
+    }
+
+    unscoped_deallocate(entries);
+    return true;
+}
+
+bool strix_arr_sort(strix_arr_t *strix_arr, strix_sort_mode_t mode)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_SORT, 0);
+
+    return sort_arr(strix_arr, mode, 1);
+}
+
+bool strix_arr_sort_parallel(strix_arr_t *strix_arr, strix_sort_mode_t mode, size_t threads)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_SORT_PARALLEL, 0);
+
+    if (threads == 0)
+    {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+    return sort_arr(strix_arr, mode, threads);
+}
+
+size_t strix_arr_unique(strix_arr_t *strix_arr)
+{
+    STRIX_STATS_OP(STRIX_OP_ARR_UNIQUE, 0);
+
+    strix_errno = STRIX_SUCCESS;
+
+    if (!strix_arr)
+    {
+        strix_errno = STRIX_ERR_NULL_PTR;
+        return 0;
+    }
+
+    for (size_t i = 0; i < strix_arr->len; i++)
+    {
+        const strix_t *strix = strix_arr->strix_arr[i];
+        if (!strix || (!strix->str && strix->len))
+        {
+            strix_errno = STRIX_ERR_NULL_PTR;
+            return 0;
+        }
+    }
+
+    if (strix_arr->len < 2)
+    {
+        return strix_arr->len;
+    }
+
+    size_t kept = 1;
+    for (size_t i = 1; i < strix_arr->len; i++)
+    {
+        strix_t *last = strix_arr->strix_arr[kept - 1];
+        strix_t *strix = strix_arr->strix_arr[i];
+        if (strix != last && (strix->len != last->len || (strix->len && strix_kernels->mismatch(strix->str, last->str, strix->len) != strix->len)))
+        {
+            strix_arr->strix_arr[kept++] = strix;
+            continue;
+        }
+
+        if (strix != last)
+        {
+            strix_free(strix);
+        }
+    }
+
+    strix_arr->len = kept;
+    return kept;
+}
+
+#undef STRIX_SORT_KEY_BYTES
+#undef STRIX_SORT_BUCKETS
+#undef STRIX_SORT_RADIX_MIN
+#undef STRIX_SORT_INSERTION
+#undef STRIX_SORT_PARALLEL_MIN
+#undef STRIX_SORT_TASKS
@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "../header/strix_stats.h"
+#include "stats/stats.h"
+
+// indexed by strix_op_t
+static const char *const strix_op_names[STRIX_OP_COUNT] = {
+    "strix_create_empty",
+    "strix_to_cstr",
+    "strix_create",
+    "strix_duplicate",
+    "strix_modify",
+    "strix_free",
+    "strix_clear",
+    "strix_concat",
+    "strix_append",
+    "strix_insert_str",
+    "strix_insert",
+    "strix_erase",
+    "strix_at",
+    "strix_equal",
+    "strix_compare",
+    "strix_equal_fast",
+    "strix_find",
+    "strix_find_all",
+    "strix_find_subtrix",
+    "strix_find_subtrix_all",
+    "strix_position_free",
+    "strix_free_strix_arr",
+    "strix_slice",
+    "strix_split_by_delim",
+    "strix_split_by_substr",
+    "strix_split_by_substrix",
+    "strix_join_via_delim",
+    "strix_join_via_substr",
+    "strix_join_via_substrix",
+    "strix_trim_whitespace",
+    "strix_trim_char",
+    "strix_to_double",
+    "strix_to_unsigned_int",
+    "strix_to_signed_int",
+    "strix_count_char",
+    "strix_count_substr",
+    "strix_count_substrix",
+    "strix_slice_by_stride",
+    "strix_find_unique_char",
+    "strix_delete_occurence",
+    "strix_free_char_arr",
+    "strix_find_all_char",
+    "conv_file_to_strix",
+    "strix_free_position",
+    "kmp_search",
+    "kmp_search_all",
+    "kmp_search_all_len",
+    "substr_search",
+    "substr_search_all",
+    "substr_search_all_len",
+    "strix_hash64",
+    "strix_hash128",
+    "strix_map_upsert",
+    "strix_map_find",
+    "strix_map_remove",
+    "strix_map_add_arr",
+    "strix_intern",
+    "strix_intern_find",
+    "strix_arr_sort",
+    "strix_arr_sort_parallel",
+    "strix_arr_unique",
+    "strix_arr_parallel_map",
+    "strix_arr_parallel_filter",
+    "strix_arr_parallel_reduce",
+    "strix_arr_parallel_count",
+};
+
+const char *strix_stats_op_name(strix_op_t op)
+{
+    return (unsigned)op < STRIX_OP_COUNT ? strix_op_names[op] : "unknown";
+}
+
+static uint64_t bucket_upper_bound(size_t bucket)
+{
+    if (bucket < (1u << STRIX_STATS_SUB_BUCKET_BITS))
+    {
+        return bucket;
+    }
+    if (bucket == STRIX_STATS_BUCKETS - 1)
+    {
+        return UINT64_MAX;
+    }
+
+    unsigned shift = (unsigned)(bucket >> STRIX_STATS_SUB_BUCKET_BITS) - 1;
+    uint64_t sub = bucket & ((1u << STRIX_STATS_SUB_BUCKET_BITS) - 1);
+    return (((1u << STRIX_STATS_SUB_BUCKET_BITS) + sub + 1) << shift) - 1;
+}
+
+uint64_t strix_stats_percentile(const strix_op_stats_t *op, double percentile)
+{
+    if (!op || !op->samples)
+    {
+        return 0;
+    }
+
+    uint64_t total = 0;
+    for (size_t bucket = 0; bucket < STRIX_STATS_BUCKETS; bucket++)
+    {
+        total += op->histogram[bucket];
+    }
+
+    double share = percentile < 0 ? 0 : percentile > 100 ? 100 : percentile;
+    uint64_t rank = (uint64_t)(share / 100 * (double)total + 0.5);
+    rank = rank ? (rank > total ? total : rank) : 1;
+
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < STRIX_STATS_BUCKETS; bucket++)
+    {
+        seen += op->histogram[bucket];
+        if (seen >= rank)
+        {
+            uint64_t bound = bucket_upper_bound(bucket);
+            return bound < op->max_ns ? bound : op->max_ns;
+        }
+    }
+    return op->max_ns;
+}
+
+static void print_ns(FILE *stream, uint64_t ns)
+{
+    if (ns < 10000)
+    {
+        fprintf(stream, " %8lluns", (unsigned long long)ns);
+    }
+    else if (ns < 10000000)
+    {
+        fprintf(stream, " %8.1fus", (double)ns / 1e3);
+    }
+    else
+    {
+        fprintf(stream, " %8.1fms", (double)ns / 1e6);
+    }
+}
+
+void strix_stats_dump(FILE *stream)
+{
+    strix_stats_t *stats = malloc(sizeof(strix_stats_t));
+    if (!stream || !stats)
+    {
+        free(stats);
+        return;
+    }
+
+    strix_stats_snapshot(stats);
+    fprintf(stream, "%-24s %12s %14s %10s %10s %10s %10s %10s\n", "operation", "calls", "bytes", "mean", "p50", "p99",
+            "p99.9", "max");
+    for (strix_op_t op = 0; op < STRIX_OP_COUNT; op++)
+    {
+        const strix_op_stats_t *counters = &stats->ops[op];
+        if (!counters->calls)
+        {
+            continue;
+        }
+
+        fprintf(stream, "%-24s %12llu %14llu", strix_op_names[op], (unsigned long long)counters->calls,
+                (unsigned long long)counters->bytes);
+        if (!counters->samples)
+        {
+            fprintf(stream, " %10s %10s %10s %10s %10s\n", "-", "-", "-", "-", "-"); // no call was measured
+            continue;
+        }
+
+        print_ns(stream, counters->sampled_ns / counters->samples);
+        print_ns(stream, strix_stats_percentile(counters, 50));
+        print_ns(stream, strix_stats_percentile(counters, 99));
+        print_ns(stream, strix_stats_percentile(counters, 99.9));
+        print_ns(stream, counters->max_ns);
+        fputc('\n', stream);
+    }
+    free(stats);
+}
+
+#ifdef STRIX_STATS
+
+#include <pthread.h>
+
+_Thread_local strix_thread_stats_t *strix_stats_thread __attribute__((tls_model("initial-exec"))) = NULL;
+uint32_t strix_stats_generation = 0;
+
+static uint32_t sample_rate = STRIX_STATS_DEFAULT_SAMPLE_RATE;
+
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER; // guards live_threads and exited_threads
+static strix_thread_stats_t *live_threads = NULL;
+static strix_stats_t exited_threads; // counters of the threads that exited since the last reset
+
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+
+static void add_counters(strix_op_stats_t *dest, const strix_op_stats_t *src)
+{
+    dest->calls += __atomic_load_n(&src->calls, __ATOMIC_RELAXED);
+    dest->bytes += __atomic_load_n(&src->bytes, __ATOMIC_RELAXED);
+    dest->samples += __atomic_load_n(&src->samples, __ATOMIC_RELAXED);
+    dest->sampled_ns += __atomic_load_n(&src->sampled_ns, __ATOMIC_RELAXED);
+
+    uint64_t max_ns = __atomic_load_n(&src->max_ns, __ATOMIC_RELAXED);
+    dest->max_ns = max_ns > dest->max_ns ? max_ns : dest->max_ns;
+
+    for (size_t bucket = 0; bucket < STRIX_STATS_BUCKETS; bucket++)
+    {
+        dest->histogram[bucket] += __atomic_load_n(&src->histogram[bucket], __ATOMIC_RELAXED);
+    }
+}
+
+// whether the counters of a thread count, the thread publishes its generation after zeroing them
+static bool is_current(const strix_thread_stats_t *thread)
+{
+    return __atomic_load_n(&thread->generation, __ATOMIC_ACQUIRE) ==
+           __atomic_load_n(&strix_stats_generation, __ATOMIC_RELAXED);
+}
+
+// folds the counters of an exiting thread into exited_threads
+static void thread_exit(void *data)
+{
+    strix_thread_stats_t *thread = data;
+
+    pthread_mutex_lock(&registry_lock);
+    if (is_current(thread))
+    {
+        for (strix_op_t op = 0; op < STRIX_OP_COUNT; op++)
+        {
+            add_counters(&exited_threads.ops[op], &thread->ops[op]);
+        }
+    }
+
+    if (thread->prev)
+    {
+        thread->prev->next = thread->next;
+    }
+    else
+    {
+        live_threads = thread->next;
+    }
+    if (thread->next)
+    {
+        thread->next->prev = thread->prev;
+    }
+    pthread_mutex_unlock(&registry_lock);
+
+    strix_stats_thread = NULL;
+    free(thread);
+}
+
+static void thread_key_create(void)
+{
+    pthread_key_create(&thread_key, thread_exit);
+}
+
+strix_thread_stats_t *strix_stats_register(void)
+{
+    pthread_once(&thread_key_once, thread_key_create);
+
+    strix_thread_stats_t *thread = calloc(1, sizeof(strix_thread_stats_t));
+    if (!thread)
+    {
+        return NULL; // the calls of this thread go uncounted until an allocation succeeds
+    }
+
+    thread->countdown = __atomic_load_n(&sample_rate, __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&registry_lock);
+    thread->generation = strix_stats_generation;
+    thread->next = live_threads;
+    if (live_threads)
+    {
+        live_threads->prev = thread;
+    }
+    live_threads = thread;
+    pthread_mutex_unlock(&registry_lock);
+
+    pthread_setspecific(thread_key, thread);
+    strix_stats_thread = thread;
+    return thread;
+}
+
+void strix_stats_restart(strix_thread_stats_t *thread)
+{
+    uint32_t generation = __atomic_load_n(&strix_stats_generation, __ATOMIC_RELAXED);
+    for (strix_op_t op = 0; op < STRIX_OP_COUNT; op++)
+    {
+        memset(&thread->ops[op], 0, sizeof(strix_op_stats_t));
+    }
+    __atomic_store_n(&thread->generation, generation, __ATOMIC_RELEASE);
+}
+
+static size_t latency_bucket(uint64_t ns)
+{
+    if (ns < (1u << STRIX_STATS_SUB_BUCKET_BITS))
+    {
+        return ns;
+    }
+
+    unsigned exponent = 63 - __builtin_clzll(ns);
+    if (exponent > STRIX_STATS_MAX_EXPONENT)
+    {
+        return STRIX_STATS_BUCKETS - 1;
+    }
+
+    unsigned shift = exponent - STRIX_STATS_SUB_BUCKET_BITS;
+    return ((size_t)(shift + 1) << STRIX_STATS_SUB_BUCKET_BITS) +
+           ((ns >> shift) & ((1u << STRIX_STATS_SUB_BUCKET_BITS) - 1));
+}
+
+void strix_stats_record(strix_stats_scope_t *scope)
+{
+    uint64_t ns = strix_stats_now_ns() - scope->start_ns;
+    strix_op_stats_t *counters = &scope->thread->ops[scope->op];
+
+    strix_stats_add(&counters->samples, 1);
+    strix_stats_add(&counters->sampled_ns, ns);
+    strix_stats_add(&counters->histogram[latency_bucket(ns)], 1);
+    if (ns > counters->max_ns)
+    {
+        __atomic_store_n(&counters->max_ns, ns, __ATOMIC_RELAXED);
+    }
+
+    scope->thread->countdown = __atomic_load_n(&sample_rate, __ATOMIC_RELAXED);
+}
+
+bool strix_stats_enabled(void)
+{
+    return true;
+}
+
+void strix_stats_snapshot(strix_stats_t *stats)
+{
+    if (!stats)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&registry_lock);
+    memcpy(stats, &exited_threads, sizeof(strix_stats_t));
+    for (strix_thread_stats_t *thread = live_threads; thread; thread = thread->next)
+    {
+        if (!is_current(thread))
+        {
+            continue; // not called since the reset, its counters are from before it
+        }
+
+        for (strix_op_t op = 0; op < STRIX_OP_COUNT; op++)
+        {
+            add_counters(&stats->ops[op], &thread->ops[op]);
+        }
+    }
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void strix_stats_reset(void)
+{
+    pthread_mutex_lock(&registry_lock);
+    memset(&exited_threads, 0, sizeof(strix_stats_t));
+    __atomic_add_fetch(&strix_stats_generation, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&registry_lock);
+
+    // the calling thread starts over at once, others on their next strix call
+    if (strix_stats_thread)
+    {
+        strix_stats_restart(strix_stats_thread);
+    }
+}
+
+void strix_stats_set_sample_rate(uint32_t every)
+{
+    __atomic_store_n(&sample_rate, every ? every : 1, __ATOMIC_RELAXED);
+}
+
+__attribute__((constructor)) static void strix_stats_init(void)
+{
+    const char *every = getenv("STRIX_STATS_SAMPLE_RATE");
+    if (every && *every)
+    {
+        strix_stats_set_sample_rate((uint32_t)strtoul(every, NULL, 10));
+    }
+}
+
+__attribute__((destructor)) static void strix_stats_exit(void)
+{
+    if (getenv("STRIX_STATS_DUMP"))
+    {
+        strix_stats_dump(stderr);
+    }
+}
+
+#else
+
+bool strix_stats_enabled(void)
+{
+    return false;
+}
+
+void strix_stats_snapshot(strix_stats_t *stats)
+{
+    if (stats)
+    {
+        memset(stats, 0, sizeof(strix_stats_t));
+    }
+}
+
+void strix_stats_reset(void)
+{
+}
+
+void strix_stats_set_sample_rate(uint32_t every)
+{
+    (void)every;
+}
+
+#endif // STRIX_STATS